@@ -0,0 +1,43 @@
+﻿#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/*
+ * グローバルなoperator new/deleteを置き換え、呼出回数を数える.
+ * nothrow版と配列版の既定の実装はこれらを呼び出す為、置き換えるのは通常版のみで良い.
+ * アライメント指定版(C++17)は数えない.
+ */
+
+namespace {
+	std::atomic<std::size_t> allocations(0);
+	std::atomic<std::size_t> deallocations(0);
+}
+
+namespace bench {
+
+AllocationCount allocationCount() {
+	AllocationCount count;
+	count.allocations = allocations.load(std::memory_order_relaxed);
+	count.deallocations = deallocations.load(std::memory_order_relaxed);
+	return count;
+}
+
+}	// namespace bench
+
+void *operator new(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if(void *p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+	if(!p) return;
+	deallocations.fetch_add(1, std::memory_order_relaxed);
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+	::operator delete(p);
+}
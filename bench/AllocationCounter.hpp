@@ -0,0 +1,63 @@
+﻿/**
+ * @file
+ * ベンチマーク中のヒープ確保回数の計測.
+ */
+#ifndef ASLIB_BENCH_ALLOCATIONCOUNTER_HPP_
+#define ASLIB_BENCH_ALLOCATIONCOUNTER_HPP_
+
+#include <cstddef>
+
+#include <benchmark/benchmark.h>
+
+namespace bench {
+
+/// これまでにグローバルなoperator new/deleteが呼ばれた回数. AllocationCounter.cppで置き換えたoperator new/deleteが数える.
+struct AllocationCount {
+	std::size_t allocations;
+	std::size_t deallocations;
+};
+
+/// @return	プロセス開始からの確保・解放回数.
+AllocationCount allocationCount();
+
+/**
+ * 生存期間中のヒープ確保・解放回数を、1回の操作当たりの値としてベンチマークのカウンタ(allocs/op, frees/op)へ記録する.
+ * 計測ループの直前に構築し、下準備の確保は数えないようにする.
+ * @code
+ *	ThisType src = makeSource();
+ *	bench::AllocationScope scope(state);
+ *	for(auto _ : state) { ThisType copy(src); }
+ * @endcode
+ */
+class AllocationScope {
+public:
+	/**
+	 * @param[in,out]	state	結果を記録するベンチマークの状態.
+	 * @param[in]	operationsPerIteration	1回の反復で行う操作の回数.
+	 */
+	explicit
+	AllocationScope(benchmark::State &state, std::size_t operationsPerIteration = 1)
+		: state_(state), operations_(operationsPerIteration), start_(allocationCount())
+	{ }
+
+	~AllocationScope() {
+		const AllocationCount end = allocationCount();
+		const double operations = static_cast<double>(state_.iterations()) * static_cast<double>(operations_);
+		if(operations == 0) return;
+
+		state_.counters["allocs/op"] = static_cast<double>(end.allocations - start_.allocations) / operations;
+		state_.counters["frees/op"] = static_cast<double>(end.deallocations - start_.deallocations) / operations;
+	}
+
+	AllocationScope(const AllocationScope &) = delete;
+	AllocationScope &operator=(const AllocationScope &) = delete;
+
+private:
+	benchmark::State &state_;
+	std::size_t operations_;
+	AllocationCount start_;
+};
+
+}	// namespace bench
+
+#endif	// ASLIB_BENCH_ALLOCATIONCOUNTER_HPP_
@@ -0,0 +1,181 @@
+﻿#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <aslib/CowPtr.hpp>
+#include <aslib/DeepCopyParallel.hpp>
+#include <aslib/DeepCopyPtr.hpp>
+
+#include "AllocationCounter.hpp"
+
+namespace {
+	struct Shape {
+		virtual ~Shape() {}
+		virtual int area() const = 0;
+	};
+
+	/// vptrを含めて、およそBytesバイトのオブジェクト.
+	template<std::size_t Bytes>
+	struct Blob : Shape {
+		Blob() { std::memset(data_, 1, sizeof(data_)); }
+		int area() const { return data_[0]; }
+		char data_[Bytes > sizeof(void *) ? Bytes - sizeof(void *) : 1];
+	};
+
+	/// オブジェクトプールを有効にしたBlob.
+	template<std::size_t Bytes>
+	struct PooledBlob : Blob<Bytes> {};
+}
+
+namespace aslib {
+	template<std::size_t Bytes> struct DeepCopyPoolTraits<PooledBlob<Bytes> > {
+		static const bool enabled = true;
+		static const std::size_t maxCached = 256;
+	};
+}
+
+namespace {
+	typedef aslib::DeepCopyPtr<Shape> HeapPtr;
+	typedef aslib::DeepCopyPtr<Shape, 64> InlinePtr;
+
+	/// 破棄の計測で、1回の反復当たりに破棄するオブジェクトの数.
+	const std::size_t batchSize = 256;
+
+	template<typename Ptr, typename Object>
+	Ptr makeSource() {
+		Ptr p;
+		p.template emplace<Object>();
+		return p;
+	}
+
+	/// コピーコンストラクタ. コピーしたオブジェクトの破棄を含む.
+	template<typename Ptr, typename Object>
+	void BM_DeepCopyPtr_Copy(benchmark::State &state) {
+		const Ptr src = makeSource<Ptr, Object>();
+		bench::AllocationScope scope(state);
+		for(auto _ : state) {
+			Ptr copy(src);
+			benchmark::DoNotOptimize(copy.get());
+		}
+	}
+
+	/// ムーブコンストラクタ. 往復させて元に戻す.
+	template<typename Ptr, typename Object>
+	void BM_DeepCopyPtr_Move(benchmark::State &state) {
+		Ptr src = makeSource<Ptr, Object>();
+		bench::AllocationScope scope(state);
+		for(auto _ : state) {
+			Ptr moved(std::move(src));
+			src = std::move(moved);
+			benchmark::DoNotOptimize(src.get());
+		}
+	}
+
+	/// 同じ動的型を指すDeepCopyPtrへのコピー代入. 既存のオブジェクトへの代入で済む.
+	template<typename Ptr, typename Object>
+	void BM_DeepCopyPtr_Assign(benchmark::State &state) {
+		const Ptr src = makeSource<Ptr, Object>();
+		Ptr dst = makeSource<Ptr, Object>();
+		bench::AllocationScope scope(state);
+		for(auto _ : state) {
+			dst = src;
+			benchmark::DoNotOptimize(dst.get());
+		}
+	}
+
+	/// 破棄. 計測外で用意したbatchSize個のコピーを破棄する.
+	template<typename Ptr, typename Object>
+	void BM_DeepCopyPtr_Destroy(benchmark::State &state) {
+		const Ptr src = makeSource<Ptr, Object>();
+		std::vector<Ptr> batch;
+		batch.reserve(batchSize);
+		for(auto _ : state) {
+			state.PauseTiming();
+			for(std::size_t i = 0; i < batchSize; ++i) batch.push_back(src);
+			const bench::AllocationCount before = bench::allocationCount();
+			state.ResumeTiming();
+
+			batch.clear();
+
+			state.PauseTiming();
+			state.counters["frees/op"] += static_cast<double>(bench::allocationCount().deallocations - before.deallocations) / batchSize;
+			state.ResumeTiming();
+		}
+		state.counters["frees/op"] /= static_cast<double>(state.iterations());
+		state.SetItemsProcessed(state.iterations() * batchSize);
+	}
+
+	/// 木の節. 子のDeepCopyPtrを標準コンテナの要素に持つ.
+	struct TreeNode {
+		explicit TreeNode(int value) : value_(value) {}
+		int value_;
+		std::vector<aslib::DeepCopyPtr<TreeNode> > children_;
+	};
+
+	/// 各節がwidth個の子を持つ、深さdepthの木.
+	aslib::DeepCopyPtr<TreeNode> makeTree(int depth, int width) {
+		aslib::DeepCopyPtr<TreeNode> node(new TreeNode(depth));
+		if(depth > 0) {
+			for(int i = 0; i < width; ++i) node->children_.push_back(makeTree(depth - 1, width));
+		}
+		return node;
+	}
+
+	/// 約35万節の木のコピー. コピーした木の破棄を含む.
+	void BM_DeepCopyPtr_TreeCopy(benchmark::State &state) {
+		const aslib::DeepCopyPtr<TreeNode> src = makeTree(9, 4);
+		for(auto _ : state) {
+			const aslib::DeepCopyPtr<TreeNode> copy(src);
+			benchmark::DoNotOptimize(copy.get());
+		}
+	}
+
+	/// deep_copyによる、state.range(0)個のスレッドでの木のコピー. スレッドの開始と、コピーした木の破棄を含む.
+	void BM_DeepCopyPtr_TreeParallelCopy(benchmark::State &state) {
+		const aslib::DeepCopyPtr<TreeNode> src = makeTree(9, 4);
+		for(auto _ : state) {
+			std::vector<std::thread> threads;
+			const aslib::DeepCopyPtr<TreeNode> copy = aslib::deep_copy(src, [&](std::function<void()> job) { threads.emplace_back(job); }, static_cast<std::size_t>(state.range(0)));
+			benchmark::DoNotOptimize(copy.get());
+			for(std::size_t i = 0; i < threads.size(); ++i) threads[i].join();
+		}
+	}
+
+	/// CowPtrのコピー. 最初の非constアクセスまでオブジェクトはコピーしない.
+	template<std::size_t Bytes>
+	void BM_CowPtr_Copy(benchmark::State &state) {
+		const aslib::CowPtr<Shape> src(new Blob<Bytes>());
+		bench::AllocationScope scope(state);
+		for(auto _ : state) {
+			const aslib::CowPtr<Shape> copy(src);
+			benchmark::DoNotOptimize(copy.get());
+		}
+	}
+}
+
+#define ASLIB_BENCH_DEEPCOPYPTR(Ptr, Object) \
+	BENCHMARK_TEMPLATE(BM_DeepCopyPtr_Copy, Ptr, Object); \
+	BENCHMARK_TEMPLATE(BM_DeepCopyPtr_Move, Ptr, Object); \
+	BENCHMARK_TEMPLATE(BM_DeepCopyPtr_Assign, Ptr, Object); \
+	BENCHMARK_TEMPLATE(BM_DeepCopyPtr_Destroy, Ptr, Object)
+
+ASLIB_BENCH_DEEPCOPYPTR(HeapPtr, Blob<16>);
+ASLIB_BENCH_DEEPCOPYPTR(HeapPtr, Blob<64>);
+ASLIB_BENCH_DEEPCOPYPTR(HeapPtr, Blob<256>);
+ASLIB_BENCH_DEEPCOPYPTR(HeapPtr, Blob<1024>);
+ASLIB_BENCH_DEEPCOPYPTR(InlinePtr, Blob<16>);
+ASLIB_BENCH_DEEPCOPYPTR(InlinePtr, Blob<64>);
+ASLIB_BENCH_DEEPCOPYPTR(InlinePtr, Blob<256>);
+ASLIB_BENCH_DEEPCOPYPTR(HeapPtr, PooledBlob<64>);
+ASLIB_BENCH_DEEPCOPYPTR(HeapPtr, PooledBlob<256>);
+
+BENCHMARK(BM_DeepCopyPtr_TreeCopy)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_DeepCopyPtr_TreeParallelCopy)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_TEMPLATE(BM_CowPtr_Copy, 64);
+BENCHMARK_TEMPLATE(BM_CowPtr_Copy, 1024);
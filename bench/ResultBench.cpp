@@ -0,0 +1,256 @@
+﻿#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <aslib/AsyncResult.hpp>
+#include <aslib/Error.hpp>
+#include <aslib/Result.hpp>
+#include <aslib/ResultQueue.hpp>
+
+#include "AllocationCounter.hpp"
+
+namespace {
+	/// 自明にコピー出来る、Bytesバイトの正常値.
+	template<std::size_t Bytes>
+	struct Pod {
+		char data[Bytes];
+	};
+
+	enum ErrorCode { someError = 1 };
+
+	template<typename T> struct Payload;
+	template<std::size_t Bytes>
+	struct Payload<Pod<Bytes> > {
+		static Pod<Bytes> make() { Pod<Bytes> p; std::memset(p.data, 1, Bytes); return p; }
+	};
+	template<>
+	struct Payload<std::string> {
+		/// 短い文字列最適化に収まらない長さ.
+		static std::string make() { return std::string(64, 'a'); }
+	};
+	template<>
+	struct Payload<std::vector<int> > {
+		static std::vector<int> make() { return std::vector<int>(256, 1); }
+	};
+
+	/// 破棄の計測で、1回の反復当たりに破棄するオブジェクトの数.
+	const std::size_t batchSize = 256;
+
+	/// コピーコンストラクタ. コピーしたオブジェクトの破棄を含む.
+	template<typename T>
+	void BM_Result_Copy(benchmark::State &state) {
+		const aslib::Result<T, ErrorCode> src(Payload<T>::make());
+		bench::AllocationScope scope(state);
+		for(auto _ : state) {
+			aslib::Result<T, ErrorCode> copy(src);
+			benchmark::DoNotOptimize(copy.get_if());
+		}
+	}
+
+	/// ムーブコンストラクタ. 往復させて元に戻す.
+	template<typename T>
+	void BM_Result_Move(benchmark::State &state) {
+		aslib::Result<T, ErrorCode> src(Payload<T>::make());
+		bench::AllocationScope scope(state);
+		for(auto _ : state) {
+			aslib::Result<T, ErrorCode> moved(std::move(src));
+			src = std::move(moved);
+			benchmark::DoNotOptimize(src.get_if());
+		}
+	}
+
+	/// 正常値を保持しているResultへの、正常値のコピー代入. 格納型の代入演算子で既存の値に代入する.
+	template<typename T>
+	void BM_Result_Assign(benchmark::State &state) {
+		const aslib::Result<T, ErrorCode> src(Payload<T>::make());
+		aslib::Result<T, ErrorCode> dst(Payload<T>::make());
+		bench::AllocationScope scope(state);
+		for(auto _ : state) {
+			dst = src;
+			benchmark::DoNotOptimize(dst.get_if());
+		}
+	}
+
+	/// 正常値とエラー値を交互に代入する. 毎回、値の破棄と構築が起きる.
+	template<typename T>
+	void BM_Result_AssignSwitch(benchmark::State &state) {
+		const aslib::Result<T, ErrorCode> success(Payload<T>::make()), failure(someError);
+		aslib::Result<T, ErrorCode> dst;
+		bench::AllocationScope scope(state, 2);
+		for(auto _ : state) {
+			dst = success;
+			benchmark::DoNotOptimize(dst.get_if());
+			dst = failure;
+			benchmark::DoNotOptimize(dst.fail_if());
+		}
+	}
+
+	/// 破棄. 計測外で用意したbatchSize個のコピーを破棄する.
+	template<typename T>
+	void BM_Result_Destroy(benchmark::State &state) {
+		const aslib::Result<T, ErrorCode> src(Payload<T>::make());
+		std::vector<aslib::Result<T, ErrorCode> > batch;
+		batch.reserve(batchSize);
+		for(auto _ : state) {
+			state.PauseTiming();
+			for(std::size_t i = 0; i < batchSize; ++i) batch.push_back(src);
+			const bench::AllocationCount before = bench::allocationCount();
+			state.ResumeTiming();
+
+			batch.clear();
+
+			state.PauseTiming();
+			state.counters["frees/op"] += static_cast<double>(bench::allocationCount().deallocations - before.deallocations) / batchSize;
+			state.ResumeTiming();
+		}
+		state.counters["frees/op"] /= static_cast<double>(state.iterations());
+		state.SetItemsProcessed(state.iterations() * batchSize);
+	}
+
+	/*
+	 * エラー値の表現による、エラー伝播のコスト.
+	 * 最深部で発生したエラーを、各段でResultを作り直しながらdepth段上まで返す.
+	 */
+
+	class BenchErrorCategory : public aslib::ErrorCategory {
+	public:
+		const char *name() const { return "bench"; }
+		std::string message(int) const { return "failed to parse the configuration file"; }
+	};
+	const aslib::ErrorCategory &benchErrorCategory() { static const BenchErrorCategory c; return c; }
+
+	template<typename E> E makeError();
+	template<> aslib::Error makeError<aslib::Error>() { return aslib::Error(someError, benchErrorCategory()); }
+	template<> aslib::BasicError<32> makeError<aslib::BasicError<32> >() { return aslib::BasicError<32>(someError, benchErrorCategory(), "line 42"); }
+	template<> std::string makeError<std::string>() { return "failed to parse the configuration file: line 42"; }
+
+	template<typename E>
+	aslib::Result<int, E> propagate(int depth) {
+		if(depth == 0) return makeError<E>();
+		aslib::Result<int, E> inner = propagate<E>(depth - 1);
+		if(!inner) return std::move(inner.fail());
+		return *inner + 1;
+	}
+
+	template<typename E>
+	void BM_Result_PropagateError(benchmark::State &state) {
+		const int depth = static_cast<int>(state.range(0));
+		bench::AllocationScope scope(state);
+		for(auto _ : state) {
+			aslib::Result<int, E> r = propagate<E>(depth);
+			benchmark::DoNotOptimize(r.fail_if());
+		}
+	}
+
+	/*
+	 * 非同期に完了する結果の受け渡し. 同じスレッドで結果を格納してから受け取り、共有状態の確保と同期のコストを比べる.
+	 */
+
+	/// AsyncResult. 継続を登録してから結果を格納する.
+	void BM_AsyncResult_Handoff(benchmark::State &state) {
+		bench::AllocationScope scope(state);
+		for(auto _ : state) {
+			aslib::AsyncResult<int, ErrorCode> async;
+			int received = 0;
+			async.then([&received](aslib::Result<int, ErrorCode> &&r) { received = *r; });
+			async.set(1);
+			benchmark::DoNotOptimize(received);
+		}
+	}
+
+	/// std::promiseとstd::futureで同じ受け渡しを行う.
+	void BM_Future_Handoff(benchmark::State &state) {
+		bench::AllocationScope scope(state);
+		for(auto _ : state) {
+			std::promise<aslib::Result<int, ErrorCode> > promise;
+			std::future<aslib::Result<int, ErrorCode> > future = promise.get_future();
+			promise.set_value(1);
+			aslib::Result<int, ErrorCode> r = future.get();
+			benchmark::DoNotOptimize(r.get_if());
+		}
+	}
+
+	/*
+	 * スレッド間での結果の受け渡し. 各スレッドが追加と取出しを交互に行い、キューの同期のコストを比べる.
+	 */
+	typedef aslib::Result<Pod<64>, ErrorCode> Record;
+	static const std::size_t transferBatch = 16;
+
+	/// ResultQueue. 1件ずつ追加・取り出す.
+	void BM_ResultQueue_Transfer(benchmark::State &state) {
+		static aslib::ResultQueue<Pod<64>, ErrorCode> queue(1024);
+		Record r(Payload<Pod<64> >::make());
+		for(auto _ : state) {
+			while(!queue.try_push(std::move(r))) {}
+			while(!queue.try_pop(r)) {}
+		}
+		benchmark::DoNotOptimize(r.get_if());
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	/// ResultQueue. transferBatch件ずつまとめて追加・取り出す.
+	void BM_ResultQueue_TransferBulk(benchmark::State &state) {
+		static aslib::ResultQueue<Pod<64>, ErrorCode> queue(1024);
+		std::vector<Record> batch(transferBatch, Record(Payload<Pod<64> >::make()));
+		for(auto _ : state) {
+			for(std::size_t n = 0; n < transferBatch; ) n += queue.try_push_bulk(batch.begin() + n, batch.end());
+			for(std::size_t n = 0; n < transferBatch; ) n += queue.try_pop_bulk(batch.begin() + n, transferBatch - n);
+		}
+		benchmark::DoNotOptimize(batch.data());
+		state.SetItemsProcessed(state.iterations() * transferBatch);
+	}
+
+	/// std::mutexで保護したstd::dequeで同じ受け渡しを行う.
+	void BM_MutexDeque_Transfer(benchmark::State &state) {
+		static std::mutex mutex;
+		static std::deque<Record> queue;
+		Record r(Payload<Pod<64> >::make());
+		for(auto _ : state) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				queue.push_back(std::move(r));
+			}
+			for(;;) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if(queue.empty()) continue;
+				r = std::move(queue.front());
+				queue.pop_front();
+				break;
+			}
+		}
+		benchmark::DoNotOptimize(r.get_if());
+		state.SetItemsProcessed(state.iterations());
+	}
+}
+
+#define ASLIB_BENCH_RESULT(T) \
+	BENCHMARK_TEMPLATE(BM_Result_Copy, T); \
+	BENCHMARK_TEMPLATE(BM_Result_Move, T); \
+	BENCHMARK_TEMPLATE(BM_Result_Assign, T); \
+	BENCHMARK_TEMPLATE(BM_Result_AssignSwitch, T); \
+	BENCHMARK_TEMPLATE(BM_Result_Destroy, T)
+
+ASLIB_BENCH_RESULT(Pod<8>);
+ASLIB_BENCH_RESULT(Pod<64>);
+ASLIB_BENCH_RESULT(Pod<256>);
+ASLIB_BENCH_RESULT(Pod<1024>);
+ASLIB_BENCH_RESULT(std::string);
+ASLIB_BENCH_RESULT(std::vector<int>);
+
+BENCHMARK_TEMPLATE(BM_Result_PropagateError, aslib::Error)->Arg(1)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_Result_PropagateError, aslib::BasicError<32>)->Arg(1)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_Result_PropagateError, std::string)->Arg(1)->Arg(4)->Arg(16);
+
+BENCHMARK(BM_AsyncResult_Handoff);
+BENCHMARK(BM_Future_Handoff);
+
+BENCHMARK(BM_ResultQueue_Transfer)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_ResultQueue_TransferBulk)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_MutexDeque_Transfer)->ThreadRange(1, 8)->UseRealTime();
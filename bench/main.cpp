@@ -0,0 +1,8 @@
+﻿/*
+ * aslibのベンチマーク.
+ * 回帰の検出には、JSONで出力した結果同士をGoogle Benchmark付属のtools/compare.pyで比較する.
+ *	aslib_bench --benchmark_out=aslib_bench.json --benchmark_out_format=json
+ */
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
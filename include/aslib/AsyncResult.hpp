@@ -0,0 +1,230 @@
+﻿/**
+ * @file
+ * 別のスレッドで完了するaslib::Result.
+ */
+#ifndef ASLIB_INCLUDED_ASYNCRESULT_HPP_
+#define ASLIB_INCLUDED_ASYNCRESULT_HPP_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <aslib/Config.hpp>
+#include <aslib/Result.hpp>
+
+namespace aslib {
+
+template<typename S, typename F, std::size_t InlineBytes>
+class AsyncResult;
+
+namespace detail {
+
+/// AsyncResult::then(next, func)の継続. funcの戻り値でnextを完了する.
+template<typename Next, typename Func>
+struct AsyncResultForwarder {
+	template<typename R>
+	void operator()(R &&result) { next->set(func(std::forward<R>(result))); }
+
+	Next *next;
+	Func func;
+};
+
+}	// namespace detail
+
+/**
+ * 別のスレッドで完了するaslib::Result. std::future<Result<S, F> >の代わりに用いる.
+ * 完了を待つ側(then()で継続を登録する)と、完了させる側(set()で結果を格納する)の1対1で用いる.
+ * 共有状態はこのオブジェクト自身であり、ヒープを確保しない. 継続もInlineBytes以下のサイズであれば内部に格納する.
+ * 完了の受け渡しは1つのアトミック変数へのfetch_orのみで行い、ロックは用いない. 結果の格納と継続の登録のうち、後に行った側のスレッドで継続を呼び出す.
+ * @code
+ *	aslib::AsyncResult<Response, Error> response;
+ *	response.then([&](aslib::Result<Response, Error> &&r) {	// 継続は1つのみ
+ *		stage.push(std::move(r).and_then(decode));
+ *	});
+ *	ioThread.submit(request, [&](Response &&s) { response.set(std::move(s)); });
+ * @endcode
+ * 継続の呼出まで、このオブジェクトを破棄・移動してはならない(コピー・ムーブは出来ない).
+ * 継続へ渡す結果はこのオブジェクト内の値である為、継続の中でこのオブジェクトを破棄する場合は、先に結果をムーブしておく事.
+ * @param[in]	S	正常値の型.
+ * @param[in]	F	エラー値の型.
+ * @param[in]	InlineBytes	継続の関数オブジェクトを格納する領域のバイト数. 超える関数オブジェクトはコンパイル時エラーとなる.
+ */
+template<typename S, typename F, std::size_t InlineBytes = 4 * sizeof(void *)>
+class AsyncResult {
+public:	// public types {{{
+	/// 結果の型.
+	typedef Result<S, F> ResultType;
+// }}}
+
+public:	// constructors / destructor {{{
+	AsyncResult() : state_(0), invoke_(nullptr), destroy_(nullptr) {}
+	AsyncResult(const AsyncResult &) = delete;
+	AsyncResult &operator=(const AsyncResult &) = delete;
+	/// 呼び出されなかった継続は破棄する.
+	~AsyncResult() { if(destroy_) destroy_(&slot_); }
+// }}}
+
+public:	// functions {{{
+	/// @return	結果が格納されていればtrue.
+	bool ready() const { return (state_.load(std::memory_order_acquire) & resultBit) != 0; }
+
+	/**
+	 * 結果を格納し、継続が登録されていれば呼出スレッドで呼び出す.
+	 * 1つのAsyncResultに対して1度のみ呼べる.
+	 * @param[in]	result	結果. 正常値またはエラー値を直接渡しても良い.
+	 */
+	void set(ResultType &&result) {
+		result_ = std::move(result);
+		complete();
+	}
+	/// @overload
+	void set(const ResultType &result) {
+		result_ = result;
+		complete();
+	}
+
+	/**
+	 * 継続を登録する. 結果が既に格納されていれば、呼出スレッドで直ちに呼び出す.
+	 * 1つのAsyncResultに対して1度のみ呼べる.
+	 * @param[in]	func	ResultType &&を引数に取る関数オブジェクト. InlineBytes以下のサイズで、ムーブ出来る事.
+	 */
+	template<typename Func>
+	void then(Func &&func) {
+		typedef typename std::decay<Func>::type Stored;
+		static_assert(sizeof(Stored) <= InlineBytes, "The continuation does not fit in the inline slot of AsyncResult.");
+		static_assert(std::alignment_of<Stored>::value <= std::alignment_of<Slot>::value, "AsyncResult does not support over-aligned continuations.");
+		assert(!invoke_);
+
+		new(&slot_) Stored(std::forward<Func>(func));
+		invoke_ = &invoke<Stored>;
+		destroy_ = &destroy<Stored>;
+		if(state_.fetch_or(continuationBit, std::memory_order_acq_rel) & resultBit) run();
+	}
+
+	/**
+	 * 結果をfuncで変換してnextを完了させる継続を登録する. パイプラインの次の段へ結果を渡す.
+	 * funcにはResultのコンビネータをそのまま用いる事が出来る.
+	 * @code
+	 *	aslib::AsyncResult<Bytes, Error> read;
+	 *	aslib::AsyncResult<Message, Error> decoded;
+	 *	read.then(decoded, [](aslib::Result<Bytes, Error> &&r) { return std::move(r).and_then(decode); });
+	 * @endcode
+	 * @param[in]	next	funcの戻り値を格納するAsyncResult. 継続の呼出まで破棄してはならない.
+	 * @param[in]	func	ResultType &&を引数に取り、nextのResultTypeに変換出来る値を返す関数オブジェクト.
+	 */
+	template<typename T, typename G, std::size_t NextBytes, typename Func>
+	void then(AsyncResult<T, G, NextBytes> &next, Func &&func) {
+		typedef detail::AsyncResultForwarder<AsyncResult<T, G, NextBytes>, typename std::decay<Func>::type> Forwarder;
+		then(Forwarder{&next, std::forward<Func>(func)});
+	}
+
+	/**
+	 * 継続を登録せずに結果を取り出す.
+	 * @return	格納されている結果. ready()がtrueである事. 継続を登録した場合は、継続へムーブ済みの値となる.
+	 */
+	ResultType &get() { assert(ready()); return result_; }
+	/// @overload
+	const ResultType &get() const { assert(ready()); return result_; }
+
+	/**
+	 * 結果が格納されるまで待つ.
+	 * C++20ではstd::atomic::waitを、それ以前はstd::this_thread::yieldを用いる. パイプラインの終端等、継続を登録しない場合に用いる.
+	 */
+	void wait() const {
+#if defined(__cpp_lib_atomic_wait)
+		// 待つ事を登録し、complete()がnotify_all()の後にnotifiedBitを立てるまで戻らない(戻った後に破棄されても良いように)
+		unsigned char state = state_.fetch_or(waiterBit, std::memory_order_acq_rel) | waiterBit;
+		if(state & resultBit) return;
+		while(!(state & notifiedBit)) {
+			if(state & resultBit) {
+				// 継続を登録した場合は、complete()は通知せずに継続を呼ぶ
+				if(state & continuationBit) return;
+				std::this_thread::yield();
+			}
+			else state_.wait(state, std::memory_order_acquire);
+			state = state_.load(std::memory_order_acquire);
+		}
+#else
+		while(!(state_.load(std::memory_order_acquire) & resultBit)) std::this_thread::yield();
+#endif
+	}
+
+	/**
+	 * 再び用いる為に、未完了の状態に戻す.
+	 * 継続を呼び出した後か、継続を登録せずにget()で結果を取り出した後に呼ぶ事. 他のスレッドと同時に呼んではならない.
+	 */
+	void reset() {
+		assert(!invoke_);
+		result_ = ResultType();
+		state_.store(0, std::memory_order_relaxed);
+	}
+// }}}
+
+private:	// inner functions {{{
+	enum : unsigned char {
+		resultBit = 1,
+		continuationBit = 2,
+		/// wait()で待っているスレッドがある.
+		waiterBit = 4,
+		/// complete()が待っているスレッドへの通知を終えた.
+		notifiedBit = 8
+	};
+	typedef typename std::aligned_storage<InlineBytes>::type Slot;
+
+	/**
+	 * 結果の格納を公開し、継続が登録済みであれば呼び出す.
+	 * 格納を公開した後は、待っているスレッドが居なければthisに触れない. 居る場合は、通知後にnotifiedBitを立てるまで待っているスレッドが戻らない.
+	 */
+	void complete() {
+		const unsigned char state = state_.fetch_or(resultBit, std::memory_order_acq_rel);
+		if(state & continuationBit) {
+			run();
+			return;
+		}
+#if defined(__cpp_lib_atomic_wait)
+		if(state & waiterBit) {
+			state_.notify_all();
+			state_.fetch_or(notifiedBit, std::memory_order_release);
+		}
+#endif
+	}
+
+	/// 継続を呼び出す. 呼出後はthisに触れない.
+	void run() {
+		void (*const invoke)(AsyncResult *) = invoke_;
+		invoke_ = nullptr;
+		destroy_ = nullptr;
+		invoke(this);
+	}
+
+	/// 継続を格納領域から取り出して破棄した後に、結果を渡して呼び出す.
+	template<typename Stored>
+	static void invoke(AsyncResult *self) {
+		Stored *stored = reinterpret_cast<Stored *>(&self->slot_);
+		Stored func(std::move(*stored));
+		stored->~Stored();
+		func(std::move(self->result_));
+	}
+	template<typename Stored>
+	static void destroy(void *slot) {
+		static_cast<Stored *>(slot)->~Stored();
+	}
+// }}}
+
+private:	// fields {{{
+	/// resultBit、continuationBit、waiterBit、notifiedBitの組合せ. wait()が待つ事を登録する為、mutableとする.
+	mutable std::atomic<unsigned char> state_;
+	ResultType result_;
+	void (*invoke_)(AsyncResult *);
+	void (*destroy_)(void *);
+	Slot slot_;
+// }}}
+};
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_ASYNCRESULT_HPP_
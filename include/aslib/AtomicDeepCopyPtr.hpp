@@ -0,0 +1,385 @@
+﻿/**
+ * @file
+ */
+#ifndef ASLIB_INCLUDED_ATOMICDEEPCOPYPTR_HPP_
+#define ASLIB_INCLUDED_ATOMICDEEPCOPYPTR_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <aslib/DeepCopyPtr.hpp>
+
+namespace aslib {
+
+namespace detail {
+
+/// HazardRecordを別のキャッシュラインに置く為のキャッシュラインのサイズ.
+static const std::size_t hazardCacheLine = 64;
+
+struct HazardRecord;
+
+/// HazardRecordの、詰め物を除いたメンバ.
+struct HazardRecordFields {
+	explicit
+	HazardRecordFields(void *block) : hazard(nullptr), active(true), next(nullptr), block(block) {}
+
+	std::atomic<const void *> hazard;
+	/// いずれかのスレッドが所有していればtrue.
+	std::atomic<bool> active;
+	HazardRecord *next;
+	/// 記録を置いた、確保した領域の先頭.
+	void *block;
+};
+
+/**
+ * ハザードポインタ1つ分の記録.
+ * 読み出し中のオブジェクトのアドレスをhazardに公開し、その間は解放されないようにする.
+ * 他スレッドの記録と同じキャッシュラインに載らないよう、キャッシュラインのサイズまで詰め物をし、create()でキャッシュラインの境界に置く.
+ * (C++17より前はnewが拡張アライメントを扱えない為、alignasは用いない)
+ */
+struct HazardRecord : HazardRecordFields {
+	/// @return	キャッシュラインの境界に構築した記録. destroy()で破棄する.
+	static HazardRecord *create() {
+		std::size_t space = sizeof(HazardRecord) + hazardCacheLine - 1;
+		void *block = ::operator new(space);
+		void *p = block;
+		std::align(hazardCacheLine, sizeof(HazardRecord), p, space);
+		return ::new(p) HazardRecord(block);
+	}
+	static void destroy(HazardRecord *r) {
+		void *block = r->block;
+		r->~HazardRecord();
+		::operator delete(block);
+	}
+
+	char padding_[hazardCacheLine - sizeof(HazardRecordFields)];
+
+private:
+	explicit
+	HazardRecord(void *block) : HazardRecordFields(block) {}
+};
+
+static_assert(sizeof(HazardRecord) == hazardCacheLine, "HazardRecord must fill exactly one cache line.");
+
+/// 解放を遅延しているオブジェクト.
+struct HazardRetired {
+	void *object;
+	void (*deleter)(void *);
+};
+
+/**
+ * ハザードポインタの記録と、解放待ちのオブジェクトを管理する.
+ * 記録は一度確保したら解放せず、スレッドの終了時に他のスレッドが再利用出来るようにする.
+ */
+class HazardDomain {
+public:
+	/// 各スレッドが解放待ちのオブジェクトをこの数だけ溜めたら、解放を試みる.
+	static const std::size_t scanThreshold = 64;
+
+	HazardDomain() : records_(nullptr) {}
+	HazardDomain(const HazardDomain &) = delete;
+	HazardDomain &operator=(const HazardDomain &) = delete;
+	~HazardDomain() {
+		for(std::size_t i = 0; i < orphans_.size(); ++i) orphans_[i].deleter(orphans_[i].object);
+		for(HazardRecord *r = records_.load(std::memory_order_acquire); r; ) {
+			HazardRecord *next = r->next;
+			HazardRecord::destroy(r);
+			r = next;
+		}
+	}
+
+	/// @return	未使用の記録. 無ければ新たに確保する.
+	HazardRecord *acquire() {
+		for(HazardRecord *r = records_.load(std::memory_order_acquire); r; r = r->next) {
+			bool expected = false;
+			if(!r->active.load(std::memory_order_relaxed) && r->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) return r;
+		}
+		HazardRecord *r = HazardRecord::create();
+		HazardRecord *head = records_.load(std::memory_order_relaxed);
+		do {
+			r->next = head;
+		} while(!records_.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+		return r;
+	}
+	/// 記録を他のスレッドが再利用出来るようにする.
+	void release(HazardRecord *r) {
+		r->hazard.store(nullptr, std::memory_order_release);
+		r->active.store(false, std::memory_order_release);
+	}
+
+	/// @return	いずれかのハザードポインタがpを指していればtrue.
+	bool protects(const void *p) const {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		for(HazardRecord *r = records_.load(std::memory_order_acquire); r; r = r->next) {
+			if(r->hazard.load(std::memory_order_acquire) == p) return true;
+		}
+		return false;
+	}
+
+	/**
+	 * retiredの内、いずれのハザードポインタからも指されていないオブジェクトを解放する.
+	 * 終了したスレッドから引き継いだオブジェクトも併せて扱う.
+	 * @param[in,out]	retired	解放待ちのオブジェクト. 解放出来なかったものが残る.
+	 */
+	void scan(std::vector<HazardRetired> &retired) {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			retired.insert(retired.end(), orphans_.begin(), orphans_.end());
+			orphans_.clear();
+		}
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		std::vector<const void *> hazards;
+		for(HazardRecord *r = records_.load(std::memory_order_acquire); r; r = r->next) {
+			if(const void *p = r->hazard.load(std::memory_order_acquire)) hazards.push_back(p);
+		}
+		std::sort(hazards.begin(), hazards.end());
+
+		std::vector<HazardRetired> kept;
+		for(std::size_t i = 0; i < retired.size(); ++i) {
+			if(std::binary_search(hazards.begin(), hazards.end(), static_cast<const void *>(retired[i].object))) kept.push_back(retired[i]);
+			else retired[i].deleter(retired[i].object);
+		}
+		retired.swap(kept);
+	}
+
+	/// 終了するスレッドが解放出来なかったオブジェクトを引き継ぐ.
+	void adopt(const std::vector<HazardRetired> &retired) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		orphans_.insert(orphans_.end(), retired.begin(), retired.end());
+	}
+
+private:
+	std::atomic<HazardRecord *> records_;
+	std::mutex mutex_;
+	std::vector<HazardRetired> orphans_;
+};
+
+/// @return	プロセスで唯一のHazardDomain.
+inline HazardDomain &hazardDomain() {
+	static HazardDomain domain;
+	return domain;
+}
+
+/**
+ * スレッド毎の、所有している未使用の記録と解放待ちのオブジェクト.
+ * 読み出しの度に共有の記録一覧を走査しないよう、解放した記録はスレッドの終了まで手元に置く.
+ */
+class HazardThreadCache {
+public:
+	HazardThreadCache() : domain_(hazardDomain()) {}
+	HazardThreadCache(const HazardThreadCache &) = delete;
+	HazardThreadCache &operator=(const HazardThreadCache &) = delete;
+	~HazardThreadCache() {
+		for(std::size_t i = 0; i < free_.size(); ++i) domain_.release(free_[i]);
+		if(!retired_.empty()) domain_.scan(retired_);
+		if(!retired_.empty()) domain_.adopt(retired_);
+	}
+
+	HazardRecord *acquire() {
+		if(free_.empty()) return domain_.acquire();
+		HazardRecord *r = free_.back();
+		free_.pop_back();
+		return r;
+	}
+	void release(HazardRecord *r) {
+		r->hazard.store(nullptr, std::memory_order_release);
+		free_.push_back(r);
+	}
+
+	void retire(void *object, void (*deleter)(void *)) {
+		HazardRetired r = { object, deleter };
+		retired_.push_back(r);
+		if(retired_.size() >= HazardDomain::scanThreshold) domain_.scan(retired_);
+	}
+
+private:
+	HazardDomain &domain_;
+	std::vector<HazardRecord *> free_;
+	std::vector<HazardRetired> retired_;
+};
+
+/// @return	呼出スレッドのHazardThreadCache.
+inline HazardThreadCache &hazardThreadCache() {
+	thread_local HazardThreadCache cache;
+	return cache;
+}
+
+}	// namespace detail
+
+/**
+ * 複数のスレッドから同時に読み書き出来るDeepCopyPtr.
+ * 少数のスレッドが値を差し替え(store()、exchange())、多数のスレッドが読み出す(load())用途を想定する.
+ * load()はロックを取らず、共有される変数へは読み出しのみを行う為、読み出すスレッドが増えても競合しない.
+ * load()が返すSnapshotが存在する間は、その後にstore()で差し替えられても、Snapshotが指すオブジェクトは解放されない.
+ * 差し替えられたオブジェクトの解放はハザードポインタで管理し、いずれのSnapshotからも指されなくなった後に行う.
+ * @code
+ *	aslib::AtomicDeepCopyPtr<Config> config(aslib::DeepCopyPtr<Config>(new Config));
+ *
+ *	// 読み出すスレッド
+ *	aslib::AtomicDeepCopyPtr<Config>::Snapshot current = config.load();
+ *	use(current->value);
+ *
+ *	// 更新するスレッド
+ *	config.store(newConfig);	// newConfigの深いコピーを公開する
+ * @endcode
+ * @param[in]	Type	指し示すオブジェクトの型.
+ * @sa	aslib::DeepCopyPtr
+ */
+template<typename Type>
+class AtomicDeepCopyPtr {
+	/// 公開するオブジェクト. DeepCopyPtrごと差し替える.
+	struct Node {
+		explicit
+		Node(DeepCopyPtr<Type> &&v) : value(std::move(v)) {}
+		DeepCopyPtr<Type> value;
+	};
+
+public:
+	/// 指し示すオブジェクトの型を表す.
+	typedef Type element_type;
+
+	/**
+	 * load()で得られる、読み出し用のオブジェクトへの参照.
+	 * 存在する間は、指し示すオブジェクトは解放されない. ムーブのみ出来る.
+	 * Snapshotは、それを得たスレッドで破棄しなければならない.
+	 */
+	class Snapshot {
+		friend class AtomicDeepCopyPtr;
+
+	public:
+		Snapshot(Snapshot &&src) noexcept : record_(src.record_), node_(src.node_) {
+			src.record_ = nullptr;
+			src.node_ = nullptr;
+		}
+		Snapshot(const Snapshot &) = delete;
+		Snapshot &operator=(Snapshot rhs) noexcept {
+			std::swap(record_, rhs.record_);
+			std::swap(node_, rhs.node_);
+			return *this;
+		}
+		~Snapshot() {
+			if(record_) detail::hazardThreadCache().release(record_);
+		}
+
+		/// @return	指し示すオブジェクト. NULLを指している場合はNULL.
+		const element_type *get() const { return node_ ? node_->value.get() : nullptr; }
+		const element_type *operator->() const { assert(get()); return get(); }
+		const element_type &operator*() const { assert(get()); return *get(); }
+		/// @return	オブジェクトを指し示しているならばtrue.
+		operator bool() const { return get() != nullptr; }
+
+	private:
+		Snapshot(detail::HazardRecord *record, const Node *node) : record_(record), node_(node) {}
+
+		detail::HazardRecord *record_;
+		const Node *node_;
+	};
+
+public:	// constructors / destructor {{{
+	/// NULLを指す.
+	AtomicDeepCopyPtr() : node_(nullptr) {}
+	/// @param[in]	src	初期値. 深いコピーを行う.
+	explicit
+	AtomicDeepCopyPtr(const DeepCopyPtr<element_type> &src) : node_(makeNode(DeepCopyPtr<element_type>(src))) {}
+	/// @param[in,out]	src	初期値. ムーブする.
+	explicit
+	AtomicDeepCopyPtr(DeepCopyPtr<element_type> &&src) : node_(makeNode(std::move(src))) {}
+
+	AtomicDeepCopyPtr(const AtomicDeepCopyPtr &) = delete;
+	AtomicDeepCopyPtr &operator=(const AtomicDeepCopyPtr &) = delete;
+
+	/// 保持するオブジェクトは、存在するSnapshotが全て破棄された後に解放される.
+	~AtomicDeepCopyPtr() {
+		retire(node_.load(std::memory_order_acquire));
+	}
+// }}}
+
+public:	// functions {{{
+	/**
+	 * 現在のオブジェクトを読み出す. ロックは取らないが、スレッド毎の最初の呼出ではハザードポインタの記録を確保し得る.
+	 * @return	現在のオブジェクトを指すSnapshot.
+	 */
+	Snapshot load() const {
+		detail::HazardRecord *record = detail::hazardThreadCache().acquire();
+		Node *node = node_.load(std::memory_order_acquire);
+		for(;;) {
+			record->hazard.store(node, std::memory_order_seq_cst);
+			Node *current = node_.load(std::memory_order_seq_cst);
+			if(current == node) break;
+			node = current;
+		}
+		return Snapshot(record, node);
+	}
+
+	/// @return	現在のオブジェクトの深いコピー.
+	DeepCopyPtr<element_type> copy() const {
+		Snapshot s = load();
+		return s.node_ ? DeepCopyPtr<element_type>(s.node_->value) : DeepCopyPtr<element_type>();
+	}
+
+	/**
+	 * オブジェクトを差し替える. 差し替え前のオブジェクトは、それを指すSnapshotが無くなった後に解放される.
+	 * @param[in]	src	新しい値. 深いコピーを行う.
+	 */
+	void store(const DeepCopyPtr<element_type> &src) {
+		store(DeepCopyPtr<element_type>(src));
+	}
+	/// @param[in,out]	src	新しい値. ムーブする.
+	void store(DeepCopyPtr<element_type> &&src) {
+		retire(node_.exchange(makeNode(std::move(src)), std::memory_order_acq_rel));
+	}
+
+	/**
+	 * オブジェクトを差し替え、差し替え前の値を返す.
+	 * 差し替え前のオブジェクトを指すSnapshotが全て破棄されるまで待ち、その所有権をコピーせずに返す.
+	 * その為、呼出スレッドが差し替え前のオブジェクトを指すSnapshotを保持していてはならない.
+	 * @param[in,out]	src	新しい値. ムーブする.
+	 * @return	差し替え前の値.
+	 */
+	DeepCopyPtr<element_type> exchange(DeepCopyPtr<element_type> src) {
+		Node *old = node_.exchange(makeNode(std::move(src)), std::memory_order_acq_rel);
+		if(!old) return DeepCopyPtr<element_type>();
+		// 差し替えた後は、新たなload()がoldを指す事は無い
+		while(detail::hazardDomain().protects(old)) std::this_thread::yield();
+		DeepCopyPtr<element_type> result(std::move(old->value));
+		delete old;
+		return result;
+	}
+
+	/**
+	 * load()はスレッド毎の最初の呼出でハザードポインタの記録を確保し得る.
+	 * store()は解放待ちのオブジェクトの解放時にmutexを取り、exchange()は読み出し中のSnapshotの破棄を待つ.
+	 * @return	常にfalse. 全ての操作がロックを用いない訳ではない.
+	 */
+	bool is_lock_free() const { return false; }
+// }}}
+
+private:	// inner functions {{{
+	static Node *makeNode(DeepCopyPtr<element_type> &&src) {
+		return src ? new Node(std::move(src)) : nullptr;
+	}
+	static void deleteNode(void *p) {
+		delete static_cast<Node *>(p);
+	}
+	static void retire(Node *node) {
+		if(node) detail::hazardThreadCache().retire(node, &deleteNode);
+	}
+// }}}
+
+private:	// fields {{{
+	std::atomic<Node *> node_;
+// }}}
+};
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_ATOMICDEEPCOPYPTR_HPP_
@@ -0,0 +1,68 @@
+﻿/**
+ * @file
+ * コンパイラや規格のバージョンに応じた設定.
+ */
+#ifndef ASLIB_INCLUDED_CONFIG_HPP_
+#define ASLIB_INCLUDED_CONFIG_HPP_
+
+/// 対応しているC++規格のバージョン. MSVCは/Zc:__cplusplusを指定しないと__cplusplusが更新されない為、_MSVC_LANGを優先する.
+#if defined(_MSVC_LANG)
+#	define ASLIB_CPLUSPLUS _MSVC_LANG
+#else
+#	define ASLIB_CPLUSPLUS __cplusplus
+#endif
+
+/// std::pmr::memory_resource(C++17)が使用出来るならば1.
+#if !defined(ASLIB_HAS_MEMORY_RESOURCE)
+#	if ASLIB_CPLUSPLUS >= 201703L && defined(__has_include)
+#		if __has_include(<memory_resource>)
+#			define ASLIB_HAS_MEMORY_RESOURCE 1
+#		endif
+#	endif
+#endif
+#if !defined(ASLIB_HAS_MEMORY_RESOURCE)
+#	define ASLIB_HAS_MEMORY_RESOURCE 0
+#endif
+
+/// aslib::Resultを定数式中で使用出来る(C++20のconstexprデストラクタと、定数式中でのstd::construct_atが使用出来る)ならば1.
+#if !defined(ASLIB_HAS_CONSTEXPR_RESULT)
+#	if ASLIB_CPLUSPLUS >= 202002L && defined(__has_include)
+#		if __has_include(<version>)
+#			include <version>
+#			if defined(__cpp_constexpr_dynamic_alloc) && defined(__cpp_lib_constexpr_dynamic_alloc)
+#				define ASLIB_HAS_CONSTEXPR_RESULT 1
+#			endif
+#		endif
+#	endif
+#endif
+#if !defined(ASLIB_HAS_CONSTEXPR_RESULT)
+#	define ASLIB_HAS_CONSTEXPR_RESULT 0
+#endif
+/// ASLIB_HAS_CONSTEXPR_RESULTが1ならばconstexprに、それ以外は空に展開される. aslib::Resultのメンバ関数に付ける.
+#if ASLIB_HAS_CONSTEXPR_RESULT
+#	define ASLIB_RESULT_CONSTEXPR constexpr
+#else
+#	define ASLIB_RESULT_CONSTEXPR
+#endif
+
+/// C++20のコルーチン(<coroutine>)が使用出来るならば1. aslib/ResultCoroutine.hppで用いる.
+#if !defined(ASLIB_HAS_COROUTINE)
+#	if ASLIB_CPLUSPLUS >= 202002L && defined(__has_include)
+#		if __has_include(<version>)
+#			include <version>
+#			if defined(__cpp_impl_coroutine) && defined(__cpp_lib_coroutine)
+#				define ASLIB_HAS_COROUTINE 1
+#			endif
+#		endif
+#	endif
+#endif
+#if !defined(ASLIB_HAS_COROUTINE)
+#	define ASLIB_HAS_COROUTINE 0
+#endif
+
+/// DeepCopyPtrとResultの操作回数を計測する(aslib/Instrumentation.hpp)ならば1. 既定では0で、計測用のコードは生成しない. 全ての翻訳単位で同じ値にする事.
+#if !defined(ASLIB_ENABLE_INSTRUMENTATION)
+#	define ASLIB_ENABLE_INSTRUMENTATION 0
+#endif
+
+#endif	// ASLIB_INCLUDED_CONFIG_HPP_
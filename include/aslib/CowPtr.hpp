@@ -0,0 +1,211 @@
+﻿/**
+ * @file
+ */
+#ifndef ASLIB_INCLUDED_COWPTR_HPP_
+#define ASLIB_INCLUDED_COWPTR_HPP_
+
+#include <atomic>
+#include <cassert>
+#include <utility>
+
+#include <aslib/DeepCopyPtr.hpp>
+
+namespace aslib {
+
+/**
+ * コピーオンライトを行うスマートポインタ.
+ * aslib::DeepCopyPtrと同じく値のように振る舞うが、コピー時には指し示すオブジェクトを参照カウントで共有し、実際のコピーは最初の非constアクセス(operator->、operator*、非constのget())まで遅延する.
+ * 読み出しが殆どの用途では、コピーのコストがオブジェクトのサイズに依らず一定になる.
+ * オブジェクトのコピーにはDeepCopyPtrの機能を用いる為、派生クラスのオブジェクトを保持していてもスライシングは起きない.
+ * 参照カウントの操作はスレッドセーフだが、同じCowPtrオブジェクトを複数のスレッドから同時に操作する事は出来ない.
+ * @param[in]	Type	指し示すオブジェクトの型.
+ * @sa	aslib::DeepCopyPtr
+ */
+template<typename Type>
+class CowPtr {
+	typedef CowPtr<Type> ThisType;
+	template<typename> friend class CowPtr;
+
+public:
+	/// 指し示すオブジェクトの型を表す.
+	typedef Type element_type;
+
+	/**
+	 * コンストラクタ.
+	 * 初期化しなかった場合はNULLを指す.
+	 * @param[in]	p	格納するオブジェクトを指すポインタ.
+	 */
+	CowPtr()
+		: shared_(0)
+	{ }
+	explicit
+	CowPtr(element_type *p)
+		: shared_(p ? new Shared(DeepCopyPtr<element_type>(p)) : 0)
+	{ }
+	template<typename DerivedType>
+	CowPtr(DerivedType *p)
+		: shared_(p ? new Shared(DeepCopyPtr<element_type>(p)) : 0)
+	{ }
+
+	/**
+	 * コピーコンストラクタ.
+	 * コピー元が const element_type * ならば、その場でコピーする.
+	 * @param[in]	src	コピー元を指すポインタ.
+	 */
+	CowPtr(const element_type *src)
+		: shared_(src ? new Shared(DeepCopyPtr<element_type>(src)) : 0)
+	{ }
+
+	/**
+	 * DeepCopyPtrから構築する.
+	 * @param[in]	src	コピー元、またはムーブ元.
+	 */
+	template<typename SomeType, std::size_t SomeBytes>
+	explicit
+	CowPtr(const DeepCopyPtr<SomeType, SomeBytes> &src)
+		: shared_(src ? new Shared(DeepCopyPtr<element_type>(src)) : 0)
+	{ }
+	template<typename SomeType>
+	explicit
+	CowPtr(DeepCopyPtr<SomeType> &&src)
+		: shared_(src ? new Shared(DeepCopyPtr<element_type>(std::move(src))) : 0)
+	{ }
+
+	/**
+	 * コピーコンストラクタ.
+	 * 指し示すオブジェクトは共有し、参照カウントを増やすのみ.
+	 * @param[in]	src	コピー元オブジェクト.
+	 */
+	CowPtr(const ThisType &src)
+		: shared_(src.shared_)
+	{
+		addRef();
+	}
+	/// 要素型の異なるCowPtrとは共有出来ない為、その場でコピーする.
+	template<typename SomeType>
+	CowPtr(const CowPtr<SomeType> &src)
+		: shared_(src.shared_ ? new Shared(DeepCopyPtr<element_type>(src.shared_->value)) : 0)
+	{ }
+
+	/**
+	 * ムーブコンストラクタ.
+	 * @param[in,out]	src	ムーブ元オブジェクト. NULLを指すようになる.
+	 */
+	CowPtr(ThisType &&src) noexcept
+		: shared_(src.shared_)
+	{
+		src.shared_ = 0;
+	}
+
+	~CowPtr() {
+		release();
+	}
+
+	/**
+	 * @return	保持する生ポインタ. 非const版は、オブジェクトを共有していればコピーしてから返す.
+	 */
+	element_type *get() { detach(); return shared_ ? shared_->value.get() : 0; }
+	const element_type *get() const { return shared_ ? shared_->value.get() : 0; }
+
+	/// @return	指し示すオブジェクトを共有しているCowPtrの数. NULLを指している場合は0.
+	long use_count() const { return shared_ ? shared_->count.load(std::memory_order_relaxed) : 0; }
+
+	/**
+	 * 保持するポインタのswap.
+	 */
+	void swap(ThisType &other) noexcept {
+		std::swap(shared_, other.shared_);
+	}
+
+	/**
+	 * ポインタの値を変更する.
+	 * @param[in,out]	変更先ポインタ. 呼出時点で指し示していたオブジェクトは、他に共有しているCowPtrが無ければdeleteされる. 省略時はNULL.
+	 */
+	void reset(element_type *p = 0) {
+		ThisType(p).swap(*this);
+	}
+	template<typename Other>
+	void reset(Other *p) {
+		ThisType(p).swap(*this);
+	}
+
+	/// 通常のポインタと同等に使えるよう、->演算子の定義. 非const版は、オブジェクトを共有していればコピーしてから返す.
+	element_type *operator->() { assert(shared_); return get(); }
+	const element_type *operator->() const { assert(shared_); return get(); }
+	/// 通常のポインタと同等に使えるよう、*演算子の定義. 非const版は、オブジェクトを共有していればコピーしてから返す.
+	element_type &operator*() { assert(shared_); return *get(); }
+	const element_type &operator*() const { assert(shared_); return *get(); }
+
+	/// @return	同じオブジェクトを指し示しているならばtrue.
+	bool operator==(const ThisType &rhs) const {
+		return (get() == rhs.get());
+	}
+
+	/// @return	違うオブジェクトを指し示しているならばtrue.
+	bool operator!=(const ThisType &rhs) const {
+		return !this->operator==(rhs);
+	}
+
+	/**
+	 * 代入を行う.
+	 * 右辺が指し示すオブジェクトを共有する. 実際のコピーは、どちらかへの最初の非constアクセスまで遅延する.
+	 */
+	ThisType &operator=(const ThisType &rhs) {
+		ThisType(rhs).swap(*this);
+
+		return *this;
+	}
+	ThisType &operator=(ThisType &&rhs) noexcept {
+		ThisType(std::move(rhs)).swap(*this);
+
+		return *this;
+	}
+	ThisType &operator=(const element_type *const rhs) {
+		ThisType(rhs).swap(*this);
+
+		return *this;
+	}
+
+	/// @return	オブジェクトを指し示している(=NULLポインタではない)ならばtrue.
+	operator bool() const { return shared_ != 0; }
+
+private:
+	/// 共有されるオブジェクトと、その参照カウント.
+	struct Shared {
+		explicit
+		Shared(DeepCopyPtr<element_type> &&v)
+			: count(1), value(std::move(v))
+		{ }
+
+		std::atomic<long> count;
+		DeepCopyPtr<element_type> value;
+	};
+
+	/// 参照カウントを増やす.
+	void addRef() {
+		if(shared_) shared_->count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/// 参照カウントを減らし、最後の参照であればオブジェクトをdeleteする.
+	void release() {
+		if(!shared_) return;
+		if(shared_->count.fetch_sub(1, std::memory_order_acq_rel) == 1) delete shared_;
+		shared_ = 0;
+	}
+
+	/// 他のCowPtrとオブジェクトを共有していれば、オブジェクトをコピーして共有を解く.
+	void detach() {
+		if(!shared_ || shared_->count.load(std::memory_order_acquire) == 1) return;
+
+		Shared *copied = new Shared(DeepCopyPtr<element_type>(shared_->value));
+		release();
+		shared_ = copied;
+	}
+
+	/// 共有しているオブジェクト.
+	Shared *shared_;
+};
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_COWPTR_HPP_
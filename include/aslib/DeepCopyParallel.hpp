@@ -0,0 +1,317 @@
+﻿/**
+ * @file
+ * DeepCopyPtrが保持する大きな木を、複数のスレッドに分けて深いコピーを行う.
+ */
+#ifndef ASLIB_INCLUDED_DEEPCOPYPARALLEL_HPP_
+#define ASLIB_INCLUDED_DEEPCOPYPARALLEL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <aslib/Config.hpp>
+#include <aslib/DeepCopyPtr.hpp>
+
+#if ASLIB_HAS_MEMORY_RESOURCE
+#	include <memory_resource>
+#endif
+
+namespace aslib {
+
+class DeepCopyArenas;
+
+#if ASLIB_HAS_MEMORY_RESOURCE
+/**
+ * deep_copyでコピーしたオブジェクトの確保元. スレッド毎にstd::pmr::monotonic_buffer_resourceを持ち、排他制御無しで確保する.
+ * コピーしたオブジェクトは全てのDeepCopyPtrを破棄するまで解放されず、DeepCopyArenasの破棄時に纏めて解放される.
+ * その為、コピーしたDeepCopyPtrより長く生存させる事. 1つのDeepCopyArenasを、同時に複数のdeep_copyに渡してはならない.
+ */
+class DeepCopyArenas {
+public:	// constructors {{{
+	/// @param[in]	upstream	各スレッドの確保元が、領域を確保する先.
+	explicit DeepCopyArenas(std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) : upstream_(upstream) {}
+	DeepCopyArenas(const DeepCopyArenas &) = delete;
+	DeepCopyArenas &operator=(const DeepCopyArenas &) = delete;
+// }}}
+
+public:	// functions {{{
+	/// @return	deep_copyのi番目のスレッドの確保元. 無ければ作成する.
+	std::pmr::memory_resource *arena(std::size_t i) {
+		while(arenas_.size() <= i) arenas_.emplace_back(new std::pmr::monotonic_buffer_resource(upstream_));
+		return arenas_[i].get();
+	}
+// }}}
+
+private:	// fields {{{
+	std::pmr::memory_resource *upstream_;
+	std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource> > arenas_;
+// }}}
+};
+#endif
+
+namespace detail {
+
+/// aslib::deferred_copyを指定して後回しにしたDeepCopyPtrのコピー.
+struct DeepCopyTask {
+	void *dst;
+	const void *src;
+	DeepCopyDeferral::Copy copy;
+};
+
+/**
+ * deep_copyの各スレッドが共有する状態.
+ * スレッド毎にタスクの両端キューを持ち、自分のキューは末尾から(深さ優先で)、他のスレッドのキューは先頭から(木の根に近い大きなタスクを)取り出す.
+ * executorが遅れて開始したジョブも安全に終了出来るよう、shared_ptrで保持する.
+ */
+class DeepCopyParallelState {
+	/// 1つのスレッドのタスク.
+	struct Queue {
+		Queue() : head(0) {}
+		std::mutex mutex;
+		std::vector<DeepCopyTask> tasks;
+		/// tasksの内、他のスレッドが取り出し済みの先頭の数.
+		std::size_t head;
+	};
+
+	/// 1つのスレッドでの受付先. タスクのコピーが終わるまで、子のコピーを公開せずに保持する.
+	struct Worker : DeepCopyDeferral {
+		Worker(DeepCopyParallelState &state, std::size_t index) : state(state), index(index), previous(DeepCopyDeferral::current()) {
+			defer = &deferTo;
+#if ASLIB_HAS_MEMORY_RESOURCE
+			resource = state.resources_.empty() ? nullptr : state.resources_[index];
+#endif
+			DeepCopyDeferral::current() = this;
+			DeepCopyDeferral::installed().fetch_add(1, std::memory_order_relaxed);
+		}
+		~Worker() {
+			DeepCopyDeferral::installed().fetch_sub(1, std::memory_order_relaxed);
+			DeepCopyDeferral::current() = previous;
+		}
+
+		static void deferTo(DeepCopyDeferral *self, void *dst, const void *src, Copy copy) {
+			const DeepCopyTask task = { dst, src, copy };
+			static_cast<Worker *>(self)->staged.push_back(task);
+		}
+
+		DeepCopyParallelState &state;
+		std::size_t index;
+		DeepCopyDeferral *previous;
+		std::vector<DeepCopyTask> staged;
+	};
+
+public:
+	DeepCopyParallelState(std::size_t threads, DeepCopyArenas *arenas) : queues_(new Queue[threads]), threads_(threads), pending_(0), failed_(false), active_(0), closed_(false) {
+#if ASLIB_HAS_MEMORY_RESOURCE
+		if(arenas) {
+			for(std::size_t i = 0; i < threads; ++i) resources_.push_back(arenas->arena(i));
+		}
+#else
+		static_cast<void>(arenas);
+#endif
+	}
+
+	/// 呼出スレッドを0番目のスレッドとして、dstの領域へsrcをコピー構築し、そのコピーを最初のタスクにする.
+	template<typename Ptr>
+	void start(Ptr &dst, const Ptr &src) {
+		Worker worker(*this, 0);
+		new(&dst) Ptr(src);
+		publish(worker);
+	}
+
+	/// index番目のスレッドとして、全てのタスクが終わるまでコピーを行う.
+	void run(std::size_t index) {
+		Worker worker(*this, index);
+		DeepCopyTask task;
+		for(;;) {
+			if(!take(index, task)) {
+				if(pending_.load(std::memory_order_acquire) == 0) return;
+				std::this_thread::yield();
+				continue;
+			}
+			// 失敗した後は、残りのタスクを捨てる
+			if(!failed_.load(std::memory_order_relaxed)) {
+				try {
+					task.copy(task.dst, task.src);
+					publish(worker);
+				} catch(...) {
+					worker.staged.clear();
+					fail(std::current_exception());
+				}
+			}
+			pending_.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+
+	/// executorが開始したジョブから呼ぶ. 既にdeep_copyが終わっていれば何もしない.
+	void join(std::size_t index) {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if(closed_) return;
+			++active_;
+		}
+		run(index);
+		std::lock_guard<std::mutex> lock(mutex_);
+		if(--active_ == 0) finished_.notify_all();
+	}
+
+	/**
+	 * 以降に開始したジョブを何もせず終了させ、実行中のジョブの終了を待つ.
+	 * @exception	...	コピー中に発生した最初の例外.
+	 */
+	void close() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		closed_ = true;
+		finished_.wait(lock, [this]() { return active_ == 0; });
+		if(error_) std::rethrow_exception(error_);
+	}
+
+	/// 最初の例外を記録し、残りのタスクを捨てさせる.
+	void fail(std::exception_ptr error) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if(!error_) error_ = error;
+		failed_.store(true, std::memory_order_relaxed);
+	}
+
+private:
+	/// タスクのコピー中に後回しにした子のコピーを、他のスレッドから取り出せるようにする.
+	void publish(Worker &worker) {
+		if(worker.staged.empty()) return;
+		pending_.fetch_add(worker.staged.size(), std::memory_order_relaxed);
+		Queue &queue = queues_[worker.index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.insert(queue.tasks.end(), worker.staged.begin(), worker.staged.end());
+		worker.staged.clear();
+	}
+
+	/// 自分のキューの末尾から取り出し、空ならば他のスレッドのキューの先頭から取り出す.
+	bool take(std::size_t index, DeepCopyTask &task) {
+		{
+			Queue &queue = queues_[index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if(queue.tasks.size() > queue.head) {
+				task = queue.tasks.back();
+				queue.tasks.pop_back();
+				if(queue.tasks.size() == queue.head) {
+					queue.tasks.clear();
+					queue.head = 0;
+				}
+				return true;
+			}
+		}
+		for(std::size_t i = 1; i < threads_; ++i) {
+			Queue &queue = queues_[(index + i) % threads_];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if(queue.tasks.size() > queue.head) {
+				task = queue.tasks[queue.head++];
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::unique_ptr<Queue[]> queues_;
+	std::size_t threads_;
+	/// 公開したが、まだ終わっていないタスクの数.
+	std::atomic<std::size_t> pending_;
+	std::atomic<bool> failed_;
+#if ASLIB_HAS_MEMORY_RESOURCE
+	/// 各スレッドの確保元. DeepCopyArenasを渡さなければ空.
+	std::vector<std::pmr::memory_resource *> resources_;
+#endif
+
+	std::mutex mutex_;
+	std::condition_variable finished_;
+	/// 実行中のジョブの数.
+	std::size_t active_;
+	bool closed_;
+	std::exception_ptr error_;
+};
+
+/// executorへ渡すジョブ. コピー出来る.
+class DeepCopyParallelJob {
+public:
+	DeepCopyParallelJob(const std::shared_ptr<DeepCopyParallelState> &state, std::size_t index) : state_(state), index_(index) {}
+	void operator()() const { state_->join(index_); }
+
+private:
+	std::shared_ptr<DeepCopyParallelState> state_;
+	std::size_t index_;
+};
+
+template<typename Type, std::size_t InlineBytes, typename Executor>
+DeepCopyPtr<Type, InlineBytes> deepCopyParallel(const DeepCopyPtr<Type, InlineBytes> &src, Executor &&executor, std::size_t threads, DeepCopyArenas *arenas) {
+	typedef DeepCopyPtr<Type, InlineBytes> Ptr;
+	if(threads == 0) threads = 1;
+
+	const std::shared_ptr<DeepCopyParallelState> state = std::make_shared<DeepCopyParallelState>(threads, arenas);
+	// コピー先は、全てのタスクが終わるまでアドレスを変えない
+	typename std::aligned_storage<sizeof(Ptr), std::alignment_of<Ptr>::value>::type storage;
+	Ptr &dst = *reinterpret_cast<Ptr *>(&storage);
+	state->start(dst, src);
+	struct Destroy {
+		~Destroy() { ptr.~Ptr(); }
+		Ptr &ptr;
+	} destroy = { dst };
+
+	// ジョブを渡せなかった場合も、開始済みのジョブが終わるまでは戻らない
+	try {
+		for(std::size_t i = 1; i < threads; ++i) executor(DeepCopyParallelJob(state, i));
+	} catch(...) {
+		state->fail(std::current_exception());
+	}
+	state->run(0);
+	state->close();
+	return std::move(dst);
+}
+
+}	// namespace detail
+
+/**
+ * srcが指すオブジェクトを、複数のスレッドに分けて深いコピーを行う. 結果はDeepCopyPtrのコピーコンストラクタと同じになる.
+ * 各オブジェクトのコピーコンストラクタの中でaslib::deferred_copyを指定して構築したDeepCopyPtrは、NULLのまま一旦残し、そのコピーを別のタスクとして他のスレッドへ分配する.
+ * 通常のコピーコンストラクタやコピー代入によるDeepCopyPtrのコピーは後回しにせず、その場で行う. deferred_copyを用いない型の木は、呼出スレッドだけでコピーする.
+ * 呼出スレッドも含めたthreads個のスレッドが、タスクのキューを互いに奪い合って(ワークスティーリング)コピーを進める.
+ * コピーとその確保は、タスクを取り出したスレッドで行う. DeepCopyPoolTraitsを特殊化した型はそのスレッドのフリーリストを用いる.
+ * memory_resourceから確保したオブジェクトは同じmemory_resourceへコピーする為、そのmemory_resourceはスレッドセーフでなければならない.
+ * @code
+ *	std::vector<std::thread> threads;
+ *	aslib::DeepCopyPtr<Scene> copy = aslib::deep_copy(scene, [&](std::function<void()> job) { threads.emplace_back(job); });
+ *	for(std::thread &t : threads) t.join();
+ * @endcode
+ * @param[in]	src	コピー元. コピーの間、他のスレッドから変更してはならない.
+ * @param[in]	executor	ジョブを1つ引数に取り、別のスレッドで1度呼び出す関数オブジェクト. ジョブはコピー出来る関数オブジェクトで、std::function<void()>に変換出来る.
+ *		ジョブの実行を待たずに返る事. deep_copyは開始したジョブの終了のみを待ち、deep_copyの終了後に開始したジョブは何もせずに終わる.
+ * @param[in]	threads	呼出スレッドを含むスレッドの数. 1ならばexecutorを用いない.
+ * @return	コピーしたオブジェクトを指すDeepCopyPtr. srcがNULLならばNULL.
+ * @exception	...	コピー中に発生した最初の例外. その場合、コピーしたオブジェクトは全て破棄する.
+ */
+template<typename Type, std::size_t InlineBytes, typename Executor>
+DeepCopyPtr<Type, InlineBytes> deep_copy(const DeepCopyPtr<Type, InlineBytes> &src, Executor &&executor, std::size_t threads = std::thread::hardware_concurrency()) {
+	if(!src) return DeepCopyPtr<Type, InlineBytes>();
+	return detail::deepCopyParallel(src, std::forward<Executor>(executor), threads, nullptr);
+}
+
+#if ASLIB_HAS_MEMORY_RESOURCE
+/**
+ * @overload
+ * コピーしたオブジェクトは、arenasの各スレッドの確保元から排他制御無しで確保する. memory_resourceから確保したオブジェクトも、arenasへコピーする.
+ * @param[in,out]	arenas	コピーの確保元. コピーしたDeepCopyPtrより長く生存させる事.
+ */
+template<typename Type, std::size_t InlineBytes, typename Executor>
+DeepCopyPtr<Type, InlineBytes> deep_copy(const DeepCopyPtr<Type, InlineBytes> &src, Executor &&executor, DeepCopyArenas &arenas, std::size_t threads = std::thread::hardware_concurrency()) {
+	if(!src) return DeepCopyPtr<Type, InlineBytes>();
+	return detail::deepCopyParallel(src, std::forward<Executor>(executor), threads, &arenas);
+}
+#endif
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_DEEPCOPYPARALLEL_HPP_
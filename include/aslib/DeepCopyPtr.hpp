@@ -1,18 +1,450 @@
 ﻿#ifndef ASLIB_INCLUDED_DEEPCOPYPTR_HPP_
 #define ASLIB_INCLUDED_DEEPCOPYPTR_HPP_
 
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <memory>
+#include <utility>
+
+#include <aslib/Config.hpp>
+#include <aslib/Instrumentation.hpp>
+
+#if ASLIB_HAS_MEMORY_RESOURCE
+#	include <memory_resource>
+#endif
 
 namespace aslib {
 
+/**
+ * DeepCopyPtrがTypeのオブジェクトを確保する際に、スレッド毎のフリーリストを用いるか否かを指定する.
+ * 頻繁にコピー・破棄される型に対して特殊化し、enabledをtrueにする事で、コピー(clone)とemplace()で確保するオブジェクトの領域を再利用する.
+ * 破棄されたオブジェクトの領域は、破棄したスレッドのフリーリストへmaxCached個まで保持し、それを超えた分は解放する.
+ * ポインタを渡してDeepCopyPtrを構築した場合、そのオブジェクトは従来通りdeleteされる.
+ * @code
+ *	namespace aslib { template<> struct DeepCopyPoolTraits<Config> { static const bool enabled = true; static const std::size_t maxCached = 64; }; }
+ * @endcode
+ * @param[in]	Type	対象の型. アライメントはstd::max_align_t以下でなければならない.
+ */
+template<typename Type>
+struct DeepCopyPoolTraits {
+	/// フリーリストを用いるならばtrue.
+	static const bool enabled = false;
+	/// スレッド毎に保持する領域の最大数.
+	static const std::size_t maxCached = 0;
+};
+
+/**
+ * 同じ動的な型のオブジェクトを指すDeepCopyPtrへのコピー代入で、領域を確保し直さずにTypeのoperator=()で代入するか否かを指定する.
+ * 既定では、自明にコピー出来る型に限る. 代入はコピーコンストラクタと同じ結果にならなければならない為、
+ * コピーコンストラクタやoperator=()を定義した型は、それらが同じ意味を持つ場合に限り特殊化してenabledをtrueにする.
+ * (コピーコンストラクタのみを定義した型の暗黙のoperator=()は非推奨であり、コピーコンストラクタの副作用も伴わない)
+ * @code
+ *	namespace aslib { template<> struct DeepCopyAssignTraits<Config> { static const bool enabled = true; }; }
+ * @endcode
+ * @param[in]	Type	対象の型. enabledをtrueにする場合、同じ型のオブジェクトからコピー代入出来なければならない.
+ */
+template<typename Type>
+struct DeepCopyAssignTraits {
+	/// operator=()で代入するならばtrue.
+	static const bool enabled = std::is_trivially_copyable<Type>::value && std::is_copy_assignable<Type>::value;
+};
+
+namespace detail {
+
+/**
+ * DeepCopyPtrが指し示すオブジェクトの動的な型に応じた操作を纏めた関数テーブル.
+ * 型毎に静的な実体を1つだけ持ち、DeepCopyPtrはそのアドレスのみを保持する. その為、削除子の為のヒープ確保や仮想関数呼出は発生しない.
+ * 要素型の異なるDeepCopyPtr間で受け渡せるよう、オブジェクトはvoid *で扱う.
+ */
+struct DeepCopyOperations {
+	/// 指し示すオブジェクトをdeleteする.
+	void (*destroy)(void *p);
+	/// 指し示すオブジェクトを、その動的な型のままコピーする.
+	void *(*clone)(const void *p);
+
+	/// DeepCopyPtr内部に格納したオブジェクトのデストラクタを呼ぶ. 領域の解放は行わない.
+	void (*destruct)(void *p);
+	/// srcが指すオブジェクトを、dstが指す領域にコピー構築する.
+	void (*copyTo)(const void *src, void *dst);
+	/// srcが指すオブジェクトを、dstが指す同じ型のオブジェクトへ代入する. DeepCopyAssignTraitsで代入を許さない型ではNULL.
+	void (*assign)(const void *src, void *dst);
+	/// srcが指すオブジェクトを、dstが指す領域にムーブ構築し、src側は破棄する.
+	void (*relocate)(void *src, void *dst);
+
+	/// clone()が返すオブジェクトを操作する関数テーブルを返す.
+	const DeepCopyOperations *(*cloned)();
+	/// 動的な型の識別に用いる. 同じ型であれば、確保方法に依らず同じ関数を指す.
+	const DeepCopyOperations *(*plain)();
+
+	/// オブジェクトのサイズ.
+	std::size_t size;
+	/// オブジェクトのアライメント.
+	std::size_t alignment;
+	/// DeepCopyPtr内部に格納出来るならばtrue. relocateが例外を送出せず、且つ、確保元を覚えておく必要が無い場合に限る.
+	bool inlinable;
+
+#if ASLIB_HAS_MEMORY_RESOURCE
+	/// 指し示すオブジェクトを、その動的な型のまま、resourceから確保した領域にコピーする.
+	void *(*cloneWith)(const void *p, std::pmr::memory_resource *resource);
+	/// 同じ型で、memory_resourceから確保したオブジェクトを操作する関数テーブルを返す.
+	const DeepCopyOperations *(*withResource)();
+#endif
+};
+
+#if ASLIB_HAS_MEMORY_RESOURCE
+template<typename TargetType>
+struct DeepCopyResourceOperationsFor;
+#endif
+template<typename TargetType>
+struct DeepCopyPooledOperationsFor;
+
+/// DeepCopyAssignTraitsで代入を許す型ならば代入を行う関数を、それ以外はNULLを提供する.
+template<typename TargetType, bool = DeepCopyAssignTraits<TargetType>::enabled /* == true */>
+struct DeepCopyAssign {
+	static void assign(const void *src, void *dst) {
+		InstrumentationExceptionGuard<TargetType> guard;
+		*static_cast<TargetType *>(dst) = *static_cast<const TargetType *>(src);
+		guard.dismiss();
+		ASLIB_INSTRUMENT(TargetType, instrumentationAssignments, 1);
+	}
+	static constexpr void (*get())(const void *, void *) { return &assign; }
+};
+template<typename TargetType>
+struct DeepCopyAssign<TargetType, false> {
+	static constexpr void (*get())(const void *, void *) { return 0; }
+};
+
+/// TargetType型のオブジェクトを操作する関数テーブルを提供する.
+template<typename TargetType>
+struct DeepCopyOperationsFor {
+	/// DeepCopyPtr自身が確保するオブジェクトの操作. DeepCopyPoolTraitsの指定に応じて、プールを用いる.
+	typedef typename std::conditional<DeepCopyPoolTraits<TargetType>::enabled, DeepCopyPooledOperationsFor<TargetType>, DeepCopyOperationsFor<TargetType> >::type Owned;
+
+	template<typename... Args>
+	static TargetType *create(Args &&...args) {
+		ASLIB_INSTRUMENT(TargetType, instrumentationAllocations, 1);
+		ASLIB_INSTRUMENT(TargetType, instrumentationBytesAllocated, sizeof(TargetType));
+		return new TargetType(std::forward<Args>(args)...);
+	}
+	static void destroy(void *p) {
+		delete static_cast<TargetType *>(p);
+	}
+	static void *clone(const void *p) {
+		InstrumentationExceptionGuard<TargetType> guard;
+		void *cloned = Owned::create(*static_cast<const TargetType *>(p));
+		guard.dismiss();
+		ASLIB_INSTRUMENT(TargetType, instrumentationClones, 1);
+		return cloned;
+	}
+	static void destruct(void *p) {
+		static_cast<TargetType *>(p)->~TargetType();
+	}
+	static void copyTo(const void *src, void *dst) {
+		InstrumentationExceptionGuard<TargetType> guard;
+		new(dst) TargetType(*static_cast<const TargetType *>(src));
+		guard.dismiss();
+		ASLIB_INSTRUMENT(TargetType, instrumentationClones, 1);
+	}
+	static void relocate(void *src, void *dst) {
+		ASLIB_INSTRUMENT(TargetType, instrumentationMoves, 1);
+		TargetType *s = static_cast<TargetType *>(src);
+		new(dst) TargetType(std::move(*s));
+		s->~TargetType();
+	}
+	/// @return	TargetType型用の関数テーブル. 定数初期化される為、初期化のコストは掛からない.
+	static const DeepCopyOperations *get() {
+		static const DeepCopyOperations operations = {
+			&destroy, &clone,
+			&destruct, &copyTo, DeepCopyAssign<TargetType>::get(), &relocate,
+			&Owned::get, &get,
+			sizeof(TargetType), std::alignment_of<TargetType>::value, std::is_nothrow_move_constructible<TargetType>::value
+#if ASLIB_HAS_MEMORY_RESOURCE
+			, &DeepCopyResourceOperationsFor<TargetType>::cloneWith, &DeepCopyResourceOperationsFor<TargetType>::get
+#endif
+		};
+		return &operations;
+	}
+};
+
+/**
+ * TargetType型のオブジェクトの領域を、スレッド毎のフリーリストで再利用する.
+ * 領域は::operator newで確保する為、確保したスレッドと異なるスレッドで返却しても良い.
+ */
+template<typename TargetType>
+class DeepCopyPool {
+	static_assert(std::alignment_of<TargetType>::value <= std::alignment_of<std::max_align_t>::value, "DeepCopyPool does not support over-aligned types.");
+
+	struct Node {
+		Node *next;
+	};
+	/// スレッド毎のフリーリスト. スレッドの終了時に、保持している領域を解放する.
+	struct FreeList {
+		FreeList() : head(0), count(0), closed(false) {}
+		~FreeList() {
+			while(head) {
+				Node *next = head->next;
+				::operator delete(head);
+				head = next;
+			}
+			// 以降に破棄されるオブジェクト(静的なDeepCopyPtr等)の領域は、直接解放する
+			closed = true;
+		}
+		Node *head;
+		std::size_t count;
+		bool closed;
+	};
+
+	static FreeList &freeList() {
+		thread_local FreeList list;
+		return list;
+	}
+
+public:
+	/// 確保する領域のサイズ.
+	static const std::size_t blockSize = sizeof(TargetType) > sizeof(Node) ? sizeof(TargetType) : sizeof(Node);
+
+	static void *allocate() {
+		FreeList &list = freeList();
+		if(!list.head) {
+			ASLIB_INSTRUMENT(TargetType, instrumentationAllocations, 1);
+			ASLIB_INSTRUMENT(TargetType, instrumentationBytesAllocated, blockSize);
+			return ::operator new(blockSize);
+		}
+		Node *node = list.head;
+		list.head = node->next;
+		--list.count;
+		return node;
+	}
+	static void deallocate(void *p) {
+		FreeList &list = freeList();
+		if(list.closed || list.count >= DeepCopyPoolTraits<TargetType>::maxCached) {
+			::operator delete(p);
+			return;
+		}
+		Node *node = static_cast<Node *>(p);
+		node->next = list.head;
+		list.head = node;
+		++list.count;
+	}
+};
+
+/// DeepCopyPoolから確保したTargetType型のオブジェクトを操作する関数テーブルを提供する.
+template<typename TargetType>
+struct DeepCopyPooledOperationsFor {
+	typedef DeepCopyOperationsFor<TargetType> Plain;
+	typedef DeepCopyPool<TargetType> Pool;
+
+	template<typename... Args>
+	static TargetType *create(Args &&...args) {
+		void *block = Pool::allocate();
+		try {
+			return new(block) TargetType(std::forward<Args>(args)...);
+		} catch(...) {
+			Pool::deallocate(block);
+			throw;
+		}
+	}
+	static void destroy(void *p) {
+		static_cast<TargetType *>(p)->~TargetType();
+		Pool::deallocate(p);
+	}
+
+	/// @return	TargetType型用の関数テーブル.
+	static const DeepCopyOperations *get() {
+		static const DeepCopyOperations operations = {
+			&destroy, &Plain::clone,
+			&Plain::destruct, &Plain::copyTo, DeepCopyAssign<TargetType>::get(), &Plain::relocate,
+			&get, &Plain::get,
+			sizeof(TargetType), std::alignment_of<TargetType>::value, std::is_nothrow_move_constructible<TargetType>::value
+#if ASLIB_HAS_MEMORY_RESOURCE
+			, &DeepCopyResourceOperationsFor<TargetType>::cloneWith, &DeepCopyResourceOperationsFor<TargetType>::get
+#endif
+		};
+		return &operations;
+	}
+};
+
+#if ASLIB_HAS_MEMORY_RESOURCE
+/**
+ * memory_resourceから確保したTargetType型のオブジェクトを操作する関数テーブルを提供する.
+ * オブジェクトの直前に確保元のmemory_resourceを記録したヘッダを置き、削除やコピーの際はそこから確保元を得る.
+ */
+template<typename TargetType>
+struct DeepCopyResourceOperationsFor {
+	/// オブジェクトの直前に置くヘッダ.
+	struct Header {
+		std::pmr::memory_resource *resource;
+	};
+
+	/// ヘッダの先頭からオブジェクトまでのオフセット.
+	static const std::size_t offset = (sizeof(Header) + std::alignment_of<TargetType>::value - 1) / std::alignment_of<TargetType>::value * std::alignment_of<TargetType>::value;
+	/// ヘッダを含めて確保する領域のサイズ.
+	static const std::size_t blockSize = offset + sizeof(TargetType);
+	/// ヘッダを含めて確保する領域のアライメント.
+	static const std::size_t blockAlignment = std::alignment_of<Header>::value > std::alignment_of<TargetType>::value ? std::alignment_of<Header>::value : std::alignment_of<TargetType>::value;
+
+	static Header *headerOf(void *p) {
+		return reinterpret_cast<Header *>(static_cast<char *>(p) - offset);
+	}
+
+	/**
+	 * resourceから確保した領域にオブジェクトを構築する.
+	 * @param[in]	resource	確保元.
+	 * @param[in]	args	TargetTypeのコンストラクタに渡す引数.
+	 * @return	構築したオブジェクト.
+	 */
+	template<typename... Args>
+	static TargetType *create(std::pmr::memory_resource *resource, Args &&...args) {
+		void *block = resource->allocate(blockSize, blockAlignment);
+		ASLIB_INSTRUMENT(TargetType, instrumentationAllocations, 1);
+		ASLIB_INSTRUMENT(TargetType, instrumentationBytesAllocated, blockSize);
+		try {
+			TargetType *p = new(static_cast<char *>(block) + offset) TargetType(std::forward<Args>(args)...);
+			new(block) Header{resource};
+			return p;
+		} catch(...) {
+			resource->deallocate(block, blockSize, blockAlignment);
+			throw;
+		}
+	}
+
+	static void destroy(void *p) {
+		Header *header = headerOf(p);
+		std::pmr::memory_resource *resource = header->resource;
+		static_cast<TargetType *>(p)->~TargetType();
+		resource->deallocate(header, blockSize, blockAlignment);
+	}
+	static void *clone(const void *p) {
+		return cloneWith(p, headerOf(const_cast<void *>(p))->resource);
+	}
+	static void *cloneWith(const void *p, std::pmr::memory_resource *resource) {
+		InstrumentationExceptionGuard<TargetType> guard;
+		void *cloned = create(resource, *static_cast<const TargetType *>(p));
+		guard.dismiss();
+		ASLIB_INSTRUMENT(TargetType, instrumentationClones, 1);
+		return cloned;
+	}
+
+	/// @return	TargetType型用の関数テーブル. 確保元を覚えておく必要がある為、DeepCopyPtr内部には格納しない.
+	static const DeepCopyOperations *get() {
+		typedef DeepCopyOperationsFor<TargetType> Plain;
+		static const DeepCopyOperations operations = {
+			&destroy, &clone,
+			&Plain::destruct, &Plain::copyTo, DeepCopyAssign<TargetType>::get(), &Plain::relocate,
+			&get, &Plain::get,
+			sizeof(TargetType), std::alignment_of<TargetType>::value, false,
+			&cloneWith, &get
+		};
+		return &operations;
+	}
+};
+#endif
+
+/// 引数リストの先頭がstd::allocator_arg_tならばtrue.
+template<typename... Args>
+struct StartsWithAllocatorArg : std::false_type {};
+template<typename First, typename... Rest>
+struct StartsWithAllocatorArg<First, Rest...> : std::is_same<typename std::decay<First>::type, std::allocator_arg_t> {};
+
+/**
+ * DeepCopyPtrがオブジェクトを内部に格納する為の領域.
+ * @param[in]	Bytes	領域のサイズ.
+ */
+template<std::size_t Bytes>
+struct DeepCopyInlineBuffer {
+	/// 領域のアライメント.
+	static const std::size_t alignment = std::alignment_of<typename std::aligned_storage<Bytes>::type>::value;
+
+	/// TargetType型のオブジェクトを、この領域に格納出来るならばtrue. fits()のコンパイル時版.
+	template<typename TargetType>
+	struct Fits : std::integral_constant<bool, sizeof(TargetType) <= Bytes && alignment % std::alignment_of<TargetType>::value == 0 && std::is_nothrow_move_constructible<TargetType>::value> {};
+
+	/// @return	operationsが扱う型のオブジェクトを、この領域に格納出来るならばtrue.
+	static bool fits(const DeepCopyOperations *operations) {
+		return operations->size <= Bytes && alignment % operations->alignment == 0 && operations->inlinable;
+	}
+
+	void *address() { return &storage_; }
+	const void *address() const { return &storage_; }
+
+	typename std::aligned_storage<Bytes>::type storage_;
+};
+/// 内部に格納しない(=全てのオブジェクトをヒープに置く)場合の特殊化. サイズは0になる.
+template<>
+struct DeepCopyInlineBuffer<0> {
+	template<typename TargetType>
+	struct Fits : std::false_type {};
+
+	static bool fits(const DeepCopyOperations *) { return false; }
+
+	void *address() { return 0; }
+	const void *address() const { return 0; }
+};
+
+/**
+ * aslib::deep_copy(aslib/DeepCopyParallel.hpp)の実行中のスレッドで、aslib::deferred_copyを指定したDeepCopyPtrの構築を後回しにする受付先.
+ * 受け付けたコピーは、コピー先のDeepCopyPtrをNULLのまま残し、後で別のスレッドがcopyを呼んで行う.
+ */
+struct DeepCopyDeferral {
+	/// 後回しにするコピー. dstへsrcをコピーする.
+	typedef void (*Copy)(void *dst, const void *src);
+
+	/// dstへのsrcのコピーを受け付ける.
+	void (*defer)(DeepCopyDeferral *self, void *dst, const void *src, Copy copy);
+#if ASLIB_HAS_MEMORY_RESOURCE
+	/// コピーの確保元. nullptrならば通常のコピーと同じ確保元を用いる.
+	std::pmr::memory_resource *resource;
+#endif
+
+	/// @return	現在のスレッドの受付先. deep_copyの実行中でなければnullptr.
+	static DeepCopyDeferral *&current() {
+		thread_local DeepCopyDeferral *deferral = nullptr;
+		return deferral;
+	}
+	/**
+	 * @return	いずれかのスレッドに設定されている受付先の数.
+	 * 0ならば、aslib::deferred_copyを指定した構築はスレッド局所変数(current())を読まずに済ませる. 定数初期化される為、初期化の判定も掛からない.
+	 */
+	static std::atomic<std::size_t> &installed() {
+		static std::atomic<std::size_t> count(0);
+		return count;
+	}
+};
+
+}	// namespace detail
+
+/// aslib::deep_copyの実行中に、コピーを後回しにするDeepCopyPtrのコンストラクタを選択する為のタグ型.
+struct DeferredCopyTag { constexpr explicit DeferredCopyTag() {} };
+static constexpr DeferredCopyTag deferred_copy{};
+
 /**
  * 深いコピーをサポートするスマートポインタ.
  * 格納するオブジェクトはCopy-Constructiveで、且つ、同じ型のオブジェクトからの代入を行うoperator=()が定義されていなければならない.
  * 各publicメンバの名称は、標準ライブラリのスマートポインタと名称を揃えている.
+ * DeepCopyPtr同士のコピーでは、構築時に渡されたポインタの型のコピーコンストラクタを用いる. その為、派生クラスのオブジェクトを基底クラスのDeepCopyPtrで保持していてもスライシングは起きず、仮想関数clone()等を用意する必要は無い.
+ *
+ * InlineBytesに0以外を指定すると、コピーやemplace()で構築するオブジェクトの内、InlineBytes以下のサイズでアライメントが合い、且つ、例外を送出しないムーブコンストラクタを持つものは、ヒープではなくDeepCopyPtr内部に格納する.
+ * 内部に格納したオブジェクトはDeepCopyPtrのムーブやswap()でアドレスが変わる. ポインタを渡して構築した場合は、従来通りそのポインタが指すオブジェクトを保持する.
+ *
+ * C++17以降では、std::allocator_argとstd::pmr::memory_resourceを渡して、オブジェクトをmemory_resourceから確保出来る. そのオブジェクトのコピーは同じmemory_resourceから確保され、削除時も確保元へ返却される.
+ * std::pmr::monotonic_buffer_resource等で一括して解放する場合でも、それより先にDeepCopyPtrを破棄しなければならない.
+ *
+ * オブジェクトを指しているDeepCopyPtrへのコピー代入では、右辺と動的な型が同じならば、領域を確保し直さずにその型のoperator=()で代入する(aslib::DeepCopyAssignTraits).
+ * aslib::DeepCopyPoolTraitsを特殊化した型は、コピーやemplace()で確保する領域をスレッド毎のフリーリストから再利用する.
+ * ASLIB_ENABLE_INSTRUMENTATIONが1ならば、オブジェクトの動的な型毎に、コピー・移し替え・代入・確保の回数を計測する(aslib/Instrumentation.hpp).
+ * 多数のDeepCopyPtrを辿る大きな木は、aslib::deep_copy(aslib/DeepCopyParallel.hpp)で複数のスレッドに分けてコピー出来る.
+ * @param[in]	Type	指し示すオブジェクトの型.
+ * @param[in]	InlineBytes	内部に格納出来るオブジェクトの最大サイズ. 0ならば常にヒープに置く.
+ * @warning	要素型のサブオブジェクトは、構築時に渡されたポインタの型のオブジェクトの先頭に位置していなければならない(多重継承の2番目以降の基底クラス等は不可).
  */
-template<typename Type>
-class DeepCopyPtr {
-	typedef DeepCopyPtr<Type> ThisType;
+template<typename Type, std::size_t InlineBytes = 0>
+class DeepCopyPtr : private detail::DeepCopyInlineBuffer<InlineBytes> {
+	typedef DeepCopyPtr<Type, InlineBytes> ThisType;
+	typedef detail::DeepCopyInlineBuffer<InlineBytes> Buffer;
+	template<typename, std::size_t> friend class DeepCopyPtr;
 
 public:
 	/// 指し示すオブジェクトの型を表す.
@@ -24,16 +456,16 @@ public:
 	 * @param[in]	p	格納するオブジェクトを指すポインタ.
 	 */
 	DeepCopyPtr()
-		: ptr_(0), deleter_(0)
+		: ptr_(0), operations_(0)
 	{ }
 	explicit
 	DeepCopyPtr(element_type *p)
-		: ptr_(p), deleter_(p ? new Deleter<element_type>() : 0)
+		: ptr_(p), operations_(p ? OperationsFor<element_type>::get() : 0)
 	{ }
 	template<typename DerivedType>
 //	explicit
 	DeepCopyPtr(DerivedType *p)	// class T; class U:T; Ptr<T> p = new U();
-		: ptr_(p), deleter_(p ? new Deleter<DerivedType>() : 0)
+		: ptr_(p), operations_(p ? OperationsFor<DerivedType>::get() : 0)
 	{ }
 
 	/**
@@ -41,15 +473,70 @@ public:
 	 * コピー元がDeepCopyPtrの時はコピーとして扱う.
 	 * @param[in]	src	コピー元オブジェクト.
 	 */
-	explicit
 	DeepCopyPtr(const ThisType &src)
-		: ptr_(src.get() ? new element_type(*(src.get())) : 0), deleter_(src.get() ? new Deleter<element_type>() : 0)
-	{ }
-	template<typename SomeType>
+		: ptr_(0), operations_(0)
+	{
+		copyFrom(src);
+	}
+	template<typename SomeType, std::size_t SomeBytes>
 	explicit
-	DeepCopyPtr(const DeepCopyPtr<SomeType> &src)
-		: ptr_(src.get() ? new SomeType(*(src.get())) : 0), deleter_(src.get() ? new Deleter<SomeType>() : 0)
-	{ }
+	DeepCopyPtr(const DeepCopyPtr<SomeType, SomeBytes> &src)
+		: ptr_(0), operations_(0)
+	{
+		copyFrom(src);
+	}
+
+	/**
+	 * aslib::deep_copyの実行中ならば、NULLのまま一旦構築し、srcのコピーを別のタスクとして他のスレッドへ分配する. それ以外ではコピーコンストラクタと同じ.
+	 * deep_copyでコピーされるオブジェクトのコピーコンストラクタの中で、メンバや標準コンテナの要素をその最終的な位置に構築する場合にのみ用いる.
+	 * @code
+	 *	Node(const Node &src) : first_(aslib::deferred_copy, src.first_) {
+	 *		children_.reserve(src.children_.size());
+	 *		for(const auto &child : src.children_) children_.emplace_back(aslib::deferred_copy, child);
+	 *	}
+	 * @endcode
+	 * @param[in]	src	コピー元オブジェクト. deep_copyの終了まで変更・破棄してはならない.
+	 * @warning	後回しにしたコピーは、deep_copyの終了までに他のスレッドから書き込まれる. それまでこのDeepCopyPtrを参照・ムーブ・破棄してはならない(reserve()していない標準コンテナへの追加等も不可).
+	 */
+	template<typename SomeType, std::size_t SomeBytes>
+	DeepCopyPtr(DeferredCopyTag, const DeepCopyPtr<SomeType, SomeBytes> &src)
+		: ptr_(0), operations_(0)
+	{
+		if(!defer(src)) copyFrom(src);
+	}
+
+#if ASLIB_HAS_MEMORY_RESOURCE
+	/**
+	 * 指し示すオブジェクトを、その動的な型のまま、resourceから確保した領域にコピーする.
+	 * @param[in]	resource	コピー先の確保元.
+	 * @param[in]	src	コピー元オブジェクト.
+	 */
+	template<typename SomeType, std::size_t SomeBytes>
+	DeepCopyPtr(std::allocator_arg_t, std::pmr::memory_resource *resource, const DeepCopyPtr<SomeType, SomeBytes> &src)
+		: ptr_(0), operations_(0)
+	{
+		if(!src.operations_) return;
+		ptr_ = static_cast<SomeType *>(src.operations_->cloneWith(src.ptr_, resource));
+		operations_ = src.operations_->withResource();
+	}
+#endif
+
+	/**
+	 * ムーブコンストラクタ.
+	 * 指し示すオブジェクトの所有権を移すだけで、コピーは行わない. ムーブ元はNULLを指すようになる.
+	 * @param[in,out]	src	ムーブ元オブジェクト.
+	 */
+	DeepCopyPtr(ThisType &&src) noexcept
+		: ptr_(0), operations_(0)
+	{
+		takeFrom(src);
+	}
+	template<typename SomeType>
+	DeepCopyPtr(DeepCopyPtr<SomeType, InlineBytes> &&src) noexcept
+		: ptr_(0), operations_(0)
+	{
+		takeFrom(src);
+	}
 
 	/**
 	 * コピーコンストラクタ.
@@ -57,8 +544,10 @@ public:
 	 * @param[in]	src	コピー元を指すポインタ.
 	 */
 	DeepCopyPtr(const element_type *src)
-		: ptr_(src ? new element_type(*src) : 0), deleter_(src ? new Deleter<element_type>() : 0)
-	{ }
+		: ptr_(0), operations_(0)
+	{
+		if(src) copyFrom(src, OperationsFor<element_type>::get());
+	}
 
 	~DeepCopyPtr() {
 		doDelete();
@@ -73,9 +562,17 @@ public:
 	/**
 	 * 保持するポインタのswap.
 	 */
-	void swap(ThisType &other) {
-		std::swap(ptr_, other.ptr_);
-		std::swap(deleter_, other.deleter_);
+	void swap(ThisType &other) noexcept {
+		if(!isInline() && !other.isInline()) {
+			std::swap(ptr_, other.ptr_);
+			std::swap(operations_, other.operations_);
+			return;
+		}
+
+		// 内部に格納したオブジェクトは、相手の領域へ移し替える
+		ThisType temp(std::move(other));
+		other.takeFrom(*this);
+		takeFrom(temp);
 	}
 
 	/**
@@ -92,6 +589,31 @@ public:
 		ThisType(p).swap(*this);
 	}
 
+	/**
+	 * 指し示すオブジェクトを、与えた引数から新たに構築する.
+	 * 呼出時点で指し示していたオブジェクトはdeleteされる. 内部に格納出来るオブジェクトは、ヒープを確保せずにDeepCopyPtr内部に構築する.
+	 * @param[in]	SomeType	構築するオブジェクトの型. element_type、またはその派生クラス.
+	 * @param[in]	args	SomeTypeのコンストラクタに渡す引数.
+	 */
+	template<typename SomeType, typename... Args, typename = typename std::enable_if<!detail::StartsWithAllocatorArg<Args...>::value>::type>
+	void emplace(Args &&...args) {
+		doDelete();
+
+		// 格納先は型のサイズ・アライメントからコンパイル時に決まる為、格納出来ない型の内部への構築は生成しない
+		construct<SomeType>(std::integral_constant<bool, Buffer::template Fits<SomeType>::value>(), std::forward<Args>(args)...);
+	}
+#if ASLIB_HAS_MEMORY_RESOURCE
+	/// @overload
+	/// @param[in]	resource	オブジェクトの確保元.
+	template<typename SomeType, typename... Args>
+	void emplace(std::allocator_arg_t, std::pmr::memory_resource *resource, Args &&...args) {
+		doDelete();
+
+		ptr_ = detail::DeepCopyResourceOperationsFor<SomeType>::create(resource, std::forward<Args>(args)...);
+		operations_ = detail::DeepCopyResourceOperationsFor<SomeType>::get();
+	}
+#endif
+
 	/// 通常のポインタと同等に使えるよう、->演算子の定義.
 	element_type *operator->() const { assert(ptr_); return ptr_; }
 	/// 通常のポインタと同等に使えるよう、*演算子の定義.
@@ -113,41 +635,58 @@ public:
 	 */
 	ThisType &operator=(const ThisType &rhs) {	// DeepCopyPtr p1, p2; p1 = p2;
 		if(this == &rhs) return *this;
+		if(rhs.operations_ && assignInPlace(rhs.ptr_, rhs.operations_)) return *this;
 
-		doDelete();
+		// 一時オブジェクトへのコピーは、deep_copyの実行中でも後回しにしない
+		ThisType temp;
+		temp.copyFrom(rhs);
+		temp.swap(*this);
 
-		if(rhs) {
-			ptr_ = new element_type(*rhs.ptr_);
-			deleter_ = new Deleter<element_type>();
-		}
+		return *this;
+	}
+	template<typename DerivedType, std::size_t DerivedBytes>
+	ThisType &operator=(const DeepCopyPtr<DerivedType, DerivedBytes> &rhs) {	// DeepCopyPtr<T> tp; DeepCopyPtr<U> up; tp = up;
+		if(rhs.operations_ && assignInPlace(rhs.ptr_, rhs.operations_)) return *this;
+
+		ThisType temp;
+		temp.copyFrom(rhs);
+		temp.swap(*this);
 
 		return *this;
 	}
-	template<typename DerivedType>
-	ThisType &operator=(const DeepCopyPtr<DerivedType> &rhs) {	// DeepCopyPtr<T> tp; DeepCopyPtr<U> up; tp = up;
-		doDelete();
 
-		if(rhs) {
-			ptr_ = new element_type(*rhs.get());
-			deleter_ = new Deleter<DerivedType>();
-		}
+	/**
+	 * 所有権の移動を行う.
+	 * 右辺のポインタが指し示すオブジェクトをそのまま引き取り、右辺はNULLを指すようになる.
+	 */
+	ThisType &operator=(ThisType &&rhs) noexcept {	// DeepCopyPtr p1, p2; p1 = std::move(p2);
+		if(this == &rhs) return *this;
+
+		ThisType(std::move(rhs)).swap(*this);
+
+		return *this;
+	}
+	template<typename DerivedType>
+	ThisType &operator=(DeepCopyPtr<DerivedType, InlineBytes> &&rhs) noexcept {
+		ThisType(std::move(rhs)).swap(*this);
 
 		return *this;
 	}
 	ThisType &operator=(const element_type *const rhs) {
 		if(get() == rhs) return *this;
+		if(rhs && assignInPlace(rhs, OperationsFor<element_type>::get())) return *this;
 
-		doDelete();
-		ptr_ = rhs ? new element_type(*rhs) : 0;
-		deleter_ = new Deleter<element_type>();
+		ThisType(rhs).swap(*this);
 
 		return *this;
 	}
 	template<typename SomeType>
 	ThisType &operator=(const SomeType *const rhs) {
-		doDelete();
-		ptr_ = rhs ? new SomeType(*rhs) : 0;
-		deleter_ = new Deleter<SomeType>();
+		if(rhs && assignInPlace(rhs, OperationsFor<SomeType>::get())) return *this;
+
+		ThisType temp;
+		if(rhs) temp.copyFrom(rhs, OperationsFor<SomeType>::get());
+		temp.swap(*this);
 
 		return *this;
 	}
@@ -166,39 +705,138 @@ public:
 	operator bool() const { return get() != 0; }
 
 private:
-	/// 動的削除子のベースとなる型.
-	struct DeleterBase {
-		virtual ~DeleterBase() {};
-		virtual void operator()(void *p) const = 0;
-	};
-	/// 指し示すオブジェクトの削除を担当する動的削除子.
+	typedef detail::DeepCopyOperations Operations;
 	template<typename TargetType>
-	struct Deleter : public DeleterBase {
-		virtual ~Deleter() {}
-		virtual void operator()(void *p) const {
-			delete static_cast<TargetType *>(p);
+	struct OperationsFor : detail::DeepCopyOperationsFor<TargetType> {};
+
+	/// @return	指し示すオブジェクトをDeepCopyPtr内部に格納しているならばtrue.
+	bool isInline() const {
+		return InlineBytes != 0 && static_cast<const void *>(ptr_) == Buffer::address();
+	}
+
+	/**
+	 * 指し示すオブジェクトを、その動的な型のままコピーする.
+	 * 呼出時点ではNULLを指していなければならない.
+	 * @param[in]	src	コピー元.
+	 * @param[in]	operations	srcが指すオブジェクトを操作する関数テーブル.
+	 */
+	template<typename SomeType>
+	void copyFrom(const SomeType *src, const Operations *operations) {
+		assert(!ptr_);
+
+		if(Buffer::fits(operations)) {
+			operations->copyTo(src, Buffer::address());
+			ptr_ = static_cast<SomeType *>(Buffer::address());
+		} else {
+			ptr_ = static_cast<SomeType *>(operations->clone(src));
+			operations = operations->cloned();
 		}
-	};
+		operations_ = operations;
+	}
+	/// @overload
+	template<typename SomeType, std::size_t SomeBytes>
+	void copyFrom(const DeepCopyPtr<SomeType, SomeBytes> &src) {
+		if(src.operations_) copyFrom(src.ptr_, src.operations_);
+	}
+
+	/**
+	 * SomeType型のオブジェクトを引数から構築する. 呼出時点ではNULLを指していなければならない.
+	 * 第1引数がtrue_typeならば内部に、false_typeならばヒープ(DeepCopyPoolTraitsの指定に応じてプール)に構築する.
+	 * @param[in]	args	SomeTypeのコンストラクタに渡す引数.
+	 */
+	template<typename SomeType, typename... Args>
+	void construct(std::true_type, Args &&...args) {
+		assert(!ptr_);
+		ptr_ = new(Buffer::address()) SomeType(std::forward<Args>(args)...);
+		operations_ = OperationsFor<SomeType>::get();
+	}
+	/// @overload
+	template<typename SomeType, typename... Args>
+	void construct(std::false_type, Args &&...args) {
+		assert(!ptr_);
+		typedef typename detail::DeepCopyOperationsFor<SomeType>::Owned Owned;
+		ptr_ = Owned::create(std::forward<Args>(args)...);
+		operations_ = Owned::get();
+	}
+
+	/**
+	 * aslib::deep_copyの実行中ならば、srcのコピーを後回しにする. aslib::deferred_copyを指定したコンストラクタからのみ呼ぶ.
+	 * @return	後回しにしたならばtrue.
+	 */
+	template<typename SomeType, std::size_t SomeBytes>
+	bool defer(const DeepCopyPtr<SomeType, SomeBytes> &src) {
+		if(!src.operations_ || detail::DeepCopyDeferral::installed().load(std::memory_order_relaxed) == 0) return false;
+		detail::DeepCopyDeferral *deferral = detail::DeepCopyDeferral::current();
+		if(!deferral) return false;
+		deferral->defer(deferral, this, &src, &deferredCopy<SomeType, SomeBytes>);
+		return true;
+	}
+	/// 後回しにしたコピーを行う. コピー先の子のコピーも、現在のスレッドの受付先へ後回しにする.
+	template<typename SomeType, std::size_t SomeBytes>
+	static void deferredCopy(void *dst, const void *src) {
+		ThisType &self = *static_cast<ThisType *>(dst);
+		const DeepCopyPtr<SomeType, SomeBytes> &source = *static_cast<const DeepCopyPtr<SomeType, SomeBytes> *>(src);
+#if ASLIB_HAS_MEMORY_RESOURCE
+		if(std::pmr::memory_resource *resource = detail::DeepCopyDeferral::current()->resource) {
+			self.ptr_ = static_cast<SomeType *>(source.operations_->cloneWith(source.ptr_, resource));
+			self.operations_ = source.operations_->withResource();
+			return;
+		}
+#endif
+		self.copyFrom(source);
+	}
+
+	/**
+	 * 指し示しているオブジェクトとsrcの動的な型が同じならば、領域を確保し直さずに代入する.
+	 * 代入中に例外が発生した場合、指し示しているオブジェクトは代入演算子が保証する状態になる.
+	 * @param[in]	src	代入元. NULLではない事.
+	 * @param[in]	operations	srcが指すオブジェクトを操作する関数テーブル.
+	 * @return	代入したならばtrue.
+	 */
+	bool assignInPlace(const void *src, const Operations *operations) {
+		if(!operations_ || operations_->plain != operations->plain || !operations_->assign) return false;
+		if(src != static_cast<const void *>(ptr_)) operations_->assign(src, ptr_);
+		return true;
+	}
+
+	/**
+	 * srcが指すオブジェクトの所有権を引き取る. srcはNULLを指すようになる.
+	 * 呼出時点ではNULLを指していなければならない.
+	 * @param[in,out]	src	ムーブ元.
+	 */
+	template<typename SomeType>
+	void takeFrom(DeepCopyPtr<SomeType, InlineBytes> &src) noexcept {
+		assert(!ptr_);
+
+		if(src.isInline()) {
+			src.operations_->relocate(src.ptr_, Buffer::address());
+			ptr_ = static_cast<SomeType *>(Buffer::address());
+		} else {
+			ptr_ = src.ptr_;
+		}
+		operations_ = src.operations_;
+		src.ptr_ = 0;
+		src.operations_ = 0;
+	}
 
 	/**
-	 * 指しているオブジェクト(及び、動的削除子)をdeleteする.
+	 * 指しているオブジェクトをdeleteする.
 	 */
 	void doDelete() {
-		if(!deleter_) return;
-		(*deleter_)(ptr_);
-		delete deleter_;
+		if(!operations_) return;
+		if(isInline()) operations_->destruct(ptr_);
+		else operations_->destroy(ptr_);
 		ptr_ = 0;
-		deleter_ = 0;
+		operations_ = 0;
 	}
 
 	/// 指し示しているオブジェクト.
 	Type *ptr_;
 
-	/// ptr_が指しているオブジェクトを削除する為の動的削除子.
-	DeleterBase *deleter_;
+	/// ptr_が指しているオブジェクトを操作する為の関数テーブル.
+	const Operations *operations_;
 };
 
 }	// namespace aslib
 
 #endif
-
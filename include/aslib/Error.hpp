@@ -0,0 +1,119 @@
+﻿/**
+ * @file
+ */
+#ifndef ASLIB_INCLUDED_ERROR_HPP_
+#define ASLIB_INCLUDED_ERROR_HPP_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace aslib {
+
+/**
+ * エラーコードの種類(分類)を表す基底クラス.
+ * 派生クラスのオブジェクトは、プログラム中で1つのみ存在する事(通常は関数内のstatic変数とする). エラーの比較は、このオブジェクトのアドレスで行う.
+ * @sa	aslib::Error
+ */
+class ErrorCategory {
+public:
+	/// @return	分類の名前.
+	virtual const char *name() const = 0;
+	/**
+	 * @param[in]	code	この分類のエラーコード.
+	 * @return	エラーコードを説明する文字列.
+	 */
+	virtual std::string message(int code) const = 0;
+
+protected:
+	ErrorCategory() {}
+	~ErrorCategory() {}
+	ErrorCategory(const ErrorCategory &) = delete;
+	ErrorCategory &operator=(const ErrorCategory &) = delete;
+};
+
+/**
+ * 分類とコードのみでエラーを表す値型. Result<S, Error>のように、エラー値の型として用いる.
+ * エラーの種類ごとに異なるResultを実体化する代わりにこの型を用いれば、モジュール境界でのテンプレートの実体化を減らせる.
+ * 分類へのポインタとコードのみを持つ為2ワードに収まり、自明にコピー出来る. 構築・コピーでメモリ確保は発生しない.
+ * @code
+ *	class ParseErrorCategory : public aslib::ErrorCategory { ... };
+ *	const aslib::ErrorCategory &parseErrorCategory() { static const ParseErrorCategory c; return c; }
+ *
+ *	aslib::Result<Token, aslib::Error> next() {
+ *		if(isEof) return aslib::Error(unexpectedEof, parseErrorCategory());
+ *	}
+ * @endcode
+ * @sa	aslib::ErrorCategory, aslib::BasicError
+ */
+class Error {
+public:	// constructors {{{
+	/// 分類を持たない、コード0のエラー.
+	Error() : category_(0), code_(0) {}
+	/**
+	 * @param[in]	code	エラーコード.
+	 * @param[in]	category	エラーコードの分類.
+	 */
+	Error(int code, const ErrorCategory &category) : category_(&category), code_(code) {}
+// }}}
+
+public:	// functions / operators {{{
+	/// @return	エラーコード.
+	int code() const { return code_; }
+	/// @return	エラーコードの分類. 分類を持たない場合はNULL.
+	const ErrorCategory *category() const { return category_; }
+	/// @return	エラーコードを説明する文字列. 分類を持たない場合は空文字列. この関数のみメモリ確保が発生し得る.
+	std::string message() const { return category_ ? category_->message(code_) : std::string(); }
+
+	/// @return	分類とコードが同じならばtrue.
+	bool operator==(const Error &rhs) const { return category_ == rhs.category_ && code_ == rhs.code_; }
+	/// @return	分類かコードが異なるならばtrue.
+	bool operator!=(const Error &rhs) const { return !operator==(rhs); }
+// }}}
+
+private:	// fields {{{
+	const ErrorCategory *category_;
+	int code_;
+// }}}
+};
+
+/**
+ * 固定長の詳細メッセージを内部に持つaslib::Error.
+ * メッセージはMessageBytes-1バイトまでを内部の領域にコピーし、それ以上は切り詰める. その為メモリ確保は発生せず、自明にコピー出来る.
+ * aslib::Errorから派生する為、Errorとして比較出来る.
+ * @param[in]	MessageBytes	終端文字を含む、メッセージの最大バイト数.
+ */
+template<std::size_t MessageBytes>
+class BasicError : public Error {
+	static_assert(MessageBytes > 0, "BasicError needs room for the terminating null.");
+
+public:	// constructors {{{
+	BasicError() { detail_[0] = '\0'; }
+	/**
+	 * @param[in]	code	エラーコード.
+	 * @param[in]	category	エラーコードの分類.
+	 * @param[in]	detail	詳細メッセージ. MessageBytes-1バイトを超える部分は切り詰める.
+	 */
+	BasicError(int code, const ErrorCategory &category, const char *detail = "")
+		: Error(code, category)
+	{
+		std::size_t length = std::strlen(detail);
+		if(length >= MessageBytes) length = MessageBytes - 1;
+		std::memcpy(detail_, detail, length);
+		detail_[length] = '\0';
+	}
+// }}}
+
+public:	// functions {{{
+	/// @return	詳細メッセージ. 常に終端文字を持つ.
+	const char *detail() const { return detail_; }
+// }}}
+
+private:	// fields {{{
+	char detail_[MessageBytes];
+// }}}
+};
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_ERROR_HPP_
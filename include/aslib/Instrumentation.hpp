@@ -0,0 +1,278 @@
+﻿/**
+ * @file
+ * DeepCopyPtrとResultの操作回数の計測.
+ * ASLIB_ENABLE_INSTRUMENTATIONを1に定義した場合のみ計測し、既定の0では計測用のコードを一切生成しない.
+ * 全ての翻訳単位で同じ値を定義する事(CMakeではASLIB_ENABLE_INSTRUMENTATIONオプションで指定する).
+ */
+#ifndef ASLIB_INCLUDED_INSTRUMENTATION_HPP_
+#define ASLIB_INCLUDED_INSTRUMENTATION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+#include <aslib/Config.hpp>
+
+#if ASLIB_ENABLE_INSTRUMENTATION
+#	include <atomic>
+#	include <mutex>
+#endif
+
+/// 計測する型の最大数. 超えた分は、typeがNULLの1つの記録に纏めて数える.
+#if !defined(ASLIB_INSTRUMENTATION_MAX_TYPES)
+#	define ASLIB_INSTRUMENTATION_MAX_TYPES 128
+#endif
+
+namespace aslib {
+
+/**
+ * 1つの型に対する操作の回数.
+ * いずれもプロセス開始からの累計で、単調に増加する. 区間毎の値が必要な場合は、呼出側で差を取る.
+ * SとFが共に自明にコピー出来るResultは、コピー・ムーブ・代入が単なるメモリのコピーになる為、それらを数えない.
+ */
+struct InstrumentationCounters {
+	/// 深いコピーの回数. DeepCopyPtrではオブジェクトのコピー、Resultではコピー構築.
+	std::uint64_t clones;
+	/// ムーブの回数. DeepCopyPtrでは内部に格納したオブジェクトの移し替え(ヒープ上のオブジェクトはポインタを移すのみで数えない)、Resultではムーブ構築.
+	std::uint64_t moves;
+	/// 代入の回数. DeepCopyPtrでは同じ動的な型への代入、Resultでは保持している値との代入(detail::ResultStorage::substitute等).
+	std::uint64_t assignments;
+	/// ヒープ(またはmemory_resource)からの確保の回数. プールに保持していた領域の再利用は数えない.
+	std::uint64_t allocations;
+	/// 確保したバイト数の合計.
+	std::uint64_t bytesAllocated;
+	/// 例外の回数. DeepCopyPtrではコピー・代入中に発生した例外、ResultではCantDereference等を送出した回数.
+	std::uint64_t exceptions;
+};
+
+/// 1つの型の計測結果.
+struct InstrumentationRecord {
+	/// 計測した型. DeepCopyPtrではオブジェクトの動的な型、Resultではaslib::Result<S, F>. ASLIB_INSTRUMENTATION_MAX_TYPESを超えた分の記録ではNULL.
+	const std::type_info *type;
+	InstrumentationCounters counters;
+};
+
+namespace detail {
+
+/// InstrumentationCountersの各メンバに対応する添字.
+enum InstrumentationField {
+	instrumentationClones,
+	instrumentationMoves,
+	instrumentationAssignments,
+	instrumentationAllocations,
+	instrumentationBytesAllocated,
+	instrumentationExceptions,
+	instrumentationFieldCount
+};
+
+#if ASLIB_ENABLE_INSTRUMENTATION
+/**
+ * 1スレッド分の計測値.
+ * 書き込みは所有スレッドのみが行う為、アトミックな読み書きのみで更新し、read-modify-writeは用いない. 集計時に他のスレッドから読む.
+ */
+struct InstrumentationThreadBlock {
+	InstrumentationThreadBlock() {
+		for(std::size_t i = 0; i < ASLIB_INSTRUMENTATION_MAX_TYPES; ++i) {
+			for(std::size_t j = 0; j < instrumentationFieldCount; ++j) values[i][j].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	std::atomic<std::uint64_t> values[ASLIB_INSTRUMENTATION_MAX_TYPES][instrumentationFieldCount];
+};
+
+/**
+ * 計測する型と、各スレッドの計測値を管理する.
+ * 終了したスレッドの計測値はretired_へ足し込み、集計時に生存しているスレッドの値と合わせる.
+ */
+class InstrumentationRegistry {
+public:
+	InstrumentationRegistry() {
+		for(std::size_t i = 0; i < ASLIB_INSTRUMENTATION_MAX_TYPES; ++i) {
+			for(std::size_t j = 0; j < instrumentationFieldCount; ++j) retired_[i][j] = 0;
+		}
+	}
+	InstrumentationRegistry(const InstrumentationRegistry &) = delete;
+	InstrumentationRegistry &operator=(const InstrumentationRegistry &) = delete;
+
+	/// @return	typeに割り当てた添字. 型の数が上限に達していれば、最後の添字を共有する.
+	std::size_t registerType(const std::type_info &type) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if(types_.size() + 1 >= ASLIB_INSTRUMENTATION_MAX_TYPES) return ASLIB_INSTRUMENTATION_MAX_TYPES - 1;
+		types_.push_back(&type);
+		return types_.size() - 1;
+	}
+
+	void attach(InstrumentationThreadBlock *block) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		threads_.push_back(block);
+	}
+	void detach(InstrumentationThreadBlock *block) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		accumulate(retired_, *block);
+		for(std::size_t i = 0; i < threads_.size(); ++i) {
+			if(threads_[i] != block) continue;
+			threads_[i] = threads_.back();
+			threads_.pop_back();
+			break;
+		}
+	}
+
+	/// @return	全スレッドの計測値を型毎に合計したもの.
+	std::vector<InstrumentationRecord> collect() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::uint64_t total[ASLIB_INSTRUMENTATION_MAX_TYPES][instrumentationFieldCount];
+		for(std::size_t i = 0; i < ASLIB_INSTRUMENTATION_MAX_TYPES; ++i) {
+			for(std::size_t j = 0; j < instrumentationFieldCount; ++j) total[i][j] = retired_[i][j];
+		}
+		for(std::size_t i = 0; i < threads_.size(); ++i) accumulate(total, *threads_[i]);
+
+		std::vector<InstrumentationRecord> records;
+		records.reserve(types_.size() + 1);
+		for(std::size_t i = 0; i < ASLIB_INSTRUMENTATION_MAX_TYPES; ++i) {
+			const bool overflow = (i == ASLIB_INSTRUMENTATION_MAX_TYPES - 1);
+			if(i >= types_.size() && !overflow) continue;
+
+			InstrumentationRecord record;
+			record.type = overflow ? nullptr : types_[i];
+			record.counters.clones = total[i][instrumentationClones];
+			record.counters.moves = total[i][instrumentationMoves];
+			record.counters.assignments = total[i][instrumentationAssignments];
+			record.counters.allocations = total[i][instrumentationAllocations];
+			record.counters.bytesAllocated = total[i][instrumentationBytesAllocated];
+			record.counters.exceptions = total[i][instrumentationExceptions];
+			if(overflow && record.counters.clones + record.counters.moves + record.counters.assignments + record.counters.allocations + record.counters.exceptions == 0) continue;
+			records.push_back(record);
+		}
+		return records;
+	}
+
+private:
+	static void accumulate(std::uint64_t (&total)[ASLIB_INSTRUMENTATION_MAX_TYPES][instrumentationFieldCount], const InstrumentationThreadBlock &block) {
+		for(std::size_t i = 0; i < ASLIB_INSTRUMENTATION_MAX_TYPES; ++i) {
+			for(std::size_t j = 0; j < instrumentationFieldCount; ++j) total[i][j] += block.values[i][j].load(std::memory_order_relaxed);
+		}
+	}
+
+	std::mutex mutex_;
+	std::vector<const std::type_info *> types_;
+	std::vector<InstrumentationThreadBlock *> threads_;
+	std::uint64_t retired_[ASLIB_INSTRUMENTATION_MAX_TYPES][instrumentationFieldCount];
+};
+
+/// @return	プロセスで唯一のInstrumentationRegistry.
+inline InstrumentationRegistry &instrumentationRegistry() {
+	static InstrumentationRegistry registry;
+	return registry;
+}
+
+/// スレッド毎の計測値. 最初の計測時にInstrumentationRegistryへ登録し、スレッドの終了時に値を引き渡す.
+struct InstrumentationThread {
+	InstrumentationThread() { instrumentationRegistry().attach(&block); }
+	~InstrumentationThread() { instrumentationRegistry().detach(&block); }
+
+	InstrumentationThreadBlock block;
+};
+
+/// @return	呼出スレッドの計測値.
+inline InstrumentationThreadBlock &instrumentationThreadBlock() {
+	thread_local InstrumentationThread thread;
+	return thread.block;
+}
+
+/// 型毎の添字. 最初の計測時に割り当てる.
+template<typename Type>
+struct InstrumentationType {
+	static std::size_t index() {
+		static const std::size_t i = instrumentationRegistry().registerType(typeid(Type));
+		return i;
+	}
+};
+#endif
+
+/**
+ * Typeに対する操作を1件記録する.
+ * Resultの定数式中での操作は記録しない.
+ * @param[in]	field	記録する値.
+ * @param[in]	n	加算する値.
+ */
+template<typename Type>
+ASLIB_RESULT_CONSTEXPR void instrument(InstrumentationField field, std::uint64_t n) {
+#if ASLIB_ENABLE_INSTRUMENTATION
+#	if ASLIB_HAS_CONSTEXPR_RESULT
+	if(std::is_constant_evaluated()) return;
+#	endif
+	std::atomic<std::uint64_t> &value = instrumentationThreadBlock().values[InstrumentationType<Type>::index()][field];
+	value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+#else
+	(void)field;
+	(void)n;
+#endif
+}
+
+/**
+ * 生存期間中に例外で抜けた場合に、Typeの例外の回数を記録する. 正常に抜ける場合はdismiss()を呼ぶ.
+ * 計測が無効な場合は何もしない空のクラスになる.
+ */
+template<typename Type>
+class InstrumentationExceptionGuard {
+public:
+#if ASLIB_ENABLE_INSTRUMENTATION
+	InstrumentationExceptionGuard() : active_(true) {}
+	~InstrumentationExceptionGuard() { if(active_) instrument<Type>(instrumentationExceptions, 1); }
+	void dismiss() { active_ = false; }
+
+private:
+	bool active_;
+#else
+	void dismiss() {}
+#endif
+};
+
+}	// namespace detail
+
+/**
+ * 全スレッドの計測値を、型毎に集計する.
+ * 計測中のスレッドの値も読む為、他のスレッドが操作中であれば、その一部は含まれない場合がある.
+ * 結果はメトリクス収集システムへの出力等に用いる.
+ * @code
+ *	std::vector<aslib::InstrumentationRecord> records = aslib::instrumentation_snapshot();
+ *	for(std::size_t i = 0; i < records.size(); ++i) {
+ *		metrics.gauge("aslib.clones", records[i].counters.clones, records[i].type ? records[i].type->name() : "other");
+ *	}
+ * @endcode
+ * @return	計測した型毎の値. 計測が無効な場合は空.
+ */
+inline std::vector<InstrumentationRecord> instrumentation_snapshot() {
+#if ASLIB_ENABLE_INSTRUMENTATION
+	return detail::instrumentationRegistry().collect();
+#else
+	return std::vector<InstrumentationRecord>();
+#endif
+}
+
+/**
+ * @param[in]	Type	集計する型.
+ * @return	Typeの計測値. 計測が無効な場合、またはまだ記録が無い場合は全て0.
+ */
+template<typename Type>
+InstrumentationCounters instrumentation_of() {
+	InstrumentationCounters counters = {};
+	const std::vector<InstrumentationRecord> records = instrumentation_snapshot();
+	for(std::size_t i = 0; i < records.size(); ++i) {
+		if(records[i].type && *records[i].type == typeid(Type)) counters = records[i].counters;
+	}
+	return counters;
+}
+
+}	// namespace aslib
+
+/// Typeに対する操作を記録する. 計測が無効な場合は何も生成しない.
+#if ASLIB_ENABLE_INSTRUMENTATION
+#	define ASLIB_INSTRUMENT(Type, field, n) ::aslib::detail::instrument<Type>(::aslib::detail::field, (n))
+#else
+#	define ASLIB_INSTRUMENT(Type, field, n) ((void)0)
+#endif
+
+#endif	// ASLIB_INCLUDED_INSTRUMENTATION_HPP_
@@ -0,0 +1,599 @@
+﻿/**
+ * @file
+ * 未初期化の状態を持たないaslib::NeverEmptyResult.
+ */
+#ifndef ASLIB_INCLUDED_NEVER_EMPTY_RESULT_HPP_
+#define ASLIB_INCLUDED_NEVER_EMPTY_RESULT_HPP_
+
+#include <cassert>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <aslib/Result.hpp>
+
+namespace aslib {
+
+template<typename S, typename F>
+class NeverEmptyResult;
+
+namespace detail {
+
+/// NeverEmptyStorageを、他のNeverEmptyStorageと同じ値で構築する事を表すタグ.
+struct NeverEmptyCopyTag {};
+
+/**
+ * aslib::NeverEmptyResultの値を格納する領域と、その操作.
+ * detail::ResultStorageと同じ共用体に値を格納するが、値の種類は正常値とエラー値の2つのみで、常にいずれかを保持する.
+ * その為、コピー・ムーブ・代入・破棄は未初期化の場合の分岐を持たない.
+ * 値はこのクラスのコンストラクタで構築する. その為、値の構築で例外が発生した場合は、派生クラスのデストラクタ(値の破棄)は呼ばれない.
+ */
+template<typename S, typename F>
+class NeverEmptyStorage {
+protected:	// types {{{
+	typedef S SucceededType;
+	typedef F FailedType;
+	/// 計測(aslib/Instrumentation.hpp)で記録する型.
+	typedef NeverEmptyResult<S, F> InstrumentedType;
+// }}}
+
+protected:	// constructors {{{
+	/**
+	 * 正常値を引数から直接構築する.
+	 * @param[in]	args	格納型のコンストラクタへ渡す引数.
+	 */
+	template<typename... Args>
+	explicit
+	ASLIB_RESULT_CONSTEXPR NeverEmptyStorage(InPlaceSuccessTag, Args &&...args) : storage_(), succeeded_(false) {
+		constructSucceeded(std::forward<Args>(args)...);
+	}
+	/**
+	 * エラー値を引数から直接構築する.
+	 * @param[in]	args	格納型のコンストラクタへ渡す引数.
+	 */
+	template<typename... Args>
+	explicit
+	ASLIB_RESULT_CONSTEXPR NeverEmptyStorage(InPlaceFailureTag, Args &&...args) : storage_(), succeeded_(false) {
+		constructFailed(std::forward<Args>(args)...);
+	}
+	/**
+	 * Resultが保持する値をコピーする.
+	 * @param[in]	src	コピー元. 未初期化ではない事.
+	 */
+	explicit
+	ASLIB_RESULT_CONSTEXPR NeverEmptyStorage(const Result<S, F> &src) : storage_(), succeeded_(false) {
+		if(const SucceededType *value = src.get_if()) constructSucceeded(*value);
+		else constructFailed(*src.fail_if());
+	}
+	/// @overload
+	explicit
+	ASLIB_RESULT_CONSTEXPR NeverEmptyStorage(Result<S, F> &&src) : storage_(), succeeded_(false) {
+		if(SucceededType *value = src.get_if()) constructSucceeded(std::move(*value));
+		else constructFailed(std::move(*src.fail_if()));
+	}
+	/**
+	 * srcと同じ値を、格納型のコピーコンストラクタで構築する.
+	 * @param[in]	src	コピー元.
+	 */
+	ASLIB_RESULT_CONSTEXPR NeverEmptyStorage(NeverEmptyCopyTag, const NeverEmptyStorage &src) : storage_(), succeeded_(false) {
+		allocate(src);
+	}
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR NeverEmptyStorage(NeverEmptyCopyTag, NeverEmptyStorage &&src) noexcept : storage_(), succeeded_(false) {
+		allocate_move(std::move(src));
+	}
+// }}}
+
+protected:	// inner functions. {{{
+	/**
+	 * 引数から直接正常値を構築する.
+	 * 呼出時点で値を保持していない(構築中、或いは破棄した直後である)事.
+	 * @param[in]	args	格納型のコンストラクタへ渡す引数.
+	 * @return	構築した値への参照.
+	 */
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR SucceededType &constructSucceeded(Args &&...args) {
+		SucceededType *p = resultConstructAt(&storage_.succeededValue, std::forward<Args>(args)...);
+		succeeded_ = true;
+		return *p;
+	}
+	/**
+	 * 引数から直接エラー値を構築する.
+	 * 呼出時点で値を保持していない(構築中、或いは破棄した直後である)事.
+	 * @param[in]	args	格納型のコンストラクタへ渡す引数.
+	 * @return	構築した値への参照.
+	 */
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR FailedType &constructFailed(Args &&...args) {
+		FailedType *p = resultConstructAt(&storage_.failedValue, std::forward<Args>(args)...);
+		succeeded_ = false;
+		return *p;
+	}
+
+	/**
+	 * 保持している値を破棄し、正常値を引数から構築する.
+	 * 構築が例外を送出し得る場合は、一時オブジェクトに構築してから例外を送出しないムーブで移す. その為、例外が発生しても元の値を保持したままになる.
+	 * @param[in]	args	格納型のコンストラクタへ渡す引数.
+	 * @return	構築した値への参照.
+	 */
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR SucceededType &replaceSucceeded(Args &&...args) {
+		return replaceSucceededNothrow(std::integral_constant<bool, std::is_nothrow_constructible<SucceededType, Args &&...>::value>(), std::forward<Args>(args)...);
+	}
+	/**
+	 * 保持している値を破棄し、エラー値を引数から構築する.
+	 * 構築が例外を送出し得る場合は、一時オブジェクトに構築してから例外を送出しないムーブで移す. その為、例外が発生しても元の値を保持したままになる.
+	 * @param[in]	args	格納型のコンストラクタへ渡す引数.
+	 * @return	構築した値への参照.
+	 */
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR FailedType &replaceFailed(Args &&...args) {
+		return replaceFailedNothrow(std::integral_constant<bool, std::is_nothrow_constructible<FailedType, Args &&...>::value>(), std::forward<Args>(args)...);
+	}
+
+	/**
+	 * 他のNeverEmptyStorageと同じ値を構築する.
+	 * 格納型のコピーコンストラクタを使用する.
+	 * @param[in]	src	コピー元
+	 */
+	ASLIB_RESULT_CONSTEXPR void allocate(const NeverEmptyStorage &src) {
+		ASLIB_INSTRUMENT(InstrumentedType, instrumentationClones, 1);
+		if(src.succeeded_) constructSucceeded(src.storage_.succeededValue);
+		else constructFailed(src.storage_.failedValue);
+	}
+	/**
+	 * 他のNeverEmptyStorageと同じ値を構築する.
+	 * 格納型のムーブコンストラクタを使用する. ムーブ元はムーブ後の値を保持したままになる.
+	 * @param[in]	src	ムーブ元
+	 */
+	ASLIB_RESULT_CONSTEXPR void allocate_move(NeverEmptyStorage &&src) {
+		ASLIB_INSTRUMENT(InstrumentedType, instrumentationMoves, 1);
+		if(src.succeeded_) constructSucceeded(std::move(src.storage_.succeededValue));
+		else constructFailed(std::move(src.storage_.failedValue));
+	}
+
+	/**
+	 * 正常値を代入する.
+	 * 正常値を保持していれば、格納型の代入演算子で既存の値に代入する.
+	 * それ以外の場合は、保持しているエラー値を破棄し、正常値を構築する(replaceSucceeded).
+	 * @param[in]	src	代入元.
+	 */
+	template<typename U>
+	ASLIB_RESULT_CONSTEXPR void assignSucceeded(U &&src) {
+		ASLIB_INSTRUMENT(InstrumentedType, instrumentationAssignments, 1);
+		if(succeeded_) storage_.succeededValue = std::forward<U>(src);
+		else replaceSucceeded(std::forward<U>(src));
+	}
+	/**
+	 * エラー値を代入する.
+	 * エラー値を保持していれば、格納型の代入演算子で既存の値に代入する.
+	 * それ以外の場合は、保持している正常値を破棄し、エラー値を構築する(replaceFailed).
+	 * @param[in]	src	代入元.
+	 */
+	template<typename U>
+	ASLIB_RESULT_CONSTEXPR void assignFailed(U &&src) {
+		ASLIB_INSTRUMENT(InstrumentedType, instrumentationAssignments, 1);
+		if(!succeeded_) storage_.failedValue = std::forward<U>(src);
+		else replaceFailed(std::forward<U>(src));
+	}
+
+	/**
+	 * 他のNeverEmptyStorageが保持する値を代入する.
+	 * @param[in]	src	代入元.
+	 */
+	ASLIB_RESULT_CONSTEXPR void substitute(const NeverEmptyStorage &src) {
+		if(src.succeeded_) assignSucceeded(src.storage_.succeededValue);
+		else assignFailed(src.storage_.failedValue);
+	}
+	/**
+	 * 他のNeverEmptyStorageが保持する値をムーブ代入する.
+	 * @param[in]	src	代入元.
+	 */
+	ASLIB_RESULT_CONSTEXPR void substitute_move(NeverEmptyStorage &&src) {
+		if(src.succeeded_) assignSucceeded(std::move(src.storage_.succeededValue));
+		else assignFailed(std::move(src.storage_.failedValue));
+	}
+
+	/// 内部に保持している値を破棄する. 破棄後は、直ちに値を構築するかオブジェクトの寿命を終える事.
+	ASLIB_RESULT_CONSTEXPR void destroy() {
+		if(succeeded_) resultDestroyAt(&storage_.succeededValue);
+		else resultDestroyAt(&storage_.failedValue);
+	}
+// }}}
+
+private:	// inner functions. {{{
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR SucceededType &replaceSucceededNothrow(std::true_type, Args &&...args) {
+		destroy();
+		return constructSucceeded(std::forward<Args>(args)...);
+	}
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR SucceededType &replaceSucceededNothrow(std::false_type, Args &&...args) {
+		SucceededType value(std::forward<Args>(args)...);
+		destroy();
+		return constructSucceeded(std::move(value));
+	}
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR FailedType &replaceFailedNothrow(std::true_type, Args &&...args) {
+		destroy();
+		return constructFailed(std::forward<Args>(args)...);
+	}
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR FailedType &replaceFailedNothrow(std::false_type, Args &&...args) {
+		FailedType value(std::forward<Args>(args)...);
+		destroy();
+		return constructFailed(std::move(value));
+	}
+// }}}
+
+protected:	// fields {{{
+	ResultUnion<SucceededType, FailedType> storage_;
+	bool succeeded_;
+// }}}
+};
+
+/// 格納型が自明なデストラクタを持たない場合に、値を破棄するデストラクタを定義する.
+template<typename S, typename F, bool isTriviallyDestructible = std::is_trivially_destructible<S>::value && std::is_trivially_destructible<F>::value /* == false */>
+class NeverEmptyDestructorBase : public NeverEmptyStorage<S, F> {
+protected:
+	using NeverEmptyStorage<S, F>::NeverEmptyStorage;
+	NeverEmptyDestructorBase(const NeverEmptyDestructorBase &) = default;
+	NeverEmptyDestructorBase(NeverEmptyDestructorBase &&) = default;
+	NeverEmptyDestructorBase &operator=(const NeverEmptyDestructorBase &) = default;
+	NeverEmptyDestructorBase &operator=(NeverEmptyDestructorBase &&) = default;
+	ASLIB_RESULT_CONSTEXPR ~NeverEmptyDestructorBase() { this->destroy(); }
+};
+template<typename S, typename F>
+class NeverEmptyDestructorBase<S, F, true> : public NeverEmptyStorage<S, F> {
+protected:
+	using NeverEmptyStorage<S, F>::NeverEmptyStorage;
+};
+
+/// 格納型のコピー・ムーブが自明でない場合に、格納型に応じたコピー・ムーブを定義する.
+template<typename S, typename F, bool isTriviallyCopyable = IsTriviallyCopyableForResult<S>::value && IsTriviallyCopyableForResult<F>::value /* == false */>
+class NeverEmptyCopyBase : public NeverEmptyDestructorBase<S, F> {
+protected:
+	using NeverEmptyDestructorBase<S, F>::NeverEmptyDestructorBase;
+	/// @param[in]	src	コピー元.
+	ASLIB_RESULT_CONSTEXPR NeverEmptyCopyBase(const NeverEmptyCopyBase &src) : NeverEmptyDestructorBase<S, F>(NeverEmptyCopyTag(), src) {}
+	/// @param[in]	src	ムーブ元.
+	ASLIB_RESULT_CONSTEXPR NeverEmptyCopyBase(NeverEmptyCopyBase &&src) noexcept : NeverEmptyDestructorBase<S, F>(NeverEmptyCopyTag(), std::move(src)) {}
+
+	ASLIB_RESULT_CONSTEXPR NeverEmptyCopyBase &operator=(const NeverEmptyCopyBase &rhs) {
+		if(this != &rhs) this->substitute(rhs);
+		return *this;
+	}
+	ASLIB_RESULT_CONSTEXPR NeverEmptyCopyBase &operator=(NeverEmptyCopyBase &&rhs) {
+		if(this != &rhs) this->substitute_move(std::move(rhs));
+		return *this;
+	}
+};
+template<typename S, typename F>
+class NeverEmptyCopyBase<S, F, true> : public NeverEmptyDestructorBase<S, F> {
+protected:
+	using NeverEmptyDestructorBase<S, F>::NeverEmptyDestructorBase;
+};
+
+}	// namespace detail
+
+/**
+ * 未初期化の状態を持たないaslib::Result.
+ * 常に正常値かエラー値のいずれかを保持する為、アクセサ・コンビネータ・コピー・破棄は未初期化の場合の分岐を持たない.
+ * 値の種類が変わる代入やemplace_success/emplace_failureで例外が発生しても、元の値を保持したままになる(strong guarantee).
+ * 既定のコンストラクタは、FailedTypeが既定のコンストラクタを持つ場合のみ定義し、既定値のエラー値を保持する.
+ * @code
+ *	aslib::NeverEmptyResult<Record, ParseError> r;	// ParseError()を保持する
+ *	r = parse(line);
+ *	if(r) write(*r);	// 未初期化の確認は不要
+ * @endcode
+ * レイアウトと、自明にコピー・破棄出来る条件はResult<S, F>と同じ. Result<S, F>とは相互に変換出来る.
+ * ASLIB_TRY・ASLIB_TRY_ASSIGNは、NeverEmptyResultを返す式にも、NeverEmptyResultを返す関数の中でも使える.
+ * @param[in]	S	正常値の型. 例外を送出しないムーブコンストラクタを持つ事.
+ * @param[in]	F	エラー値の型. 例外を送出しないムーブコンストラクタを持つ事.
+ * @sa	aslib::Result
+ */
+template<typename S, typename F>
+class NeverEmptyResult : private detail::NeverEmptyCopyBase<S, F> {
+	typedef detail::NeverEmptyCopyBase<S, F> Base;
+
+	static_assert(std::is_nothrow_move_constructible<S>::value && std::is_nothrow_move_constructible<F>::value, "NeverEmptyResult requires nothrow move constructible types to keep a value when a replacement throws.");
+
+public:	// public types {{{
+	/// 正常値の型.
+	typedef S SucceededType;
+	/// エラー値の型.
+	typedef F FailedType;
+
+	/// @sa	aslib::Result::CantDereference
+	typedef typename Result<S, F>::CantDereference CantDereference;
+	/// @sa	aslib::Result::NotHaveFailedObject
+	typedef typename Result<S, F>::NotHaveFailedObject NotHaveFailedObject;
+	/// 未初期化のResultから構築しようとした場合に発生する例外.
+	struct EmptySource : std::runtime_error {
+		EmptySource() : runtime_error("Uninitialized result value.") {}
+	};
+// }}}
+
+private: // private types {{{
+	typedef NeverEmptyResult<SucceededType, FailedType> My;
+// }}}
+
+public:	// constructors / destructor {{{
+	/// エラー値を既定のコンストラクタで構築する. コピー・ムーブ・破棄は、格納型に応じてdetail::NeverEmptyCopyBase及びdetail::NeverEmptyDestructorBaseで定義する.
+	template<typename G = FailedType, typename = typename std::enable_if<std::is_default_constructible<G>::value>::type>
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult() : Base(in_place_failure) {}
+	/// @param[in]	src	正常値.
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult(const SucceededType &src) : Base(in_place_success, src) {}
+	/// @param[in]	src	正常値.
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult(SucceededType &&src) : Base(in_place_success, std::move(src)) {}
+	/// @param[in]	src	エラー値.
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult(const FailedType &src) : Base(in_place_failure, src) {}
+	/// @param[in]	src	エラー値.
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult(FailedType &&src) : Base(in_place_failure, std::move(src)) {}
+	/**
+	 * 正常値を引数から直接構築する. 正常値のコピー・ムーブは発生しない.
+	 * @param[in]	args	SucceededTypeのコンストラクタへ渡す引数.
+	 */
+	template<typename... Args>
+	explicit
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult(InPlaceSuccessTag, Args &&...args) : Base(in_place_success, std::forward<Args>(args)...) {}
+	/**
+	 * エラー値を引数から直接構築する. エラー値のコピー・ムーブは発生しない.
+	 * @param[in]	args	FailedTypeのコンストラクタへ渡す引数.
+	 */
+	template<typename... Args>
+	explicit
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult(InPlaceFailureTag, Args &&...args) : Base(in_place_failure, std::forward<Args>(args)...) {}
+	/**
+	 * Resultが保持する値をコピーする.
+	 * @param[in]	src	コピー元.
+	 * @exception	aslib::NeverEmptyResult::EmptySource	srcが未初期化の場合に発生する.
+	 */
+	explicit
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult(const Result<S, F> &src) : Base(checkedSource(src)) {}
+	/// @overload
+	explicit
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult(Result<S, F> &&src) : Base(std::move(checkedSource(src))) {}
+	/**
+	 * ASLIB_TRYで呼出元へ返すエラー値を保持する.
+	 * @exception	aslib::NeverEmptyResult::EmptySource	未初期化のResultから作ったpropagationの場合に発生する.
+	 */
+	template<typename Ref>
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult(const detail::ResultPropagation<Ref> &propagation) : Base(in_place_failure, static_cast<Ref>(checkedFail(propagation.get()))) {}
+// }}}
+
+public:	// functions / operators {{{
+	/// @return	保持している値が正常値かエラー値か. trueならば正常値.
+	ASLIB_RESULT_CONSTEXPR operator bool() const { return succeeded_; }
+
+	/// @return	同じ値を保持するResult.
+	ASLIB_RESULT_CONSTEXPR operator Result<S, F>() const & {
+		return succeeded_ ? Result<S, F>(in_place_success, storage_.succeededValue) : Result<S, F>(in_place_failure, storage_.failedValue);
+	}
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR operator Result<S, F>() && {
+		return succeeded_ ? Result<S, F>(in_place_success, std::move(storage_.succeededValue)) : Result<S, F>(in_place_failure, std::move(storage_.failedValue));
+	}
+
+	/**
+	 * @return	正常値を保持している場合、その値への参照を返す.
+	 * @exception	aslib::NeverEmptyResult::CantDereference	エラー値を保持している場合に発生する.
+	 */
+	ASLIB_RESULT_CONSTEXPR SucceededType &operator*() { return const_cast<SucceededType &>(const_cast<const My *>(this)->operator*()); }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const SucceededType &operator*() const {
+		if(!succeeded_) { ASLIB_INSTRUMENT(My, instrumentationExceptions, 1); throw CantDereference(); }
+		return storage_.succeededValue;
+	}
+
+	/**
+	 * @return	正常値を保持している場合、その値へのポインタを返す.
+	 * @exception	aslib::NeverEmptyResult::CantDereference	エラー値を保持している場合に発生する.
+	 */
+	ASLIB_RESULT_CONSTEXPR SucceededType *operator->() { return &operator*(); }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const SucceededType *operator->() const { return &operator*(); }
+
+	/**
+	 * @return	エラー値を保持している場合に、その値への参照を返す.
+	 * @exception	aslib::NeverEmptyResult::NotHaveFailedObject	正常値を保持している場合に発生する.
+	 */
+	ASLIB_RESULT_CONSTEXPR FailedType &fail() { return const_cast<FailedType &>(const_cast<const My *>(this)->fail()); }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const FailedType &fail() const {
+		if(!succeeded_) return storage_.failedValue;
+		ASLIB_INSTRUMENT(My, instrumentationExceptions, 1);
+		throw NotHaveFailedObject();
+	}
+
+	/// @return	正常値を保持している場合、その値へのポインタを返す. それ以外の場合はnullptr.
+	ASLIB_RESULT_CONSTEXPR SucceededType *get_if() { return succeeded_ ? &storage_.succeededValue : nullptr; }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const SucceededType *get_if() const { return succeeded_ ? &storage_.succeededValue : nullptr; }
+
+	/// @return	エラー値を保持している場合、その値へのポインタを返す. それ以外の場合はnullptr.
+	ASLIB_RESULT_CONSTEXPR FailedType *fail_if() { return succeeded_ ? nullptr : &storage_.failedValue; }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const FailedType *fail_if() const { return succeeded_ ? nullptr : &storage_.failedValue; }
+
+	/**
+	 * @param[in]	defaultValue	エラー値を保持している場合の値.
+	 * @return	正常値を保持している場合はその値のコピー、それ以外の場合はdefaultValue. 右辺値に対しては、保持している正常値をムーブする.
+	 */
+	template<typename U>
+	ASLIB_RESULT_CONSTEXPR SucceededType value_or(U &&defaultValue) const & {
+		return succeeded_ ? unchecked_value() : static_cast<SucceededType>(std::forward<U>(defaultValue));
+	}
+	/// @overload
+	template<typename U>
+	ASLIB_RESULT_CONSTEXPR SucceededType value_or(U &&defaultValue) && {
+		return succeeded_ ? std::move(unchecked_value()) : static_cast<SucceededType>(std::forward<U>(defaultValue));
+	}
+
+	/**
+	 * 保持している値の種類を確認せずに、正常値へアクセスする. 確認はデバッグビルドのassertのみで行う.
+	 * @return	正常値への参照.
+	 */
+	ASLIB_RESULT_CONSTEXPR SucceededType &unchecked_value() { assert(succeeded_); return storage_.succeededValue; }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const SucceededType &unchecked_value() const { assert(succeeded_); return storage_.succeededValue; }
+
+	/**
+	 * 保持している値の種類を確認せずに、エラー値へアクセスする. 確認はデバッグビルドのassertのみで行う.
+	 * @return	エラー値への参照.
+	 */
+	ASLIB_RESULT_CONSTEXPR FailedType &unchecked_fail() { assert(!succeeded_); return storage_.failedValue; }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const FailedType &unchecked_fail() const { assert(!succeeded_); return storage_.failedValue; }
+
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult &operator=(const SucceededType &rhs) { this->assignSucceeded(rhs); return *this; }
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult &operator=(SucceededType &&rhs) { this->assignSucceeded(std::move(rhs)); return *this; }
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult &operator=(const FailedType &rhs) { this->assignFailed(rhs); return *this; }
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult &operator=(FailedType &&rhs) { this->assignFailed(std::move(rhs)); return *this; }
+
+	/**
+	 * 保持している値を破棄し、正常値を引数から直接構築する.
+	 * 構築中に例外が発生した場合、元の値を保持したままになる.
+	 * @param[in]	args	SucceededTypeのコンストラクタへ渡す引数.
+	 * @return	構築した正常値への参照.
+	 */
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR SucceededType &emplace_success(Args &&...args) { return this->replaceSucceeded(std::forward<Args>(args)...); }
+	/**
+	 * 保持している値を破棄し、エラー値を引数から直接構築する.
+	 * 構築中に例外が発生した場合、元の値を保持したままになる.
+	 * @param[in]	args	FailedTypeのコンストラクタへ渡す引数.
+	 * @return	構築したエラー値への参照.
+	 */
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR FailedType &emplace_failure(Args &&...args) { return this->replaceFailed(std::forward<Args>(args)...); }
+// }}}
+
+public:	// combinators {{{
+	/*
+	 * aslib::Resultと同じコンビネータ. 右辺値に対して呼び出した場合は保持している値をムーブし、左辺値に対してはconst参照で渡す.
+	 * 値の種類は2つのみの為、いずれも1つの分岐で済む.
+	 */
+
+	/**
+	 * 正常値を変換する.
+	 * @param[in]	func	正常値を受け取り、新たな正常値を返す関数オブジェクト.
+	 * @return	正常値を保持していればfuncの戻り値を正常値とするNeverEmptyResult. エラー値を保持していれば、そのエラー値を持つNeverEmptyResult.
+	 */
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult<detail::ResultInvokeType<Func, SucceededType>, FailedType> map(Func &&func) && {
+		typedef NeverEmptyResult<detail::ResultInvokeType<Func, SucceededType>, FailedType> ReturnType;
+		if(succeeded_) return ReturnType(std::forward<Func>(func)(std::move(unchecked_value())));
+		return ReturnType(std::move(unchecked_fail()));
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult<detail::ResultInvokeType<Func, const SucceededType &>, FailedType> map(Func &&func) const & {
+		typedef NeverEmptyResult<detail::ResultInvokeType<Func, const SucceededType &>, FailedType> ReturnType;
+		if(succeeded_) return ReturnType(std::forward<Func>(func)(unchecked_value()));
+		return ReturnType(unchecked_fail());
+	}
+
+	/**
+	 * 正常値を、失敗し得る次の処理へ渡す.
+	 * @param[in]	func	正常値を受け取り、NeverEmptyResult<U, FailedType>またはResult<U, FailedType>を返す関数オブジェクト.
+	 * @return	正常値を保持していればfuncの戻り値. エラー値を保持していれば、そのエラー値を持つfuncの戻り値の型の値.
+	 */
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, SucceededType> and_then(Func &&func) && {
+		typedef detail::ResultInvokeType<Func, SucceededType> ReturnType;
+		if(succeeded_) return std::forward<Func>(func)(std::move(unchecked_value()));
+		return ReturnType(std::move(unchecked_fail()));
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, const SucceededType &> and_then(Func &&func) const & {
+		typedef detail::ResultInvokeType<Func, const SucceededType &> ReturnType;
+		if(succeeded_) return std::forward<Func>(func)(unchecked_value());
+		return ReturnType(unchecked_fail());
+	}
+
+	/**
+	 * エラー値を、回復を試みる処理へ渡す.
+	 * @param[in]	func	エラー値を受け取り、NeverEmptyResult<SucceededType, G>またはResult<SucceededType, G>を返す関数オブジェクト.
+	 * @return	エラー値を保持していればfuncの戻り値. 正常値を保持していれば、その正常値を持つfuncの戻り値の型の値.
+	 */
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, FailedType> or_else(Func &&func) && {
+		typedef detail::ResultInvokeType<Func, FailedType> ReturnType;
+		if(succeeded_) return ReturnType(std::move(unchecked_value()));
+		return std::forward<Func>(func)(std::move(unchecked_fail()));
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, const FailedType &> or_else(Func &&func) const & {
+		typedef detail::ResultInvokeType<Func, const FailedType &> ReturnType;
+		if(succeeded_) return ReturnType(unchecked_value());
+		return std::forward<Func>(func)(unchecked_fail());
+	}
+
+	/**
+	 * エラー値を変換する.
+	 * @param[in]	func	エラー値を受け取り、新たなエラー値を返す関数オブジェクト.
+	 * @return	エラー値を保持していればfuncの戻り値をエラー値とするNeverEmptyResult. 正常値を保持していれば、その正常値を持つNeverEmptyResult.
+	 */
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult<SucceededType, detail::ResultInvokeType<Func, FailedType>> map_error(Func &&func) && {
+		typedef NeverEmptyResult<SucceededType, detail::ResultInvokeType<Func, FailedType>> ReturnType;
+		if(succeeded_) return ReturnType(std::move(unchecked_value()));
+		return ReturnType(std::forward<Func>(func)(std::move(unchecked_fail())));
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR NeverEmptyResult<SucceededType, detail::ResultInvokeType<Func, const FailedType &>> map_error(Func &&func) const & {
+		typedef NeverEmptyResult<SucceededType, detail::ResultInvokeType<Func, const FailedType &>> ReturnType;
+		if(succeeded_) return ReturnType(unchecked_value());
+		return ReturnType(std::forward<Func>(func)(unchecked_fail()));
+	}
+// }}}
+
+private:	// inner functions {{{
+	/// @return	*failed. failedがnullptrならばEmptySourceを送出する.
+	template<typename T>
+	static ASLIB_RESULT_CONSTEXPR T &checkedFail(T *failed) {
+		if(!failed) { ASLIB_INSTRUMENT(My, instrumentationExceptions, 1); throw EmptySource(); }
+		return *failed;
+	}
+	/// @return	src. srcが未初期化ならばEmptySourceを送出する. 格納する値の構築前に確認する為に用いる.
+	template<typename R>
+	static ASLIB_RESULT_CONSTEXPR R &checkedSource(R &src) {
+		if(!src.get_if()) checkedFail(src.fail_if());
+		return src;
+	}
+// }}}
+
+private:	// fields {{{
+	using Base::storage_;
+	using Base::succeeded_;
+// }}}
+};
+
+namespace detail {
+
+/// @return	srcのエラー値を呼出元へ返す為のResultPropagation. 右辺値ならばムーブする.
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR ResultPropagation<F &&> resultPropagate(NeverEmptyResult<S, F> &&src) { return ResultPropagation<F &&>(src.fail_if()); }
+/// @overload
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR ResultPropagation<const F &> resultPropagate(const NeverEmptyResult<S, F> &src) { return ResultPropagation<const F &>(src.fail_if()); }
+
+/// ASLIB_TRY_ASSIGNで取り出す正常値. 右辺値のNeverEmptyResultからはムーブし、左辺値からは参照を返す.
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR S &&resultTakeValue(NeverEmptyResult<S, F> &&src) { return std::move(src.unchecked_value()); }
+/// @overload
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR S &resultTakeValue(NeverEmptyResult<S, F> &src) { return src.unchecked_value(); }
+/// @overload
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR const S &resultTakeValue(const NeverEmptyResult<S, F> &src) { return src.unchecked_value(); }
+
+}	// namespace detail
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_NEVER_EMPTY_RESULT_HPP_
@@ -0,0 +1,509 @@
+﻿/**
+ * @file
+ * 正常値と複数種類のエラー値のいずれかを保持するaslib::Outcome.
+ */
+#ifndef ASLIB_INCLUDED_OUTCOME_HPP_
+#define ASLIB_INCLUDED_OUTCOME_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <aslib/Result.hpp>
+
+namespace aslib {
+
+/// 指定した型の値を直接構築するaslib::Outcomeのコンストラクタを選択する為のタグ型.
+template<typename T>
+struct InPlaceTypeTag { constexpr explicit InPlaceTypeTag() {} };
+
+namespace detail {
+
+template<bool... Bs>
+struct OutcomeBools {};
+/// Bsが全てtrueならばtrue.
+template<bool... Bs>
+struct OutcomeAllOf : std::is_same<OutcomeBools<true, Bs...>, OutcomeBools<Bs..., true> > {};
+
+/// Nsの最大値.
+template<std::size_t... Ns>
+struct OutcomeMax;
+template<std::size_t N>
+struct OutcomeMax<N> : std::integral_constant<std::size_t, N> {};
+template<std::size_t N, std::size_t M, std::size_t... Ns>
+struct OutcomeMax<N, M, Ns...> : OutcomeMax<(N > M ? N : M), Ns...> {};
+
+/// TがTsの何番目の型か. 含まれなければsizeof...(Ts).
+template<typename T, typename... Ts>
+struct OutcomeIndexOf : std::integral_constant<std::size_t, 0> {};
+template<typename T, typename... Rest>
+struct OutcomeIndexOf<T, T, Rest...> : std::integral_constant<std::size_t, 0> {};
+template<typename T, typename First, typename... Rest>
+struct OutcomeIndexOf<T, First, Rest...> : std::integral_constant<std::size_t, 1 + OutcomeIndexOf<T, Rest...>::value> {};
+
+/// TがTsに含まれる数.
+template<typename T, typename... Ts>
+struct OutcomeCount : std::integral_constant<std::size_t, 0> {};
+template<typename T, typename First, typename... Rest>
+struct OutcomeCount<T, First, Rest...> : std::integral_constant<std::size_t, std::is_same<T, First>::value + OutcomeCount<T, Rest...>::value> {};
+
+/// Tsの先頭の型.
+template<typename First, typename... Rest>
+struct OutcomeFirst { typedef First type; };
+
+/**
+ * Outcomeの1つの選択肢の型Tに対する操作. 値はvoid *で扱い、選択肢毎の関数テーブルに並べる.
+ * Tがvoidの特殊化は、値を保持していない状態に対する操作で、何もしない.
+ */
+template<typename T>
+struct OutcomeAlternative {
+	static void destroy(void *p) { static_cast<T *>(p)->~T(); }
+	static void copy(const void *src, void *dst) { ::new(dst) T(*static_cast<const T *>(src)); }
+	static void move(void *src, void *dst) { ::new(dst) T(std::move(*static_cast<T *>(src))); }
+	static void assign(const void *src, void *dst) { *static_cast<T *>(dst) = *static_cast<const T *>(src); }
+	static void assignMove(void *src, void *dst) { *static_cast<T *>(dst) = std::move(*static_cast<T *>(src)); }
+};
+template<>
+struct OutcomeAlternative<void> {
+	static void destroy(void *) {}
+	static void copy(const void *, void *) {}
+	static void move(void *, void *) {}
+	static void assign(const void *, void *) {}
+	static void assignMove(void *, void *) {}
+};
+
+/// Outcome::visitの関数テーブルの要素. pが指すRef型の値でfuncを呼び出す.
+template<typename Return, typename Func, typename Ref>
+struct OutcomeVisitor {
+	static Return visit(Func &&func, void *p) {
+		return std::forward<Func>(func)(static_cast<Ref>(*static_cast<typename std::remove_reference<Ref>::type *>(p)));
+	}
+};
+
+/**
+ * aslib::Outcomeの値を格納する領域と、その操作.
+ * 全ての選択肢の値を1つの領域に重ねて格納し、保持している選択肢の番号を1バイトで表す. 番号sizeof...(Ts)は未初期化を表す.
+ * 選択肢毎の操作は番号で引く関数テーブルで行う為、選択肢の数に依らず分岐は1回の間接呼出になる.
+ */
+template<typename... Ts>
+class OutcomeStorage {
+protected:	// types {{{
+	/// 未初期化を表す番号.
+	static const unsigned char uninit = static_cast<unsigned char>(sizeof...(Ts));
+// }}}
+
+protected:	// constructors {{{
+	OutcomeStorage() : kind_(uninit) {}
+// }}}
+
+protected:	// inner functions {{{
+	/// @return	保持しているT型の値. Tを保持している事.
+	template<typename T>
+	T &as() { return *reinterpret_cast<T *>(&storage_); }
+	/// @overload
+	template<typename T>
+	const T &as() const { return *reinterpret_cast<const T *>(&storage_); }
+
+	/// @return	T型の値を保持していればtrue.
+	template<typename T>
+	bool holds() const { return kind_ == OutcomeIndexOf<T, Ts...>::value; }
+
+	/**
+	 * 引数から直接T型の値を構築する.
+	 * 呼出時点で値を保持していない事.
+	 * @return	構築した値への参照.
+	 */
+	template<typename T, typename... Args>
+	T &construct(Args &&...args) {
+		assert(kind_ == uninit);
+		T *p = ::new(static_cast<void *>(&storage_)) T(std::forward<Args>(args)...);
+		kind_ = static_cast<unsigned char>(OutcomeIndexOf<T, Ts...>::value);
+		return *p;
+	}
+
+	/**
+	 * T型の値を代入する.
+	 * T型の値を保持していれば、Tの代入演算子で既存の値に代入する. それ以外の場合は、保持している値を破棄して直接構築する.
+	 */
+	template<typename T, typename U>
+	void assignAs(U &&src) {
+		if(holds<T>()) {
+			as<T>() = std::forward<U>(src);
+			return;
+		}
+		destroy();
+		construct<T>(std::forward<U>(src));
+	}
+
+	/// 他のOutcomeStorageと同じ値を、格納型のコピーコンストラクタで構築する.
+	void allocate(const OutcomeStorage &src) {
+		assert(kind_ == uninit);
+		static void (*const table[])(const void *, void *) = { &OutcomeAlternative<Ts>::copy..., &OutcomeAlternative<void>::copy };
+		table[src.kind_](&src.storage_, &storage_);
+		kind_ = src.kind_;
+	}
+	/// 他のOutcomeStorageと同じ値を、格納型のムーブコンストラクタで構築する.
+	void allocate_move(OutcomeStorage &&src) {
+		assert(kind_ == uninit);
+		static void (*const table[])(void *, void *) = { &OutcomeAlternative<Ts>::move..., &OutcomeAlternative<void>::move };
+		table[src.kind_](&src.storage_, &storage_);
+		kind_ = src.kind_;
+	}
+
+	/**
+	 * 他のOutcomeStorageが保持する値を代入する.
+	 * 同じ選択肢であれば格納型の代入演算子で代入し、異なれば保持している値を破棄してコピー構築する.
+	 */
+	void substitute(const OutcomeStorage &src) {
+		if(kind_ != src.kind_) {
+			destroy();
+			allocate(src);
+			return;
+		}
+		static void (*const table[])(const void *, void *) = { &OutcomeAlternative<Ts>::assign..., &OutcomeAlternative<void>::assign };
+		table[kind_](&src.storage_, &storage_);
+	}
+	/// @copydoc	substitute
+	void substitute_move(OutcomeStorage &&src) {
+		if(kind_ != src.kind_) {
+			destroy();
+			allocate_move(std::move(src));
+			return;
+		}
+		static void (*const table[])(void *, void *) = { &OutcomeAlternative<Ts>::assignMove..., &OutcomeAlternative<void>::assignMove };
+		table[kind_](&src.storage_, &storage_);
+	}
+
+	/// 内部に保持している値を破棄する.
+	void destroy() {
+		static void (*const table[])(void *) = { &OutcomeAlternative<Ts>::destroy..., &OutcomeAlternative<void>::destroy };
+		table[kind_](&storage_);
+		kind_ = uninit;
+	}
+// }}}
+
+protected:	// fields {{{
+	typename std::aligned_storage<OutcomeMax<sizeof(Ts)...>::value, OutcomeMax<std::alignment_of<Ts>::value...>::value>::type storage_;
+	unsigned char kind_;
+// }}}
+};
+
+/// 格納型が自明なデストラクタを持たない場合に、値を破棄するデストラクタを定義する.
+template<bool isTriviallyDestructible, typename... Ts>
+class OutcomeDestructorBase : public OutcomeStorage<Ts...> {
+protected:
+	OutcomeDestructorBase() = default;
+	OutcomeDestructorBase(const OutcomeDestructorBase &) = default;
+	OutcomeDestructorBase(OutcomeDestructorBase &&) = default;
+	OutcomeDestructorBase &operator=(const OutcomeDestructorBase &) = default;
+	OutcomeDestructorBase &operator=(OutcomeDestructorBase &&) = default;
+	~OutcomeDestructorBase() { this->destroy(); }
+};
+template<typename... Ts>
+class OutcomeDestructorBase<true, Ts...> : public OutcomeStorage<Ts...> {};
+
+/// 格納型のコピー・ムーブが自明でない場合に、格納型に応じたコピー・ムーブを定義する.
+template<bool isTriviallyCopyable, typename... Ts>
+class OutcomeCopyBase : public OutcomeDestructorBase<OutcomeAllOf<std::is_trivially_destructible<Ts>::value...>::value, Ts...> {
+	typedef OutcomeDestructorBase<OutcomeAllOf<std::is_trivially_destructible<Ts>::value...>::value, Ts...> Base;
+
+protected:
+	OutcomeCopyBase() = default;
+	/// @param[in]	src	コピー元.
+	OutcomeCopyBase(const OutcomeCopyBase &src) : Base() {
+		this->allocate(src);
+	}
+	/// @param[in]	src	コピー元.
+	OutcomeCopyBase(OutcomeCopyBase &&src) noexcept(OutcomeAllOf<std::is_nothrow_move_constructible<Ts>::value...>::value) : Base() {
+		this->allocate_move(std::move(src));
+	}
+
+	OutcomeCopyBase &operator=(const OutcomeCopyBase &rhs) {
+		if(this != &rhs) this->substitute(rhs);
+		return *this;
+	}
+	OutcomeCopyBase &operator=(OutcomeCopyBase &&rhs) {
+		if(this != &rhs) this->substitute_move(std::move(rhs));
+		return *this;
+	}
+};
+template<typename... Ts>
+class OutcomeCopyBase<true, Ts...> : public OutcomeDestructorBase<true, Ts...> {};
+
+}	// namespace detail
+
+/**
+ * 正常値と、複数種類のエラー値のいずれかを保持する型. エラーの種類毎に異なる型の値を返す関数の戻り値として用いる.
+ * Result<S, Result<F1, F2> >のように入れ子にする代わりに用いると、全ての値を1つの領域に重ねて格納し、保持している値の種類を1バイトで表す為、サイズと分岐が入れ子の段数に比例しない.
+ * @code
+ *	aslib::Outcome<Message, ProtocolError, IoError, Pending> decode(Buffer &buffer);
+ *
+ *	aslib::Outcome<Message, ProtocolError, IoError, Pending> r = decode(buffer);
+ *	if(r) handle(*r);	// 正常値の扱いはaslib::Resultと同じ
+ *	else if(const IoError *e = r.fail_if<IoError>()) reconnect(*e);
+ *
+ *	r.visit(Handler());	// Handlerは、MessageとProtocolError、IoError、Pendingの各々を引数に取れる関数オブジェクト
+ * @endcode
+ * いずれの値も保持していない、未初期化の状態を持つ. デフォルトコンストラクタで構築した場合と、値の構築中に例外が発生した場合に未初期化になる.
+ * エラー値の型が1つのOutcome<S, F>は、Result<S, F>と同じメンバ関数で扱える.
+ * 全ての格納型が自明にコピー・破棄出来る型であれば、Outcome自身も自明にコピー・破棄出来る.
+ * @param[in]	S	正常値の型.
+ * @param[in]	F	エラー値の型. 1つ以上254個以下で、Sも含めて全て異なる型である事. 参照型とvoidは指定出来ない.
+ * @sa	aslib::Result
+ */
+template<typename S, typename... F>
+class Outcome : private detail::OutcomeCopyBase<
+	detail::OutcomeAllOf<detail::IsTriviallyCopyableForResult<S>::value, detail::IsTriviallyCopyableForResult<F>::value...>::value, S, F...> {
+	typedef detail::OutcomeCopyBase<
+		detail::OutcomeAllOf<detail::IsTriviallyCopyableForResult<S>::value, detail::IsTriviallyCopyableForResult<F>::value...>::value, S, F...> Base;
+
+	static_assert(sizeof...(F) >= 1 && sizeof...(F) < 255, "Outcome needs 1 to 254 failure types.");
+	static_assert(detail::OutcomeAllOf<(detail::OutcomeCount<S, S, F...>::value == 1), (detail::OutcomeCount<F, S, F...>::value == 1)...>::value, "The alternatives of Outcome must be distinct types.");
+	static_assert(detail::OutcomeAllOf<std::is_object<S>::value, std::is_object<F>::value...>::value, "Outcome does not support references or void.");
+
+	/// Uがエラー値の型ならば、そのエラー値の番号(1以上).
+	template<typename U>
+	struct FailureIndex : std::integral_constant<std::size_t, 1 + detail::OutcomeIndexOf<typename std::decay<U>::type, F...>::value> {};
+	/// Uがエラー値の型ならばtrue.
+	template<typename U>
+	struct IsFailure : std::integral_constant<bool, (FailureIndex<U>::value <= sizeof...(F))> {};
+
+public:	// public types {{{
+	/// 正常値の型.
+	typedef S SucceededType;
+	/// 先頭のエラー値の型. Result<S, F>と同じく、型を指定しないfail()等で用いる.
+	typedef typename detail::OutcomeFirst<F...>::type FailedType;
+
+	/// 未初期化の場合のindex()の値.
+	static const std::size_t npos = sizeof...(F) + 1;
+
+	/// 正常値を保持していないOutcomeをdereference、または->演算子を利用した場合に発生する例外.
+	struct CantDereference : std::runtime_error {
+		CantDereference() : runtime_error("Failed outcome value.") {}
+	};
+	/// 指定した型のエラー値を保持していない事を表す例外.
+	struct NotHaveFailedObject : std::runtime_error {
+		NotHaveFailedObject() : runtime_error("Not have the Failed object.") {}
+	};
+	/// 未初期化のOutcomeに対してvisit()を呼び出した場合に発生する例外.
+	struct CantVisit : std::runtime_error {
+		CantVisit() : runtime_error("Uninitialized outcome value.") {}
+	};
+// }}}
+
+private:	// private types {{{
+	using Base::uninit;
+// }}}
+
+public:	// constructors / destructor {{{
+	/// コピー・ムーブ・破棄は、格納型に応じてdetail::OutcomeCopyBase及びdetail::OutcomeDestructorBaseで定義する.
+	Outcome() {}
+	/// @param[in]	src	正常値.
+	Outcome(const SucceededType &src) { this->template construct<S>(src); }
+	/// @param[in]	src	正常値.
+	Outcome(SucceededType &&src) { this->template construct<S>(std::move(src)); }
+	/// @param[in]	src	エラー値. 型はいずれかのエラー値の型と一致する事.
+	template<typename U, typename = typename std::enable_if<IsFailure<U>::value>::type>
+	Outcome(U &&src) { this->template construct<typename std::decay<U>::type>(std::forward<U>(src)); }
+	/**
+	 * Resultの値を引き継ぐ. Resultのエラー値の型は、いずれかのエラー値の型と一致する事.
+	 * @param[in]	src	コピー元. 未初期化ならば未初期化になる.
+	 */
+	template<typename G, typename = typename std::enable_if<IsFailure<G>::value>::type>
+	Outcome(const Result<S, G> &src) {
+		if(const S *value = src.get_if()) this->template construct<S>(*value);
+		else if(const G *failure = src.fail_if()) this->template construct<G>(*failure);
+	}
+	/// @overload
+	template<typename G, typename = typename std::enable_if<IsFailure<G>::value>::type>
+	Outcome(Result<S, G> &&src) {
+		if(S *value = src.get_if()) this->template construct<S>(std::move(*value));
+		else if(G *failure = src.fail_if()) this->template construct<G>(std::move(*failure));
+	}
+	/**
+	 * 正常値を引数から直接構築する.
+	 * @param[in]	args	SucceededTypeのコンストラクタへ渡す引数.
+	 */
+	template<typename... Args>
+	explicit
+	Outcome(InPlaceSuccessTag, Args &&...args) { this->template construct<S>(std::forward<Args>(args)...); }
+	/**
+	 * T型の値を引数から直接構築する.
+	 * @code
+	 *	return aslib::Outcome<Message, ProtocolError, Pending>(aslib::InPlaceTypeTag<ProtocolError>(), code, offset);
+	 * @endcode
+	 * @param[in]	args	Tのコンストラクタへ渡す引数.
+	 */
+	template<typename T, typename... Args>
+	explicit
+	Outcome(InPlaceTypeTag<T>, Args &&...args) { this->template construct<T>(std::forward<Args>(args)...); }
+// }}}
+
+public:	// functions / operators {{{
+	/// @return	保持している値が正常値ならばtrue.
+	operator bool() const { return kind_ == 0; }
+	/// @return	保持している値の番号. 正常値ならば0、Fのi番目(0から数える)のエラー値ならばi + 1、未初期化ならばnpos.
+	std::size_t index() const { return kind_; }
+	/// @return	T型の値を保持していればtrue.
+	template<typename T>
+	bool holds() const { return Base::template holds<T>(); }
+
+	/**
+	 * @return	正常値を保持している場合、その値への参照を返す.
+	 * @exception	aslib::Outcome::CantDereference	正常値を保持していない場合に発生する.
+	 */
+	SucceededType &operator*() { return const_cast<SucceededType &>(const_cast<const Outcome *>(this)->operator*()); }
+	/// @overload
+	const SucceededType &operator*() const {
+		if(!operator bool()) throw CantDereference();
+		return this->template as<S>();
+	}
+	/// @sa	operator*
+	SucceededType *operator->() { return &operator*(); }
+	/// @overload
+	const SucceededType *operator->() const { return &operator*(); }
+
+	/**
+	 * @param[in]	T	エラー値の型. 省略時は先頭のエラー値の型.
+	 * @return	T型のエラー値を保持している場合に、その値への参照を返す.
+	 * @exception	aslib::Outcome::NotHaveFailedObject	T型のエラー値を保持していない場合に発生する.
+	 */
+	template<typename T = FailedType>
+	T &fail() { return const_cast<T &>(const_cast<const Outcome *>(this)->template fail<T>()); }
+	/// @overload
+	template<typename T = FailedType>
+	const T &fail() const {
+		static_assert(IsFailure<T>::value, "T must be one of the failure types.");
+		if(!holds<T>()) throw NotHaveFailedObject();
+		return this->template as<T>();
+	}
+
+	/// @return	正常値を保持している場合はその値へのポインタ. それ以外の場合はnullptr.
+	SucceededType *get_if() { return operator bool() ? &this->template as<S>() : nullptr; }
+	/// @overload
+	const SucceededType *get_if() const { return operator bool() ? &this->template as<S>() : nullptr; }
+	/// @return	T型のエラー値を保持している場合はその値へのポインタ. それ以外の場合はnullptr.
+	template<typename T = FailedType>
+	T *fail_if() { static_assert(IsFailure<T>::value, "T must be one of the failure types."); return holds<T>() ? &this->template as<T>() : nullptr; }
+	/// @overload
+	template<typename T = FailedType>
+	const T *fail_if() const { static_assert(IsFailure<T>::value, "T must be one of the failure types."); return holds<T>() ? &this->template as<T>() : nullptr; }
+
+	/**
+	 * @param[in]	defaultValue	正常値を保持していない場合に返す値.
+	 * @return	正常値を保持している場合はその値のコピー、それ以外の場合はdefaultValueから変換した値.
+	 */
+	template<typename U>
+	SucceededType value_or(U &&defaultValue) const & {
+		return operator bool() ? unchecked_value() : static_cast<SucceededType>(std::forward<U>(defaultValue));
+	}
+	/// @overload
+	template<typename U>
+	SucceededType value_or(U &&defaultValue) && {
+		return operator bool() ? std::move(unchecked_value()) : static_cast<SucceededType>(std::forward<U>(defaultValue));
+	}
+
+	/// @return	保持している正常値. 正常値を保持している事.
+	SucceededType &unchecked_value() { assert(kind_ == 0); return this->template as<S>(); }
+	/// @overload
+	const SucceededType &unchecked_value() const { assert(kind_ == 0); return this->template as<S>(); }
+	/// @return	保持しているT型のエラー値. T型のエラー値を保持している事.
+	template<typename T = FailedType>
+	T &unchecked_fail() { assert(holds<T>()); return this->template as<T>(); }
+	/// @overload
+	template<typename T = FailedType>
+	const T &unchecked_fail() const { assert(holds<T>()); return this->template as<T>(); }
+
+	/// @param[in]	rhs	正常値.
+	Outcome &operator=(const SucceededType &rhs) { this->template assignAs<S>(rhs); return *this; }
+	/// @param[in]	rhs	正常値.
+	Outcome &operator=(SucceededType &&rhs) { this->template assignAs<S>(std::move(rhs)); return *this; }
+	/// @param[in]	rhs	エラー値.
+	template<typename U, typename = typename std::enable_if<IsFailure<U>::value>::type>
+	Outcome &operator=(U &&rhs) { this->template assignAs<typename std::decay<U>::type>(std::forward<U>(rhs)); return *this; }
+
+	/**
+	 * 保持している値を破棄し、正常値を引数から直接構築する.
+	 * 構築中に例外が発生した場合、未初期化の状態になる.
+	 * @return	構築した正常値への参照.
+	 */
+	template<typename... Args>
+	SucceededType &emplace_success(Args &&...args) {
+		this->destroy();
+		return this->template construct<S>(std::forward<Args>(args)...);
+	}
+	/**
+	 * 保持している値を破棄し、T型のエラー値を引数から直接構築する.
+	 * 構築中に例外が発生した場合、未初期化の状態になる.
+	 * @param[in]	T	エラー値の型. 省略時は先頭のエラー値の型.
+	 * @return	構築したエラー値への参照.
+	 */
+	template<typename T = FailedType, typename... Args>
+	T &emplace_failure(Args &&...args) {
+		static_assert(IsFailure<T>::value, "T must be one of the failure types.");
+		this->destroy();
+		return this->template construct<T>(std::forward<Args>(args)...);
+	}
+
+	/**
+	 * 保持している値でfuncを呼び出す.
+	 * 呼び出し先は保持している値の番号で関数テーブルを引いて決める為、選択肢の数に依らず1回の間接呼出になる.
+	 * @code
+	 *	struct Handler {
+	 *		void operator()(const Message &m) const;
+	 *		template<typename Failure> void operator()(const Failure &f) const;	// 全てのエラー値
+	 *	};
+	 * @endcode
+	 * @param[in]	func	SucceededTypeと全てのエラー値の型を引数に取れる関数オブジェクト. 戻り値は、正常値で呼び出した場合の戻り値の型に変換する.
+	 * @return	funcの戻り値.
+	 * @exception	aslib::Outcome::CantVisit	未初期化の場合に発生する.
+	 */
+	template<typename Func>
+	auto visit(Func &&func) & -> decltype(std::forward<Func>(func)(std::declval<S &>())) {
+		typedef decltype(std::forward<Func>(func)(std::declval<S &>())) Return;
+		static Return (*const table[])(Func &&, void *) = {
+			&detail::OutcomeVisitor<Return, Func, S &>::visit, &detail::OutcomeVisitor<Return, Func, F &>::visit..., &cantVisit<Return, Func>
+		};
+		return table[kind_](std::forward<Func>(func), &this->storage_);
+	}
+	/// @overload
+	template<typename Func>
+	auto visit(Func &&func) const & -> decltype(std::forward<Func>(func)(std::declval<const S &>())) {
+		typedef decltype(std::forward<Func>(func)(std::declval<const S &>())) Return;
+		static Return (*const table[])(Func &&, void *) = {
+			&detail::OutcomeVisitor<Return, Func, const S &>::visit, &detail::OutcomeVisitor<Return, Func, const F &>::visit..., &cantVisit<Return, Func>
+		};
+		return table[kind_](std::forward<Func>(func), const_cast<void *>(static_cast<const void *>(&this->storage_)));
+	}
+	/// @overload
+	/// 保持している値を右辺値としてfuncへ渡す.
+	template<typename Func>
+	auto visit(Func &&func) && -> decltype(std::forward<Func>(func)(std::declval<S &&>())) {
+		typedef decltype(std::forward<Func>(func)(std::declval<S &&>())) Return;
+		static Return (*const table[])(Func &&, void *) = {
+			&detail::OutcomeVisitor<Return, Func, S &&>::visit, &detail::OutcomeVisitor<Return, Func, F &&>::visit..., &cantVisit<Return, Func>
+		};
+		return table[kind_](std::forward<Func>(func), &this->storage_);
+	}
+// }}}
+
+private:	// inner functions {{{
+	/// 未初期化の場合のvisit()の関数テーブルの要素.
+	template<typename Return, typename Func>
+	static Return cantVisit(Func &&, void *) { throw CantVisit(); }
+// }}}
+
+private:	// fields {{{
+	using Base::kind_;
+// }}}
+};
+
+template<typename S, typename... F>
+const std::size_t Outcome<S, F...>::npos;
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_OUTCOME_HPP_
@@ -0,0 +1,440 @@
+﻿/**
+ * @file
+ */
+#ifndef ASLIB_INCLUDED_POLYVECTOR_HPP_
+#define ASLIB_INCLUDED_POLYVECTOR_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <aslib/DeepCopyPtr.hpp>
+
+namespace aslib {
+
+namespace detail {
+
+/// PolyVectorの要素1つ分の情報.
+struct PolyVectorEntry {
+	/// 領域の先頭からオブジェクトまでのオフセット.
+	std::size_t offset;
+	/// オブジェクトの動的な型に応じた操作.
+	const DeepCopyOperations *operations;
+	/// オブジェクトが自明にコピー出来る型ならばtrue. memcpyでコピー・移動する.
+	bool trivial;
+};
+
+/**
+ * PolyVectorのイテレータ.
+ * @param[in]	Value	要素の型. const修飾されていても良い.
+ */
+template<typename Value>
+class PolyVectorIterator {
+	template<typename> friend class PolyVectorIterator;
+	typedef typename std::conditional<std::is_const<Value>::value, const char, char>::type Byte;
+
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef typename std::remove_const<Value>::type value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef Value *pointer;
+	typedef Value &reference;
+
+	PolyVectorIterator() : entry_(0), buffer_(0) {}
+	PolyVectorIterator(const PolyVectorEntry *entry, Byte *buffer) : entry_(entry), buffer_(buffer) {}
+	/// 非constなイテレータからの変換.
+	template<typename Other, typename = typename std::enable_if<std::is_convertible<Other *, Value *>::value>::type>
+	PolyVectorIterator(const PolyVectorIterator<Other> &src) : entry_(src.entry_), buffer_(src.buffer_) {}
+
+	reference operator*() const { return *reinterpret_cast<Value *>(buffer_ + entry_->offset); }
+	pointer operator->() const { return &operator*(); }
+	reference operator[](difference_type n) const { return *(*this + n); }
+
+	PolyVectorIterator &operator++() { ++entry_; return *this; }
+	PolyVectorIterator operator++(int) { PolyVectorIterator old(*this); ++entry_; return old; }
+	PolyVectorIterator &operator--() { --entry_; return *this; }
+	PolyVectorIterator operator--(int) { PolyVectorIterator old(*this); --entry_; return old; }
+	PolyVectorIterator &operator+=(difference_type n) { entry_ += n; return *this; }
+	PolyVectorIterator &operator-=(difference_type n) { entry_ -= n; return *this; }
+	PolyVectorIterator operator+(difference_type n) const { return PolyVectorIterator(entry_ + n, buffer_); }
+	PolyVectorIterator operator-(difference_type n) const { return PolyVectorIterator(entry_ - n, buffer_); }
+	difference_type operator-(const PolyVectorIterator &rhs) const { return entry_ - rhs.entry_; }
+
+	bool operator==(const PolyVectorIterator &rhs) const { return entry_ == rhs.entry_; }
+	bool operator!=(const PolyVectorIterator &rhs) const { return entry_ != rhs.entry_; }
+	bool operator<(const PolyVectorIterator &rhs) const { return entry_ < rhs.entry_; }
+	bool operator>(const PolyVectorIterator &rhs) const { return entry_ > rhs.entry_; }
+	bool operator<=(const PolyVectorIterator &rhs) const { return entry_ <= rhs.entry_; }
+	bool operator>=(const PolyVectorIterator &rhs) const { return entry_ >= rhs.entry_; }
+
+private:
+	const PolyVectorEntry *entry_;
+	Byte *buffer_;
+};
+
+}	// namespace detail
+
+/**
+ * Baseの派生クラスのオブジェクトを、1つの連続した領域に格納するコンテナ.
+ * std::vector<DeepCopyPtr<Base> >と同じく値のように振る舞い、コピー時には各要素をその動的な型のままコピーする(スライシングは起きない).
+ * 一方で各要素はヒープ上に散らばらず、追加した順に1つの領域へ詰めて置かれる為、走査はメモリ上を順に辿る.
+ * 要素の操作にはDeepCopyPtrと同じ型毎の関数テーブルを用いる為、要素毎に仮想関数clone()等を用意する必要は無い.
+ * コピーは領域と要素情報の配列をそれぞれ1度で確保し、全ての要素が自明にコピー出来る型であれば領域を一括してコピーする.
+ * 領域を拡張する際は、例外を送出しないムーブコンストラクタを持つ要素はムーブし、それ以外はコピーする. その為、拡張中に例外が発生しても元の要素は変わらない.
+ * 拡張や要素の追加により、要素のアドレスは変わり得る.
+ * @param[in]	Base	要素の型. 格納するオブジェクトはこの型かその派生クラスで、アライメントはstd::max_align_t以下でなければならない.
+ * @warning	DeepCopyPtrと同じく、Baseのサブオブジェクトは格納するオブジェクトの先頭に位置していなければならない.
+ * @sa	aslib::DeepCopyPtr
+ */
+template<typename Base>
+class PolyVector {
+	typedef detail::PolyVectorEntry Entry;
+	typedef detail::DeepCopyOperations Operations;
+
+public:	// public types {{{
+	typedef Base value_type;
+	typedef Base &reference;
+	typedef const Base &const_reference;
+	typedef std::size_t size_type;
+	typedef detail::PolyVectorIterator<Base> iterator;
+	typedef detail::PolyVectorIterator<const Base> const_iterator;
+
+	/// 動的な型の分からないオブジェクト(要素ではない、派生クラスを指すBaseの参照)をコピーしようとした場合に発生する例外.
+	struct UnknownDynamicType : std::runtime_error {
+		UnknownDynamicType() : runtime_error("The dynamic type of the object is unknown.") {}
+	};
+// }}}
+
+public:	// constructors / destructor {{{
+	PolyVector() : buffer_(0), used_(0), capacity_(0), nonTrivial_(0) {}
+
+	/**
+	 * コピーコンストラクタ. 各要素を、その動的な型のままコピーする.
+	 * @param[in]	src	コピー元.
+	 */
+	PolyVector(const PolyVector &src)
+		: entries_(src.entries_), buffer_(0), used_(0), capacity_(0), nonTrivial_(src.nonTrivial_)
+	{
+		if(src.used_ == 0) return;
+		buffer_ = allocate(src.used_);
+		capacity_ = src.used_;
+		if(nonTrivial_ == 0) {
+			std::memcpy(buffer_, src.buffer_, src.used_);
+			used_ = src.used_;
+			return;
+		}
+
+		std::size_t copied = 0;
+		try {
+			for(; copied < entries_.size(); ++copied) {
+				const Entry &e = entries_[copied];
+				e.operations->copyTo(src.buffer_ + e.offset, buffer_ + e.offset);
+			}
+		} catch(...) {
+			destroyRange(buffer_, 0, copied);
+			deallocate(buffer_);
+			throw;
+		}
+		used_ = src.used_;
+	}
+
+	/**
+	 * ムーブコンストラクタ. 領域の所有権を移すのみで、要素のムーブは行わない.
+	 * @param[in,out]	src	ムーブ元. 空になる.
+	 */
+	PolyVector(PolyVector &&src) noexcept
+		: entries_(std::move(src.entries_)), buffer_(src.buffer_), used_(src.used_), capacity_(src.capacity_), nonTrivial_(src.nonTrivial_)
+	{
+		src.entries_.clear();
+		src.buffer_ = 0;
+		src.used_ = src.capacity_ = src.nonTrivial_ = 0;
+	}
+
+	~PolyVector() {
+		clear();
+		deallocate(buffer_);
+	}
+// }}}
+
+public:	// functions / operators {{{
+	PolyVector &operator=(const PolyVector &rhs) {
+		if(this != &rhs) PolyVector(rhs).swap(*this);
+		return *this;
+	}
+	PolyVector &operator=(PolyVector &&rhs) noexcept {
+		if(this != &rhs) PolyVector(std::move(rhs)).swap(*this);
+		return *this;
+	}
+
+	void swap(PolyVector &other) noexcept {
+		entries_.swap(other.entries_);
+		std::swap(buffer_, other.buffer_);
+		std::swap(used_, other.used_);
+		std::swap(capacity_, other.capacity_);
+		std::swap(nonTrivial_, other.nonTrivial_);
+	}
+
+	/// @return	要素数.
+	size_type size() const { return entries_.size(); }
+	/// @return	要素を持たなければtrue.
+	bool empty() const { return entries_.empty(); }
+	/// @return	要素が使用している領域のバイト数. 要素間のアライメントの為の隙間を含む.
+	size_type bytes() const { return used_; }
+
+	reference operator[](size_type index) { return *element(index); }
+	const_reference operator[](size_type index) const { return *element(index); }
+	reference front() { assert(!empty()); return *element(0); }
+	const_reference front() const { assert(!empty()); return *element(0); }
+	reference back() { assert(!empty()); return *element(size() - 1); }
+	const_reference back() const { assert(!empty()); return *element(size() - 1); }
+
+	iterator begin() { return iterator(entries_.data(), buffer_); }
+	iterator end() { return iterator(entries_.data() + entries_.size(), buffer_); }
+	const_iterator begin() const { return const_iterator(entries_.data(), buffer_); }
+	const_iterator end() const { return const_iterator(entries_.data() + entries_.size(), buffer_); }
+
+	/**
+	 * 末尾にSomeType型のオブジェクトを構築する.
+	 * @param[in]	SomeType	構築するオブジェクトの型. Base、またはその派生クラス.
+	 * @param[in]	args	SomeTypeのコンストラクタに渡す引数.
+	 * @return	構築したオブジェクト.
+	 */
+	template<typename SomeType, typename... Args>
+	SomeType &emplace_back(Args &&...args) {
+		static_assert(std::is_base_of<Base, SomeType>::value || std::is_same<Base, SomeType>::value, "SomeType must derive from Base.");
+		static_assert(std::alignment_of<SomeType>::value <= std::alignment_of<std::max_align_t>::value, "PolyVector does not support over-aligned types.");
+
+		SomeType *p = 0;
+		append(detail::DeepCopyOperationsFor<SomeType>::get(), std::is_trivially_copyable<SomeType>::value, [&](void *dst) {
+			p = new(dst) SomeType(std::forward<Args>(args)...);
+		});
+		assert(static_cast<void *>(static_cast<Base *>(p)) == static_cast<void *>(p));
+		return *p;
+	}
+
+	/**
+	 * 末尾にsrcのコピーを追加する.
+	 * srcがこのPolyVectorの要素ならば、その動的な型のままコピーする. それ以外はSomeType(srcの静的な型)のコピーコンストラクタでコピーする.
+	 * @param[in]	src	コピー元.
+	 */
+	template<typename SomeType>
+	void push_back(const SomeType &src) {
+		if(const Entry *e = findElement(&src)) appendCopy(*e);
+		else emplace_back<SomeType>(src);
+	}
+	/**
+	 * @overload
+	 * srcがこのPolyVectorの要素ならば、その動的な型のままコピーする.
+	 * それ以外は、動的な型がBaseである(typeidで判定する)場合に限りBaseのコピーコンストラクタでコピーする(スライシングはしない).
+	 * @exception	UnknownDynamicType	srcが要素ではなく、動的な型がBaseではない(またはBaseが抽象クラスである).
+	 */
+	void push_back(const_reference src) {
+		if(const Entry *e = findElement(&src)) appendCopy(*e);
+		else pushBase(src, std::integral_constant<bool, !std::is_abstract<Base>::value && std::is_copy_constructible<Base>::value>());
+	}
+	/// @overload
+	template<typename SomeType, typename = typename std::enable_if<!std::is_lvalue_reference<SomeType>::value>::type>
+	void push_back(SomeType &&src) {
+		emplace_back<SomeType>(std::move(src));
+	}
+
+	/// 末尾の要素を破棄する.
+	void pop_back() {
+		assert(!empty());
+		const Entry &e = entries_.back();
+		if(!e.trivial) --nonTrivial_;
+		e.operations->destruct(buffer_ + e.offset);
+		used_ = e.offset;
+		entries_.pop_back();
+	}
+
+	/// 全ての要素を破棄する. 領域は解放しない.
+	void clear() {
+		destroyRange(buffer_, 0, entries_.size());
+		entries_.clear();
+		used_ = 0;
+		nonTrivial_ = 0;
+	}
+
+	/**
+	 * 要素情報の配列の領域を予約する.
+	 * @param[in]	n	予約する要素数.
+	 */
+	void reserve(size_type n) { entries_.reserve(n); }
+
+	/**
+	 * 要素を格納する領域を、少なくともbytesバイト確保する.
+	 * @param[in]	bytes	確保するバイト数.
+	 */
+	void reserve_bytes(size_type bytes) {
+		if(bytes <= capacity_) return;
+		const size_type newCapacity = grownCapacity(bytes);
+		char *newBuffer = allocate(newCapacity);
+		try {
+			transfer(newBuffer);
+		} catch(...) {
+			deallocate(newBuffer);
+			throw;
+		}
+		replaceBuffer(newBuffer, newCapacity);
+	}
+// }}}
+
+private:	// inner functions {{{
+	static std::size_t alignUp(std::size_t n, std::size_t alignment) {
+		return (n + alignment - 1) / alignment * alignment;
+	}
+	static char *allocate(std::size_t bytes) {
+		return static_cast<char *>(::operator new(bytes));
+	}
+	static void deallocate(char *p) {
+		::operator delete(p);
+	}
+	/// @return	eが例外を送出しないムーブコンストラクタを持たない型の要素ならばtrue. 拡張時にはコピーする.
+	static bool needsCopy(const Entry &e) {
+		return !e.trivial && !e.operations->inlinable;
+	}
+
+	/// @return	pが指すこのPolyVectorの要素の情報. 要素の先頭でなければNULL.
+	const Entry *findElement(const void *p) const {
+		const char *const c = static_cast<const char *>(p);
+		const std::less<const char *> less;
+		if(!buffer_ || less(c, buffer_) || !less(c, buffer_ + used_)) return 0;
+		const std::size_t offset = static_cast<std::size_t>(c - buffer_);
+		const typename std::vector<Entry>::const_iterator it = std::lower_bound(entries_.begin(), entries_.end(), offset,
+			[](const Entry &e, std::size_t o) { return e.offset < o; });
+		return it != entries_.end() && it->offset == offset ? &*it : 0;
+	}
+
+	/**
+	 * 末尾に要素を追加する. 拡張が必要ならば、既存の要素を移す前に新たな領域へ構築する(constructの引数が既存の要素を参照していても良いように).
+	 * @param[in]	operations	追加する要素の動的な型に応じた操作.
+	 * @param[in]	trivial	追加する要素が自明にコピー出来る型ならばtrue.
+	 * @param[in]	construct	void *の指す領域に要素を構築する関数オブジェクト.
+	 */
+	template<typename Construct>
+	void append(const Operations *operations, bool trivial, Construct construct) {
+		const std::size_t offset = alignUp(used_, operations->alignment);
+		const Entry entry = { offset, operations, trivial };
+		entries_.reserve(entries_.size() + 1);
+
+		if(offset + operations->size <= capacity_) {
+			construct(static_cast<void *>(buffer_ + offset));
+		} else {
+			const std::size_t newCapacity = grownCapacity(offset + operations->size);
+			char *newBuffer = allocate(newCapacity);
+			try {
+				construct(static_cast<void *>(newBuffer + offset));
+			} catch(...) {
+				deallocate(newBuffer);
+				throw;
+			}
+			try {
+				transfer(newBuffer);
+			} catch(...) {
+				operations->destruct(newBuffer + offset);
+				deallocate(newBuffer);
+				throw;
+			}
+			replaceBuffer(newBuffer, newCapacity);
+		}
+		entries_.push_back(entry);
+		used_ = offset + operations->size;
+		if(!trivial) ++nonTrivial_;
+	}
+	/// 要素ではないsrcを、動的な型がBaseならばコピーする.
+	void pushBase(const_reference src, std::true_type) {
+		if(typeid(src) != typeid(Base)) throw UnknownDynamicType();
+		emplace_back<Base>(src);
+	}
+	/// @overload
+	void pushBase(const_reference, std::false_type) {
+		throw UnknownDynamicType();
+	}
+	/// 要素sourceを、その動的な型のまま末尾にコピーする.
+	void appendCopy(const Entry &source) {
+		// entries_の拡張でsourceが無効になる前に、必要な値を取り出しておく
+		const Operations *const operations = source.operations;
+		const char *const src = buffer_ + source.offset;
+		append(operations, source.trivial, [operations, src](void *dst) { operations->copyTo(src, dst); });
+	}
+
+	Base *element(size_type index) const {
+		assert(index < size());
+		return reinterpret_cast<Base *>(buffer_ + entries_[index].offset);
+	}
+
+	/// buffer内の[first, last)番目の要素を破棄する.
+	void destroyRange(char *buffer, std::size_t first, std::size_t last) {
+		for(std::size_t i = first; i < last; ++i) {
+			const Entry &e = entries_[i];
+			e.operations->destruct(buffer + e.offset);
+		}
+	}
+
+	/// @return	少なくともbytesバイトを格納出来る、拡張後の領域のバイト数.
+	std::size_t grownCapacity(std::size_t bytes) const {
+		std::size_t newCapacity = capacity_ * 2;
+		if(newCapacity < bytes) newCapacity = bytes;
+		return newCapacity;
+	}
+
+	/**
+	 * 要素を新たな領域newBufferへ移す.
+	 * まず例外を送出し得る要素のコピーを行い、失敗した場合はコピーした要素を破棄して例外を送出する(newBufferは解放しない). 成功した後に残りの要素をムーブする.
+	 */
+	void transfer(char *newBuffer) {
+		if(nonTrivial_ == 0) {
+			if(used_) std::memcpy(newBuffer, buffer_, used_);
+			return;
+		}
+		std::size_t copied = 0;
+		try {
+			for(; copied < entries_.size(); ++copied) {
+				const Entry &e = entries_[copied];
+				if(needsCopy(e)) e.operations->copyTo(buffer_ + e.offset, newBuffer + e.offset);
+			}
+		} catch(...) {
+			for(std::size_t i = 0; i < copied; ++i) {
+				const Entry &e = entries_[i];
+				if(needsCopy(e)) e.operations->destruct(newBuffer + e.offset);
+			}
+			throw;
+		}
+		for(std::size_t i = 0; i < entries_.size(); ++i) {
+			const Entry &e = entries_[i];
+			if(e.trivial) std::memcpy(newBuffer + e.offset, buffer_ + e.offset, e.operations->size);
+			else if(needsCopy(e)) e.operations->destruct(buffer_ + e.offset);
+			else e.operations->relocate(buffer_ + e.offset, newBuffer + e.offset);
+		}
+	}
+	/// 要素を移し終えたnewCapacityバイトの領域newBufferを、以降の領域とする.
+	void replaceBuffer(char *newBuffer, std::size_t newCapacity) {
+		deallocate(buffer_);
+		buffer_ = newBuffer;
+		capacity_ = newCapacity;
+	}
+// }}}
+
+private:	// fields {{{
+	std::vector<Entry> entries_;
+	char *buffer_;
+	std::size_t used_;
+	std::size_t capacity_;
+	/// 自明にコピー出来ない型の要素の数. 0ならば領域を一括してコピー出来る.
+	std::size_t nonTrivial_;
+// }}}
+};
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_POLYVECTOR_HPP_
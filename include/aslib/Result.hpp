@@ -4,11 +4,297 @@
 #ifndef ASLIB_INCLUDED_RESULT_HPP_
 #define ASLIB_INCLUDED_RESULT_HPP_
 
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
+
+#include <aslib/Config.hpp>
+#include <aslib/Instrumentation.hpp>
 
 namespace aslib {
 
+template<typename S, typename F>
+class Result;
+
+namespace detail {
+
+/**
+ * pの指す領域に値を構築する.
+ * 定数式中ではplacement newを使えない為、ASLIB_HAS_CONSTEXPR_RESULTが1ならばstd::construct_atを用いる.
+ */
+template<typename T, typename... Args>
+ASLIB_RESULT_CONSTEXPR T *resultConstructAt(T *p, Args &&...args) {
+#if ASLIB_HAS_CONSTEXPR_RESULT
+	return std::construct_at(p, std::forward<Args>(args)...);
+#else
+	return ::new(static_cast<void *>(p)) T(std::forward<Args>(args)...);
+#endif
+}
+
+/// pの指す値を破棄する. 自明なデストラクタを持つ型に対しては何もしない.
+template<typename T>
+ASLIB_RESULT_CONSTEXPR void resultDestroyAt(T *p) { p->~T(); }
+
+/// Tのコピー・ムーブ・破棄が全て自明ならばtrue.
+template<typename T>
+struct IsTriviallyCopyableForResult : std::integral_constant<bool,
+	std::is_trivially_copy_constructible<T>::value && std::is_trivially_move_constructible<T>::value &&
+	std::is_trivially_copy_assignable<T>::value && std::is_trivially_move_assignable<T>::value &&
+	std::is_trivially_destructible<T>::value> {};
+
+/**
+ * 正常値とエラー値を重ねて格納する共用体.
+ * 大きい方の格納型のサイズ・アライメントを持ち、どちらの値も保持していない間はemptyを有効なメンバとする.
+ * 格納型が自明なデストラクタを持たない場合は何もしないデストラクタを定義し、値の破棄はResultStorage::destroyで行う.
+ */
+template<typename S, typename F, bool isTriviallyDestructible = std::is_trivially_destructible<S>::value && std::is_trivially_destructible<F>::value /* == false */>
+union ResultUnion {
+	constexpr ResultUnion() : empty() {}
+	ASLIB_RESULT_CONSTEXPR ~ResultUnion() {}
+
+	char empty;
+	S succeededValue;
+	F failedValue;
+};
+template<typename S, typename F>
+union ResultUnion<S, F, true> {
+	constexpr ResultUnion() : empty() {}
+
+	char empty;
+	S succeededValue;
+	F failedValue;
+};
+
+/**
+ * aslib::Resultの値を格納する領域と、その操作.
+ * コピー・ムーブ・破棄は自明であり、格納型に応じて派生クラス(ResultDestructorBase, ResultCopyBase)で定義する.
+ * 値は共用体のメンバとして直接保持する為、ASLIB_HAS_CONSTEXPR_RESULTが1ならば全ての操作を定数式中で行える.
+ */
+template<typename S, typename F>
+class ResultStorage {
+protected:	// types {{{
+	typedef S SucceededType;
+	typedef F FailedType;
+	/// 計測(aslib/Instrumentation.hpp)で記録する型.
+	typedef Result<S, F> InstrumentedType;
+
+	/// 内部保持している値の種類.
+	enum Kind : unsigned char {
+		uninit,	///< 未初期化. 内部に保持している値は無い.
+		succeeded,	///< 正常値.
+		failed	///< エラー値.
+	};
+// }}}
+
+protected:	// constructors {{{
+	constexpr ResultStorage() : storage_(), kind_(uninit) {}
+// }}}
+
+protected:	// inner functions. {{{
+	/**
+	 * 引数から直接正常値を構築する.
+	 * 呼出時点で値を保持していない事.
+	 * @param[in]	args	格納型のコンストラクタへ渡す引数.
+	 * @return	構築した値への参照.
+	 */
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR SucceededType &constructSucceeded(Args &&...args) {
+		assert(kind_ == uninit);
+		SucceededType *p = resultConstructAt(&storage_.succeededValue, std::forward<Args>(args)...);
+		kind_ = succeeded;
+		return *p;
+	}
+	/**
+	 * 引数から直接エラー値を構築する.
+	 * 呼出時点で値を保持していない事.
+	 * @param[in]	args	格納型のコンストラクタへ渡す引数.
+	 * @return	構築した値への参照.
+	 */
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR FailedType &constructFailed(Args &&...args) {
+		assert(kind_ == uninit);
+		FailedType *p = resultConstructAt(&storage_.failedValue, std::forward<Args>(args)...);
+		kind_ = failed;
+		return *p;
+	}
+
+	/**
+	 * 他のResultStorageと同じ値を構築する.
+	 * 格納型のコピーコンストラクタを使用する.
+	 * @param[in]	src	コピー元
+	 */
+	ASLIB_RESULT_CONSTEXPR void allocate(const ResultStorage &src) {
+		if(src.kind_ != uninit) ASLIB_INSTRUMENT(InstrumentedType, instrumentationClones, 1);
+		switch(src.kind_) {
+		case succeeded: constructSucceeded(src.storage_.succeededValue); break;
+		case failed:    constructFailed(src.storage_.failedValue); break;
+		default: break;
+		}
+	}
+	/**
+	 * 他のResultStorageと同じ値を構築する.
+	 * 格納型のムーブコンストラクタを使用する.
+	 * @param[in]	src	ムーブ元
+	 */
+	ASLIB_RESULT_CONSTEXPR void allocate_move(ResultStorage &&src) {
+		if(src.kind_ != uninit) ASLIB_INSTRUMENT(InstrumentedType, instrumentationMoves, 1);
+		switch(src.kind_) {
+		case succeeded: constructSucceeded(std::move(src.storage_.succeededValue)); break;
+		case failed:    constructFailed(std::move(src.storage_.failedValue)); break;
+		default: break;
+		}
+	}
+
+	/**
+	 * 正常値を代入する.
+	 * 正常値を保持していれば、格納型の代入演算子で既存の値に代入する.
+	 * それ以外の場合は、保持している値を破棄し、格納型のコンストラクタで直接構築する.
+	 * @param[in]	src	代入元.
+	 */
+	template<typename U>
+	ASLIB_RESULT_CONSTEXPR void assignSucceeded(U &&src) {
+		ASLIB_INSTRUMENT(InstrumentedType, instrumentationAssignments, 1);
+		if(kind_ == succeeded) {
+			storage_.succeededValue = std::forward<U>(src);
+			return;
+		}
+
+		destroy();
+		constructSucceeded(std::forward<U>(src));
+	}
+	/**
+	 * エラー値を代入する.
+	 * エラー値を保持していれば、格納型の代入演算子で既存の値に代入する.
+	 * それ以外の場合は、保持している値を破棄し、格納型のコンストラクタで直接構築する.
+	 * @param[in]	src	代入元.
+	 */
+	template<typename U>
+	ASLIB_RESULT_CONSTEXPR void assignFailed(U &&src) {
+		ASLIB_INSTRUMENT(InstrumentedType, instrumentationAssignments, 1);
+		if(kind_ == failed) {
+			storage_.failedValue = std::forward<U>(src);
+			return;
+		}
+
+		destroy();
+		constructFailed(std::forward<U>(src));
+	}
+
+	/**
+	 * 他のResultStorageが保持する値を代入する.
+	 * 保持している値と同じ種類であれば、格納型に対応した代入演算子で既存の値に代入する.
+	 * 種類が異なれば、保持している値を破棄し、格納型のコピーコンストラクタで直接構築する.
+	 * @param[in]	src	代入元.
+	 */
+	ASLIB_RESULT_CONSTEXPR void substitute(const ResultStorage &src) {
+		switch(src.kind_) {
+		case succeeded: assignSucceeded(src.storage_.succeededValue); break;
+		case failed:    assignFailed(src.storage_.failedValue); break;
+		default: destroy(); break;
+		}
+	}
+	/**
+	 * 他のResultStorageが保持する値を代入する.
+	 * 保持している値と同じ種類であれば、右辺値参照を右辺値とするoperator=で既存の値に代入する.
+	 * 種類が異なれば、保持している値を破棄し、格納型のムーブコンストラクタで直接構築する.
+	 * @param[in]	src	代入元.
+	 */
+	ASLIB_RESULT_CONSTEXPR void substitute_move(ResultStorage &&src) {
+		switch(src.kind_) {
+		case succeeded: assignSucceeded(std::move(src.storage_.succeededValue)); break;
+		case failed:    assignFailed(std::move(src.storage_.failedValue)); break;
+		default: destroy(); break;
+		}
+	}
+
+	/// 内部に保持している値を破棄する.
+	ASLIB_RESULT_CONSTEXPR void destroy() {
+		switch(kind_) {
+		case succeeded: resultDestroyAt(&storage_.succeededValue); break;
+		case failed:    resultDestroyAt(&storage_.failedValue); break;
+		default: break;
+		}
+		kind_ = uninit;
+	}
+// }}}
+
+protected:	// fields {{{
+	ResultUnion<SucceededType, FailedType> storage_;
+	Kind kind_;
+// }}}
+};
+
+/// 格納型が自明なデストラクタを持たない場合に、値を破棄するデストラクタを定義する.
+template<typename S, typename F, bool isTriviallyDestructible = std::is_trivially_destructible<S>::value && std::is_trivially_destructible<F>::value /* == false */>
+class ResultDestructorBase : public ResultStorage<S, F> {
+protected:
+	ResultDestructorBase() = default;
+	ResultDestructorBase(const ResultDestructorBase &) = default;
+	ResultDestructorBase(ResultDestructorBase &&) = default;
+	ResultDestructorBase &operator=(const ResultDestructorBase &) = default;
+	ResultDestructorBase &operator=(ResultDestructorBase &&) = default;
+	ASLIB_RESULT_CONSTEXPR ~ResultDestructorBase() { this->destroy(); }
+};
+template<typename S, typename F>
+class ResultDestructorBase<S, F, true> : public ResultStorage<S, F> {};
+
+/// 格納型のコピー・ムーブが自明でない場合に、格納型に応じたコピー・ムーブを定義する.
+template<typename S, typename F, bool isTriviallyCopyable = IsTriviallyCopyableForResult<S>::value && IsTriviallyCopyableForResult<F>::value /* == false */>
+class ResultCopyBase : public ResultDestructorBase<S, F> {
+protected:
+	ResultCopyBase() = default;
+	/// @param[in]	src	コピー元.
+	ASLIB_RESULT_CONSTEXPR ResultCopyBase(const ResultCopyBase &src) : ResultDestructorBase<S, F>() {
+		this->allocate(src);
+	}
+	/// @param[in]	src	コピー元.
+	ASLIB_RESULT_CONSTEXPR ResultCopyBase(ResultCopyBase &&src) noexcept(std::is_nothrow_move_constructible<S>::value && std::is_nothrow_move_constructible<F>::value) : ResultDestructorBase<S, F>() {
+		this->allocate_move(std::move(src));
+	}
+
+	ASLIB_RESULT_CONSTEXPR ResultCopyBase &operator=(const ResultCopyBase &rhs) {
+		if(this != &rhs) this->substitute(rhs);
+		return *this;
+	}
+	ASLIB_RESULT_CONSTEXPR ResultCopyBase &operator=(ResultCopyBase &&rhs) {
+		if(this != &rhs) this->substitute_move(std::move(rhs));
+		return *this;
+	}
+};
+template<typename S, typename F>
+class ResultCopyBase<S, F, true> : public ResultDestructorBase<S, F> {};
+
+/**
+ * 関数オブジェクトFuncを引数Argで呼び出した際の戻り値の型.
+ * Resultのコンビネータの戻り値の型の決定に用いる. 呼び出せない場合は置換失敗となり、そのオーバーロードが候補から外れる.
+ */
+template<typename Func, typename Arg>
+using ResultInvokeType = typename std::decay<decltype(std::declval<Func>()(std::declval<Arg>()))>::type;
+/// 関数オブジェクトFuncを引数無しで呼び出した際の戻り値の型. Result<void, F>のコンビネータに用いる.
+template<typename Func>
+using ResultInvokeTypeNoArg = typename std::decay<decltype(std::declval<Func>()())>::type;
+
+/// Result<void, F>が正常値として内部に保持する空の型.
+struct ResultVoidValue {};
+
+/// コルーチンの戻り値としてResultを構築するコンストラクタを選択する為のタグ型. aslib/ResultCoroutine.hppで用いる.
+struct ResultReturnSlotTag { constexpr explicit ResultReturnSlotTag() {} };
+
+}	// namespace detail
+
+/// 正常値を直接構築するResultのコンストラクタを選択する為のタグ型.
+struct InPlaceSuccessTag { constexpr explicit InPlaceSuccessTag() {} };
+/// エラー値を直接構築するResultのコンストラクタを選択する為のタグ型.
+struct InPlaceFailureTag { constexpr explicit InPlaceFailureTag() {} };
+/// @sa	aslib::InPlaceSuccessTag
+static constexpr InPlaceSuccessTag in_place_success{};
+/// @sa	aslib::InPlaceFailureTag
+static constexpr InPlaceFailureTag in_place_failure{};
+
 /**
  * 正常値とエラー値の両方を表現する型. 関数の戻り値として用いる.
  * 通常、関数は決まった型の値しか返せず、関数の処理結果の値と、呼出元へのエラー発生通知を同時に行う為には、どちらかを(ポインタや参照型で)引数に持たなければならない。
@@ -31,13 +317,20 @@ namespace aslib {
  *	result = Failed();
  *  if(!result) { result.failed().memberOfFailed(); }
  * @endcode
+ * 正常値とエラー値は、双方のうち大きい方のサイズ・アライメントを持つ領域に格納し、値の種類は1バイトで表す.
+ * その為、例えばResult<int, enum>のサイズは8バイトになる.
+ * SとFが共に自明にコピー・破棄出来る型であれば、Result自身も自明にコピー・破棄出来る型(trivially copyable)になり、レジスタ渡しやmemcpyによるコピーが可能になる.
+ * ASLIB_ENABLE_INSTRUMENTATIONが1ならば、Result<S, F>毎にコピー・ムーブ・代入と例外の送出回数を計測する(aslib/Instrumentation.hpp).
+ * C++20(ASLIB_HAS_CONSTEXPR_RESULTが1)では全てのメンバ関数がconstexprになり、設定値の検証やテーブルの生成などをコンパイル時に行える. 格納型もリテラル型である事.
  * @param[in]	S	正常値の型.
  * @param[in]	F	エラー値の型.
- * @warning	現在のこのクラスでは、テンプレートパラメータとして参照を用いる事は出来ない.
+ * Sには参照型とvoidも指定出来る. Result<T &, F>はTへのポインタを、Result<void, F>はエラー値のみを保持する.
  * @sa	aslib::Result::CantDereference
  */
 template<typename S, typename F>
-class Result {
+class Result : private detail::ResultCopyBase<S, F> {
+	typedef detail::ResultCopyBase<S, F> Base;
+
 public:	// public types {{{
 	/// 正常値の型.
 	typedef S SucceededType;
@@ -57,219 +350,709 @@ public:	// public types {{{
 private: // private types {{{
 	typedef Result<SucceededType, FailedType> My;
 
-	/// 内部保持している値の種類.
-	enum Kind {
-		uninit,	///< 未初期化. 内部に保持している値は無い.
-		succeeded,	///< 正常値.
-		failed	///< エラー値.
-	};
+	typedef typename Base::Kind Kind;
+	using Base::uninit;
+	using Base::succeeded;
+	using Base::failed;
 // }}}
 
 public:	// constructors / destructor {{{
-	Result() : kind_(uninit) {}
+	/// コピー・ムーブ・破棄は、格納型に応じてdetail::ResultCopyBase及びdetail::ResultDestructorBaseで定義する.
+	ASLIB_RESULT_CONSTEXPR Result() {}
 	/// @param[in]	src	正常値.
-	Result(const SucceededType &src) { allocate(&src,succeeded); }
+	ASLIB_RESULT_CONSTEXPR Result(const SucceededType &src) { this->constructSucceeded(src); }
 	/// @param[in]	src	正常値.
-	Result(SucceededType &&src) { allocate_move(&src, succeeded); }
+	ASLIB_RESULT_CONSTEXPR Result(SucceededType &&src) { this->constructSucceeded(std::move(src)); }
 	/// @param[in]	src	エラー値.
-	Result(const FailedType &src) { allocate(&src, failed); }
+	ASLIB_RESULT_CONSTEXPR Result(const FailedType &src) { this->constructFailed(src); }
 	/// @param[in]	src	エラー値.
-	Result(FailedType &&src) { allocate_move(&src, failed); }
-
-	/// @param[in]	src	コピー元.
-	Result(const Result &src) {
-		if(src.kind_ == uninit) return;
-
-		allocate(src.storage_, src.kind_);
-	}
-	/// @param[in]	src	コピー元.
-	Result(Result &&src) : kind_(uninit) {
-		if(src.kind_ == uninit) return;
-
-		allocate_move(&src.storage_, src.kind_);
-	}
-
-	~Result() { destroy(); }
+	ASLIB_RESULT_CONSTEXPR Result(FailedType &&src) { this->constructFailed(std::move(src)); }
+	/**
+	 * 正常値を引数から直接構築する. 正常値のコピー・ムーブは発生しない.
+	 * @code
+	 *	return aslib::Result<Big, Error>(aslib::in_place_success, arg1, arg2);
+	 * @endcode
+	 * @param[in]	args	SucceededTypeのコンストラクタへ渡す引数.
+	 */
+	template<typename... Args>
+	explicit
+	ASLIB_RESULT_CONSTEXPR Result(InPlaceSuccessTag, Args &&...args) { this->constructSucceeded(std::forward<Args>(args)...); }
+	/**
+	 * エラー値を引数から直接構築する. エラー値のコピー・ムーブは発生しない.
+	 * @param[in]	args	FailedTypeのコンストラクタへ渡す引数.
+	 */
+	template<typename... Args>
+	explicit
+	ASLIB_RESULT_CONSTEXPR Result(InPlaceFailureTag, Args &&...args) { this->constructFailed(std::forward<Args>(args)...); }
+	/// 未初期化のResultを構築し、*slotへ自身のアドレスを格納する. コルーチンが戻り値を直接書き込む為に用いる.
+	explicit
+	ASLIB_RESULT_CONSTEXPR Result(detail::ResultReturnSlotTag, My **slot) { *slot = this; }
 // }}}
 
 public:	// functions / operators
 	/// @return	保持している値が正常値かエラー値か. trueならば正常値.
-	operator bool() const { return kind_ == succeeded; }
+	ASLIB_RESULT_CONSTEXPR operator bool() const { return kind_ == succeeded; }
 
 	/**
 	 * @return	正常値を保持している場合、その値への参照を返す.
 	 * @exception	aslib::Result::CantDereference	エラー値を保持している場合に発生する.
 	 */
-	SucceededType &operator*() { return const_cast<SucceededType &>(const_cast<const My *>(this)->operator*()); }
+	ASLIB_RESULT_CONSTEXPR SucceededType &operator*() { return const_cast<SucceededType &>(const_cast<const My *>(this)->operator*()); }
 	/// @overload
-	const SucceededType &operator*() const {
-		if(!operator bool()) { throw Result::CantDereference(); }
-		return *reinterpret_cast<const SucceededType *>(storage_);
+	ASLIB_RESULT_CONSTEXPR const SucceededType &operator*() const {
+		if(!operator bool()) { ASLIB_INSTRUMENT(My, instrumentationExceptions, 1); throw Result::CantDereference(); }
+		return storage_.succeededValue;
 	}
 
 	/**
 	 * @return	正常値を保持している場合、その値へのポインタを返す.
 	 * @exception	aslib::Result::CantDereference	エラー値を保持している場合に発生する.
 	 */
-	SucceededType *operator->() { return const_cast<SucceededType *>(const_cast<const My *>(this)->operator->()); }
+	ASLIB_RESULT_CONSTEXPR SucceededType *operator->() { return const_cast<SucceededType *>(const_cast<const My *>(this)->operator->()); }
 	/// @overload
-	const SucceededType *operator->() const {
-		if(!operator bool()) { throw Result::CantDereference(); }
-		return reinterpret_cast<const SucceededType *>(storage_);
+	ASLIB_RESULT_CONSTEXPR const SucceededType *operator->() const {
+		if(!operator bool()) { ASLIB_INSTRUMENT(My, instrumentationExceptions, 1); throw Result::CantDereference(); }
+		return &storage_.succeededValue;
 	}
 
 	/**
 	 * @return	エラー値を保持している場合に、その値への参照を返す.
 	 */
-	FailedType &fail() { return const_cast<FailedType &>(const_cast<const My *>(this)->fail()); }
+	ASLIB_RESULT_CONSTEXPR FailedType &fail() { return const_cast<FailedType &>(const_cast<const My *>(this)->fail()); }
 	// @overload
-	const FailedType &fail() const {
-		if(kind_ == failed) return *reinterpret_cast<const FailedType *>(storage_);
+	ASLIB_RESULT_CONSTEXPR const FailedType &fail() const {
+		if(kind_ == failed) return storage_.failedValue;
+		ASLIB_INSTRUMENT(My, instrumentationExceptions, 1);
 		throw NotHaveFailedObject();
 	}
 
-	Result &operator=(const SucceededType &rhs) { return substitute(&rhs, succeeded); }
-	Result &operator=(SucceededType &&rhs) { return substitute_move(&rhs, succeeded); }
-	Result &operator=(const FailedType &rhs) { return substitute(&rhs, failed); }
-	Result &operator=(FailedType &&rhs) { return substitute_move(&rhs, failed); }
-	Result &operator=(const Result &rhs) { return substitute(rhs.storage_, rhs.kind_); }
-	Result &operator=(Result &&rhs) { return substitute_move(rhs.storage_, rhs.kind_); }
-// }}}
+	/**
+	 * 例外を送出しない正常値へのアクセス.
+	 * @return	正常値を保持している場合、その値へのポインタを返す. それ以外の場合はnullptr.
+	 */
+	ASLIB_RESULT_CONSTEXPR SucceededType *get_if() { return (kind_ == succeeded) ? &storage_.succeededValue : nullptr; }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const SucceededType *get_if() const { return (kind_ == succeeded) ? &storage_.succeededValue : nullptr; }
 
-private:	// inner functions. {{{
 	/**
-	 * 指定した型の値を構築する.
-	 * 格納型のコピーコンストラクタを使用する.
-	 * @param[in]	src	コピー元
-	 * @param[in]	kind	コピー元の値種別.
+	 * 例外を送出しないエラー値へのアクセス.
+	 * @return	エラー値を保持している場合、その値へのポインタを返す. それ以外の場合はnullptr.
 	 */
-	void allocate(const void *src, Kind srcKind) {
-		switch(srcKind) {
-		case succeeded:
-			new(storage_) SucceededType(*static_cast<const SucceededType *>(src));
-			break;
-		case failed:
-			new(storage_) FailedType(*static_cast<const FailedType *>(src));
-			break;
-		}
-		kind_ = srcKind;
+	ASLIB_RESULT_CONSTEXPR FailedType *fail_if() { return (kind_ == failed) ? &storage_.failedValue : nullptr; }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const FailedType *fail_if() const { return (kind_ == failed) ? &storage_.failedValue : nullptr; }
+
+	/**
+	 * @param[in]	defaultValue	正常値を保持していない場合の値.
+	 * @return	正常値を保持している場合はその値のコピー、それ以外の場合はdefaultValue. 右辺値に対しては、保持している正常値をムーブする.
+	 */
+	template<typename U>
+	ASLIB_RESULT_CONSTEXPR SucceededType value_or(U &&defaultValue) const & {
+		return (kind_ == succeeded) ? unchecked_value() : static_cast<SucceededType>(std::forward<U>(defaultValue));
 	}
+	/// @overload
+	template<typename U>
+	ASLIB_RESULT_CONSTEXPR SucceededType value_or(U &&defaultValue) && {
+		return (kind_ == succeeded) ? std::move(unchecked_value()) : static_cast<SucceededType>(std::forward<U>(defaultValue));
+	}
+
 	/**
-	 * @overload
-	 * 指定した型の値を構築する.
-	 * 格納型のデフォルトコンストラクタを使用する.
-	 * @param[in]	kind	
+	 * 保持している値の種類を確認せずに、正常値へアクセスする.
+	 * 呼び出し側で正常値を保持している事を確認済みの、速度が重要な箇所で用いる. 確認はデバッグビルドのassertのみで行う.
+	 * @return	正常値への参照.
 	 */
-	void allocate(Kind kind) {
-		assert(kind != uninit);
+	ASLIB_RESULT_CONSTEXPR SucceededType &unchecked_value() { assert(kind_ == succeeded); return storage_.succeededValue; }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const SucceededType &unchecked_value() const { assert(kind_ == succeeded); return storage_.succeededValue; }
 
-		switch(kind) {
-		case succeeded: new(storage_) SucceededType(); break;
-		case failed: new(storage_) FailedType(); break;
-		}
-		kind_ = kind;
+	/**
+	 * 保持している値の種類を確認せずに、エラー値へアクセスする.
+	 * 確認はデバッグビルドのassertのみで行う.
+	 * @return	エラー値への参照.
+	 */
+	ASLIB_RESULT_CONSTEXPR FailedType &unchecked_fail() { assert(kind_ == failed); return storage_.failedValue; }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const FailedType &unchecked_fail() const { assert(kind_ == failed); return storage_.failedValue; }
+
+	ASLIB_RESULT_CONSTEXPR Result &operator=(const SucceededType &rhs) { this->assignSucceeded(rhs); return *this; }
+	ASLIB_RESULT_CONSTEXPR Result &operator=(SucceededType &&rhs) { this->assignSucceeded(std::move(rhs)); return *this; }
+	ASLIB_RESULT_CONSTEXPR Result &operator=(const FailedType &rhs) { this->assignFailed(rhs); return *this; }
+	ASLIB_RESULT_CONSTEXPR Result &operator=(FailedType &&rhs) { this->assignFailed(std::move(rhs)); return *this; }
+
+	/**
+	 * 保持している値を破棄し、正常値を引数から直接構築する.
+	 * 構築中に例外が発生した場合、未初期化の状態になる.
+	 * @param[in]	args	SucceededTypeのコンストラクタへ渡す引数.
+	 * @return	構築した正常値への参照.
+	 */
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR SucceededType &emplace_success(Args &&...args) {
+		this->destroy();
+		return this->constructSucceeded(std::forward<Args>(args)...);
 	}
+	/**
+	 * 保持している値を破棄し、エラー値を引数から直接構築する.
+	 * 構築中に例外が発生した場合、未初期化の状態になる.
+	 * @param[in]	args	FailedTypeのコンストラクタへ渡す引数.
+	 * @return	構築したエラー値への参照.
+	 */
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR FailedType &emplace_failure(Args &&...args) {
+		this->destroy();
+		return this->constructFailed(std::forward<Args>(args)...);
+	}
+// }}}
+
+public:	// combinators {{{
+	/*
+	 * 処理の連鎖に用いるコンビネータ.
+	 * 右辺値に対して呼び出した場合、保持している値を次の処理へムーブする. その為、std::move(r).map(f).and_then(g)...のように連鎖させれば、各段で値のコピーは発生しない.
+	 * 左辺値に対して呼び出した場合は、保持している値をconst参照で渡す.
+	 * 未初期化のResultに対しては、いずれも未初期化のResultを返す.
+	 */
 
 	/**
-	 * 指定した型の値を構築する.
-	 * 格納型のムーブコンストラクタを使用する.
-	 * @param[in]	src	コピー元
-	 * @param[in]	kind	コピー元の値種別.
+	 * 正常値を変換する.
+	 * @param[in]	func	正常値を受け取り、新たな正常値を返す関数オブジェクト.
+	 * @return	正常値を保持していればfuncの戻り値を正常値とするResult. エラー値を保持していれば、そのエラー値を持つResult.
 	 */
-	void allocate_move(void *src, Kind srcKind) {
-		switch(srcKind) {
-		case succeeded:
-			new(storage_) SucceededType(std::move(*static_cast<SucceededType *>(src)));
-			break;
-		case failed:
-			new(storage_) FailedType(std::move(*static_cast<FailedType *>(src)));
-			break;
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<detail::ResultInvokeType<Func, SucceededType>, FailedType> map(Func &&func) && {
+		typedef Result<detail::ResultInvokeType<Func, SucceededType>, FailedType> ReturnType;
+		switch(kind_) {
+		case succeeded: return ReturnType(std::forward<Func>(func)(std::move(unchecked_value())));
+		case failed: return ReturnType(std::move(unchecked_fail()));
+		default: return ReturnType();
+		}
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<detail::ResultInvokeType<Func, const SucceededType &>, FailedType> map(Func &&func) const & {
+		typedef Result<detail::ResultInvokeType<Func, const SucceededType &>, FailedType> ReturnType;
+		switch(kind_) {
+		case succeeded: return ReturnType(std::forward<Func>(func)(unchecked_value()));
+		case failed: return ReturnType(unchecked_fail());
+		default: return ReturnType();
 		}
-		kind_ = srcKind;
 	}
 
 	/**
-	 * 指定した型の値を代入する.
-	 * 格納型に対応した代入演算子を使用する.
-	 * @param[in]	src	代入元を指すポインタ.
-	 * @param[in]	srcKind	代入元の種類.
-	 * @return	代入処理を行った自分自身(*this).
+	 * 正常値を、失敗し得る次の処理へ渡す.
+	 * @param[in]	func	正常値を受け取り、Result<U, FailedType>を返す関数オブジェクト.
+	 * @return	正常値を保持していればfuncの戻り値. エラー値を保持していれば、そのエラー値を持つResult.
 	 */
-	Result &substitute(const void *src, Kind srcKind) {
-		if(kind_ != uninit) destroy();
-		if(srcKind != uninit) allocate(srcKind);
-		switch(srcKind) {
-		case succeeded:
-			*reinterpret_cast<SucceededType *>(storage_) = *static_cast<const SucceededType *>(src);
-			break;
-		case failed:
-			*reinterpret_cast<FailedType *>(storage_) = *static_cast<const FailedType *>(src);
-			break;
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, SucceededType> and_then(Func &&func) && {
+		typedef detail::ResultInvokeType<Func, SucceededType> ReturnType;
+		switch(kind_) {
+		case succeeded: return std::forward<Func>(func)(std::move(unchecked_value()));
+		case failed: return ReturnType(std::move(unchecked_fail()));
+		default: return ReturnType();
 		}
-		kind_ = srcKind;
-
-		return *this;
 	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, const SucceededType &> and_then(Func &&func) const & {
+		typedef detail::ResultInvokeType<Func, const SucceededType &> ReturnType;
+		switch(kind_) {
+		case succeeded: return std::forward<Func>(func)(unchecked_value());
+		case failed: return ReturnType(unchecked_fail());
+		default: return ReturnType();
+		}
+	}
+
 	/**
-	 * 指定した型の値を代入する.
-	 * 右辺値参照を右辺値とするoperator=を使用する.
-	 * @param[in]	src	代入元を指すポインタ.
-	 * @param[in]	srcKind	代入元の種類.
-	 * @return	代入処理を行った自分自身(*this).
+	 * エラー値を、回復を試みる処理へ渡す.
+	 * @param[in]	func	エラー値を受け取り、Result<SucceededType, G>を返す関数オブジェクト.
+	 * @return	エラー値を保持していればfuncの戻り値. 正常値を保持していれば、その正常値を持つResult.
 	 */
-	Result &substitute_move(void *src, Kind srcKind) {
-		if(kind_ != uninit) destroy();
-		if(srcKind != uninit) allocate(srcKind);
-		switch(srcKind) {
-		case succeeded:
-			*reinterpret_cast<SucceededType *>(storage_) = std::move(*static_cast<SucceededType *>(src));
-			break;
-		case failed:
-			*reinterpret_cast<FailedType *>(storage_) = std::move(*static_cast<FailedType *>(src));
-			break;
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, FailedType> or_else(Func &&func) && {
+		typedef detail::ResultInvokeType<Func, FailedType> ReturnType;
+		switch(kind_) {
+		case succeeded: return ReturnType(std::move(unchecked_value()));
+		case failed: return std::forward<Func>(func)(std::move(unchecked_fail()));
+		default: return ReturnType();
+		}
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, const FailedType &> or_else(Func &&func) const & {
+		typedef detail::ResultInvokeType<Func, const FailedType &> ReturnType;
+		switch(kind_) {
+		case succeeded: return ReturnType(unchecked_value());
+		case failed: return std::forward<Func>(func)(unchecked_fail());
+		default: return ReturnType();
 		}
-		kind_ = srcKind;
-
-		return *this;
 	}
 
-	/// 内部に保持している値を破棄する.
-	void destroy() {
+	/**
+	 * エラー値を変換する.
+	 * @param[in]	func	エラー値を受け取り、新たなエラー値を返す関数オブジェクト.
+	 * @return	エラー値を保持していればfuncの戻り値をエラー値とするResult. 正常値を保持していれば、その正常値を持つResult.
+	 */
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<SucceededType, detail::ResultInvokeType<Func, FailedType>> map_error(Func &&func) && {
+		typedef Result<SucceededType, detail::ResultInvokeType<Func, FailedType>> ReturnType;
 		switch(kind_) {
-		case succeeded: Destoroyer<SucceededType>()(storage_); break;
-		case failed:    Destoroyer<FailedType   >()(storage_); break;
+		case succeeded: return ReturnType(std::move(unchecked_value()));
+		case failed: return ReturnType(std::forward<Func>(func)(std::move(unchecked_fail())));
+		default: return ReturnType();
 		}
-		kind_ = uninit;
 	}
-	/// 実際に値の破棄を行う.
-	template<typename T>
-	struct Destoroyer {
-		void operator()(void *p) { destory<std::is_pod<T>::value>(p); }
-	private:
-		template<typename bool isPod /* == true */> void destory(void *p) { /* NOTHING */ }
-		template<> void destory<false>(void *p) { static_cast<T *>(p)->~T(); }
-	};
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<SucceededType, detail::ResultInvokeType<Func, const FailedType &>> map_error(Func &&func) const & {
+		typedef Result<SucceededType, detail::ResultInvokeType<Func, const FailedType &>> ReturnType;
+		switch(kind_) {
+		case succeeded: return ReturnType(unchecked_value());
+		case failed: return ReturnType(std::forward<Func>(func)(unchecked_fail()));
+		default: return ReturnType();
+		}
+	}
+// }}}
+
+private:	// fields {{{
+	using Base::storage_;
+	using Base::kind_;
+// }}}
+};
+
+/**
+ * 正常値として参照を返す為のResultの特殊化.
+ * 正常値は参照先へのポインタとして保持する為、Result<T *, F>と同じサイズになり、参照先のコピーは発生しない.
+ * 参照先の寿命は呼出側が保証する事.
+ * @code
+ *	aslib::Result<const Entry &, Error> lookup(const Key &key);	// キャッシュ内のオブジェクトを、コピーせずに返す
+ * @endcode
+ * @param[in]	S	参照先の型.
+ * @param[in]	F	エラー値の型.
+ */
+template<typename S, typename F>
+class Result<S &, F> {
+	typedef Result<S *, F> Impl;
+
+public:	// public types {{{
+	/// 正常値の型.
+	typedef S &SucceededType;
+	/// エラー値の型.
+	typedef F FailedType;
+
+	/// @sa	aslib::Result::CantDereference
+	typedef typename Impl::CantDereference CantDereference;
+	/// @sa	aslib::Result::NotHaveFailedObject
+	typedef typename Impl::NotHaveFailedObject NotHaveFailedObject;
+// }}}
+
+public:	// constructors / destructor {{{
+	ASLIB_RESULT_CONSTEXPR Result() {}
+	/// @param[in]	src	正常値として参照するオブジェクト.
+	ASLIB_RESULT_CONSTEXPR Result(S &src) : impl_(&src) {}
+	/// 一時オブジェクトへの参照は保持出来ない.
+	Result(const S &&) = delete;
+	/// @param[in]	src	エラー値.
+	ASLIB_RESULT_CONSTEXPR Result(const FailedType &src) : impl_(src) {}
+	/// @param[in]	src	エラー値.
+	ASLIB_RESULT_CONSTEXPR Result(FailedType &&src) : impl_(std::move(src)) {}
+	/// @param[in]	src	正常値として参照するオブジェクト.
+	explicit
+	ASLIB_RESULT_CONSTEXPR Result(InPlaceSuccessTag, S &src) : impl_(&src) {}
+	/// @param[in]	args	FailedTypeのコンストラクタへ渡す引数.
+	template<typename... Args>
+	explicit
+	ASLIB_RESULT_CONSTEXPR Result(InPlaceFailureTag, Args &&...args) : impl_(in_place_failure, std::forward<Args>(args)...) {}
+	/// @sa	aslib::Result::Result(detail::ResultReturnSlotTag, My **)
+	explicit
+	ASLIB_RESULT_CONSTEXPR Result(detail::ResultReturnSlotTag, Result **slot) { *slot = this; }
+// }}}
+
+public:	// functions / operators {{{
+	/// @return	保持している値が正常値かエラー値か. trueならば正常値.
+	ASLIB_RESULT_CONSTEXPR operator bool() const { return static_cast<bool>(impl_); }
 
 	/**
-	 * 正常値、エラー値双方とも保持可能なサイズを算出するメタ関数.
+	 * @return	正常値として保持している参照.
+	 * @exception	aslib::Result::CantDereference	正常値を保持していない場合に発生する.
 	 */
-	class CalcStorageSize {
-		static const std::size_t sSize = sizeof(SucceededType);
-		static const std::size_t fSize = sizeof(FailedType);
-		static const std::size_t cSize = sizeof(char);
-		static const std::size_t storageSize = (sSize > fSize) ? sSize : fSize;
-	public:
-		static const std::size_t value = storageSize / cSize + ((storageSize % cSize) > 0);
-	};
+	ASLIB_RESULT_CONSTEXPR S &operator*() const { return **impl_; }
+	/// @sa	operator*
+	ASLIB_RESULT_CONSTEXPR S *operator->() const { return *impl_; }
+
+	/**
+	 * @return	エラー値を保持している場合のみ、その値への参照を返す.
+	 * @exception	aslib::Result::NotHaveFailedObject	エラー値を保持していない場合に発生する.
+	 */
+	ASLIB_RESULT_CONSTEXPR FailedType &fail() { return impl_.fail(); }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const FailedType &fail() const { return impl_.fail(); }
+
+	/// @return	正常値を保持している場合は参照先へのポインタ. それ以外の場合はnullptr.
+	ASLIB_RESULT_CONSTEXPR S *get_if() const { return impl_ ? impl_.unchecked_value() : nullptr; }
+	/// @return	エラー値を保持している場合はその値へのポインタ. それ以外の場合はnullptr.
+	ASLIB_RESULT_CONSTEXPR FailedType *fail_if() { return impl_.fail_if(); }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const FailedType *fail_if() const { return impl_.fail_if(); }
+
+	/**
+	 * @param[in]	defaultValue	正常値を保持していない場合に返す参照.
+	 * @return	正常値を保持している場合はその参照、それ以外の場合はdefaultValue.
+	 */
+	ASLIB_RESULT_CONSTEXPR S &value_or(S &defaultValue) const { return impl_ ? *impl_.unchecked_value() : defaultValue; }
+
+	/// 保持している値の種類を確認せずに、正常値へアクセスする. 確認はデバッグビルドのassertのみで行う.
+	ASLIB_RESULT_CONSTEXPR S &unchecked_value() const { return *impl_.unchecked_value(); }
+	/// 保持している値の種類を確認せずに、エラー値へアクセスする. 確認はデバッグビルドのassertのみで行う.
+	ASLIB_RESULT_CONSTEXPR FailedType &unchecked_fail() { return impl_.unchecked_fail(); }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const FailedType &unchecked_fail() const { return impl_.unchecked_fail(); }
+
+	/// 参照先を変更する. 参照先のオブジェクトへの代入は行わない.
+	ASLIB_RESULT_CONSTEXPR Result &operator=(S &rhs) { impl_ = &rhs; return *this; }
+	Result &operator=(const S &&) = delete;
+	ASLIB_RESULT_CONSTEXPR Result &operator=(const FailedType &rhs) { impl_ = rhs; return *this; }
+	ASLIB_RESULT_CONSTEXPR Result &operator=(FailedType &&rhs) { impl_ = std::move(rhs); return *this; }
+
+	/// @sa	aslib::Result::emplace_failure
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR FailedType &emplace_failure(Args &&...args) { return impl_.emplace_failure(std::forward<Args>(args)...); }
+// }}}
+
+public:	// combinators {{{
+	/*
+	 * aslib::Resultのコンビネータと同じ. 正常値は常に参照として渡し、右辺値に対して呼び出した場合はエラー値をムーブする.
+	 */
+
+	/// @sa	aslib::Result::map
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<detail::ResultInvokeType<Func, S &>, FailedType> map(Func &&func) && {
+		typedef Result<detail::ResultInvokeType<Func, S &>, FailedType> ReturnType;
+		if(impl_) return ReturnType(std::forward<Func>(func)(unchecked_value()));
+		if(impl_.fail_if()) return ReturnType(std::move(unchecked_fail()));
+		return ReturnType();
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<detail::ResultInvokeType<Func, S &>, FailedType> map(Func &&func) const & {
+		typedef Result<detail::ResultInvokeType<Func, S &>, FailedType> ReturnType;
+		if(impl_) return ReturnType(std::forward<Func>(func)(unchecked_value()));
+		if(impl_.fail_if()) return ReturnType(unchecked_fail());
+		return ReturnType();
+	}
+
+	/// @sa	aslib::Result::and_then
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, S &> and_then(Func &&func) && {
+		typedef detail::ResultInvokeType<Func, S &> ReturnType;
+		if(impl_) return std::forward<Func>(func)(unchecked_value());
+		if(impl_.fail_if()) return ReturnType(std::move(unchecked_fail()));
+		return ReturnType();
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, S &> and_then(Func &&func) const & {
+		typedef detail::ResultInvokeType<Func, S &> ReturnType;
+		if(impl_) return std::forward<Func>(func)(unchecked_value());
+		if(impl_.fail_if()) return ReturnType(unchecked_fail());
+		return ReturnType();
+	}
+
+	/// @sa	aslib::Result::or_else
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, FailedType> or_else(Func &&func) && {
+		typedef detail::ResultInvokeType<Func, FailedType> ReturnType;
+		if(impl_) return ReturnType(unchecked_value());
+		if(impl_.fail_if()) return std::forward<Func>(func)(std::move(unchecked_fail()));
+		return ReturnType();
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, const FailedType &> or_else(Func &&func) const & {
+		typedef detail::ResultInvokeType<Func, const FailedType &> ReturnType;
+		if(impl_) return ReturnType(unchecked_value());
+		if(impl_.fail_if()) return std::forward<Func>(func)(unchecked_fail());
+		return ReturnType();
+	}
+
+	/// @sa	aslib::Result::map_error
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<S &, detail::ResultInvokeType<Func, FailedType> > map_error(Func &&func) && {
+		typedef Result<S &, detail::ResultInvokeType<Func, FailedType> > ReturnType;
+		if(impl_) return ReturnType(unchecked_value());
+		if(impl_.fail_if()) return ReturnType(std::forward<Func>(func)(std::move(unchecked_fail())));
+		return ReturnType();
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<S &, detail::ResultInvokeType<Func, const FailedType &> > map_error(Func &&func) const & {
+		typedef Result<S &, detail::ResultInvokeType<Func, const FailedType &> > ReturnType;
+		if(impl_) return ReturnType(unchecked_value());
+		if(impl_.fail_if()) return ReturnType(std::forward<Func>(func)(unchecked_fail()));
+		return ReturnType();
+	}
 // }}}
 
 private:	// fields {{{
+	Impl impl_;
+// }}}
+};
 
-	char storage_[CalcStorageSize::value];
-	Kind kind_;
+/**
+ * 正常値を持たず、成功したか否かとエラー値のみを表すResultの特殊化.
+ * 正常値の構築にはaslib::in_place_successを用いる.
+ * @code
+ *	aslib::Result<void, Error> save() {
+ *		if(isFailure) return Error();
+ *		return aslib::Result<void, Error>(aslib::in_place_success);
+ *	}
+ * @endcode
+ * @param[in]	F	エラー値の型.
+ */
+template<typename F>
+class Result<void, F> {
+	typedef Result<detail::ResultVoidValue, F> Impl;
+
+public:	// public types {{{
+	/// 正常値の型.
+	typedef void SucceededType;
+	/// エラー値の型.
+	typedef F FailedType;
+
+	/// @sa	aslib::Result::NotHaveFailedObject
+	typedef typename Impl::NotHaveFailedObject NotHaveFailedObject;
 // }}}
+
+public:	// constructors / destructor {{{
+	ASLIB_RESULT_CONSTEXPR Result() {}
+	/// 成功を表すResultを構築する.
+	explicit
+	ASLIB_RESULT_CONSTEXPR Result(InPlaceSuccessTag) : impl_(in_place_success) {}
+	/// @param[in]	src	エラー値.
+	ASLIB_RESULT_CONSTEXPR Result(const FailedType &src) : impl_(src) {}
+	/// @param[in]	src	エラー値.
+	ASLIB_RESULT_CONSTEXPR Result(FailedType &&src) : impl_(std::move(src)) {}
+	/// @param[in]	args	FailedTypeのコンストラクタへ渡す引数.
+	template<typename... Args>
+	explicit
+	ASLIB_RESULT_CONSTEXPR Result(InPlaceFailureTag, Args &&...args) : impl_(in_place_failure, std::forward<Args>(args)...) {}
+	/// @sa	aslib::Result::Result(detail::ResultReturnSlotTag, My **)
+	explicit
+	ASLIB_RESULT_CONSTEXPR Result(detail::ResultReturnSlotTag, Result **slot) { *slot = this; }
+// }}}
+
+public:	// functions / operators {{{
+	/// @return	成功を表しているならばtrue.
+	ASLIB_RESULT_CONSTEXPR operator bool() const { return static_cast<bool>(impl_); }
+
+	/**
+	 * @return	エラー値を保持している場合のみ、その値への参照を返す.
+	 * @exception	aslib::Result::NotHaveFailedObject	エラー値を保持していない場合に発生する.
+	 */
+	ASLIB_RESULT_CONSTEXPR FailedType &fail() { return impl_.fail(); }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const FailedType &fail() const { return impl_.fail(); }
+
+	/// @return	エラー値を保持している場合はその値へのポインタ. それ以外の場合はnullptr.
+	ASLIB_RESULT_CONSTEXPR FailedType *fail_if() { return impl_.fail_if(); }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const FailedType *fail_if() const { return impl_.fail_if(); }
+
+	/// 保持している値の種類を確認せずに、エラー値へアクセスする. 確認はデバッグビルドのassertのみで行う.
+	ASLIB_RESULT_CONSTEXPR FailedType &unchecked_fail() { return impl_.unchecked_fail(); }
+	/// @overload
+	ASLIB_RESULT_CONSTEXPR const FailedType &unchecked_fail() const { return impl_.unchecked_fail(); }
+
+	ASLIB_RESULT_CONSTEXPR Result &operator=(const FailedType &rhs) { impl_ = rhs; return *this; }
+	ASLIB_RESULT_CONSTEXPR Result &operator=(FailedType &&rhs) { impl_ = std::move(rhs); return *this; }
+
+	/// 保持しているエラー値を破棄し、成功を表す状態にする.
+	ASLIB_RESULT_CONSTEXPR void emplace_success() { impl_.emplace_success(); }
+	/// @sa	aslib::Result::emplace_failure
+	template<typename... Args>
+	ASLIB_RESULT_CONSTEXPR FailedType &emplace_failure(Args &&...args) { return impl_.emplace_failure(std::forward<Args>(args)...); }
+// }}}
+
+public:	// combinators {{{
+	/*
+	 * aslib::Resultのコンビネータと同じ. 正常値を受け取る関数オブジェクトは、引数無しで呼び出す.
+	 */
+
+	/// @sa	aslib::Result::map
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<detail::ResultInvokeTypeNoArg<Func>, FailedType> map(Func &&func) && {
+		typedef Result<detail::ResultInvokeTypeNoArg<Func>, FailedType> ReturnType;
+		if(impl_) return ReturnType(std::forward<Func>(func)());
+		if(impl_.fail_if()) return ReturnType(std::move(unchecked_fail()));
+		return ReturnType();
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<detail::ResultInvokeTypeNoArg<Func>, FailedType> map(Func &&func) const & {
+		typedef Result<detail::ResultInvokeTypeNoArg<Func>, FailedType> ReturnType;
+		if(impl_) return ReturnType(std::forward<Func>(func)());
+		if(impl_.fail_if()) return ReturnType(unchecked_fail());
+		return ReturnType();
+	}
+
+	/// @sa	aslib::Result::and_then
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeTypeNoArg<Func> and_then(Func &&func) && {
+		typedef detail::ResultInvokeTypeNoArg<Func> ReturnType;
+		if(impl_) return std::forward<Func>(func)();
+		if(impl_.fail_if()) return ReturnType(std::move(unchecked_fail()));
+		return ReturnType();
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeTypeNoArg<Func> and_then(Func &&func) const & {
+		typedef detail::ResultInvokeTypeNoArg<Func> ReturnType;
+		if(impl_) return std::forward<Func>(func)();
+		if(impl_.fail_if()) return ReturnType(unchecked_fail());
+		return ReturnType();
+	}
+
+	/// @sa	aslib::Result::or_else
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, FailedType> or_else(Func &&func) && {
+		typedef detail::ResultInvokeType<Func, FailedType> ReturnType;
+		if(impl_) return ReturnType(in_place_success);
+		if(impl_.fail_if()) return std::forward<Func>(func)(std::move(unchecked_fail()));
+		return ReturnType();
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR detail::ResultInvokeType<Func, const FailedType &> or_else(Func &&func) const & {
+		typedef detail::ResultInvokeType<Func, const FailedType &> ReturnType;
+		if(impl_) return ReturnType(in_place_success);
+		if(impl_.fail_if()) return std::forward<Func>(func)(unchecked_fail());
+		return ReturnType();
+	}
+
+	/// @sa	aslib::Result::map_error
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<void, detail::ResultInvokeType<Func, FailedType> > map_error(Func &&func) && {
+		typedef Result<void, detail::ResultInvokeType<Func, FailedType> > ReturnType;
+		if(impl_) return ReturnType(in_place_success);
+		if(impl_.fail_if()) return ReturnType(std::forward<Func>(func)(std::move(unchecked_fail())));
+		return ReturnType();
+	}
+	/// @overload
+	template<typename Func>
+	ASLIB_RESULT_CONSTEXPR Result<void, detail::ResultInvokeType<Func, const FailedType &> > map_error(Func &&func) const & {
+		typedef Result<void, detail::ResultInvokeType<Func, const FailedType &> > ReturnType;
+		if(impl_) return ReturnType(in_place_success);
+		if(impl_.fail_if()) return ReturnType(std::forward<Func>(func)(unchecked_fail()));
+		return ReturnType();
+	}
+// }}}
+
+private:	// fields {{{
+	Impl impl_;
+// }}}
+};
+
+namespace detail {
+
+/**
+ * ASLIB_TRYで呼出元へ返すエラー値.
+ * 戻り値の型を知らずに済むよう、任意のResult<T, G>へ変換出来る. 変換時にエラー値を1度だけムーブ(左辺値から作った場合はコピー)する.
+ * @param[in]	Ref	エラー値の参照型. F &&またはconst F &.
+ */
+template<typename Ref>
+class ResultPropagation {
+public:
+	/// @param[in]	failed	エラー値へのポインタ. 未初期化のResultから作る場合はnullptr.
+	ASLIB_RESULT_CONSTEXPR explicit ResultPropagation(typename std::remove_reference<Ref>::type *failed) : failed_(failed) {}
+
+	/// @return	エラー値を保持したResult. 元のResultが未初期化ならば、未初期化のResult.
+	template<typename T, typename G>
+	ASLIB_RESULT_CONSTEXPR operator Result<T, G>() const {
+		if(!failed_) return Result<T, G>();
+		return Result<T, G>(in_place_failure, static_cast<Ref>(*failed_));
+	}
+
+	/// @return	エラー値へのポインタ. 未初期化のResultから作った場合はnullptr. Result以外の戻り値の型への変換に用いる.
+	ASLIB_RESULT_CONSTEXPR typename std::remove_reference<Ref>::type *get() const { return failed_; }
+
+private:
+	typename std::remove_reference<Ref>::type *failed_;
 };
 
+/// @return	srcのエラー値を呼出元へ返す為のResultPropagation. 右辺値ならばムーブする.
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR ResultPropagation<F &&> resultPropagate(Result<S, F> &&src) { return ResultPropagation<F &&>(src.fail_if()); }
+/// @overload
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR ResultPropagation<const F &> resultPropagate(const Result<S, F> &src) { return ResultPropagation<const F &>(src.fail_if()); }
+
+/**
+ * ASLIB_TRY_ASSIGNで取り出す正常値.
+ * 右辺値のResultからはムーブし、左辺値からは参照を返す. Result<T &, F>は参照先を、Result<void, F>は何も返さない.
+ */
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR S &&resultTakeValue(Result<S, F> &&src) { return std::move(src.unchecked_value()); }
+/// @overload
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR S &resultTakeValue(Result<S, F> &src) { return src.unchecked_value(); }
+/// @overload
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR const S &resultTakeValue(const Result<S, F> &src) { return src.unchecked_value(); }
+/// @overload
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR S &resultTakeValue(Result<S &, F> &&src) { return src.unchecked_value(); }
+/// @overload
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR S &resultTakeValue(Result<S &, F> &src) { return src.unchecked_value(); }
+/// @overload
+template<typename S, typename F>
+ASLIB_RESULT_CONSTEXPR S &resultTakeValue(const Result<S &, F> &src) { return src.unchecked_value(); }
+/// @overload
+template<typename F>
+ASLIB_RESULT_CONSTEXPR void resultTakeValue(const Result<void, F> &) {}
+
+}	// namespace detail
+
 }	// namespace aslib
 
+/// @cond
+#define ASLIB_RESULT_CONCAT_IMPL_(a, b) a##b
+#define ASLIB_RESULT_CONCAT_(a, b) ASLIB_RESULT_CONCAT_IMPL_(a, b)
+#define ASLIB_TRY_ASSIGN_IMPL_(tmp, lhs, ...) \
+	auto &&tmp = (__VA_ARGS__); \
+	if(!tmp) return ::aslib::detail::resultPropagate(std::forward<decltype(tmp)>(tmp)); \
+	lhs = ::aslib::detail::resultTakeValue(std::forward<decltype(tmp)>(tmp))
+/// @endcond
+
+/**
+ * exprを評価し、正常値でなければ、そのエラー値を呼出元の関数の戻り値として直ちに返す.
+ * 手で書いた if(!r) return r.fail(); と同じ分岐になるが、一時オブジェクトのエラー値はコピーせずにムーブする.
+ * 呼出元の関数の戻り値はResult<T, G>(GはFから構築出来る型)である事. 未初期化のResultは、未初期化のまま返す.
+ * @code
+ *	aslib::Result<void, Error> save(const Config &config) {
+ *		ASLIB_TRY(validate(config));	// validateがResult<void, Error>を返す
+ *		...
+ *	}
+ * @endcode
+ * @param[in]	...	Resultを返す式. テンプレート引数等のカンマを含んでも良い.
+ */
+#define ASLIB_TRY(...) \
+	do { \
+		auto &&aslibTryResult_ = (__VA_ARGS__); \
+		if(!aslibTryResult_) return ::aslib::detail::resultPropagate(std::forward<decltype(aslibTryResult_)>(aslibTryResult_)); \
+	} while(false)
+
+/**
+ * ASLIB_TRYと同じくエラー値を呼出元へ返し、正常値であればその値をlhsへ代入する.
+ * exprが一時オブジェクトならば正常値もムーブする. 複数の文に展開される為、ifの本体等に用いる場合は{}で囲む事.
+ * @code
+ *	aslib::Result<Port, Error> parsePort(const std::string &text) {
+ *		ASLIB_TRY_ASSIGN(const int value, parseInt(text));	// 宣言も、既存の変数への代入も書ける
+ *		if(value < 0 || 65535 < value) return Error("out of range");
+ *		return Port(value);
+ *	}
+ * @endcode
+ * @param[in]	lhs	正常値を受け取る変数の宣言、または左辺値.
+ * @param[in]	...	Resultを返す式.
+ */
+#define ASLIB_TRY_ASSIGN(lhs, ...) ASLIB_TRY_ASSIGN_IMPL_(ASLIB_RESULT_CONCAT_(aslibTryResult, __LINE__), lhs, __VA_ARGS__)
+
 #endif	// ASLIB_INCLUDED_RESULT_HPP_
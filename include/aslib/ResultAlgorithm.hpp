@@ -0,0 +1,223 @@
+﻿/**
+ * @file
+ * aslib::Resultの列に対するアルゴリズム.
+ */
+#ifndef ASLIB_INCLUDED_RESULTALGORITHM_HPP_
+#define ASLIB_INCLUDED_RESULTALGORITHM_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <aslib/Config.hpp>
+#include <aslib/Result.hpp>
+
+/**
+ * 実行ポリシーを取る並列アルゴリズム(C++17の<execution>)が使用出来るならば1. libstdc++ではTBBのリンクが必要になる為、不要ならば0を定義しておく.
+ * <execution>の読込みだけでTBBのリンクが必要になる環境がある為、判定はaslib/Config.hppではなく、このヘッダでのみ行う.
+ */
+#if !defined(ASLIB_HAS_PARALLEL_ALGORITHMS)
+#	if ASLIB_CPLUSPLUS >= 201703L && defined(__has_include)
+#		if __has_include(<execution>)
+#			include <execution>
+#			if defined(__cpp_lib_execution) || defined(_MSC_VER)
+#				define ASLIB_HAS_PARALLEL_ALGORITHMS 1
+#			endif
+#		endif
+#	endif
+#endif
+#if !defined(ASLIB_HAS_PARALLEL_ALGORITHMS)
+#	define ASLIB_HAS_PARALLEL_ALGORITHMS 0
+#endif
+#if ASLIB_HAS_PARALLEL_ALGORITHMS
+#	include <execution>
+#endif
+
+namespace aslib {
+
+namespace detail {
+
+/// イテレータの要素型であるResultの正常値・エラー値の型を取り出す.
+template<typename Iterator>
+struct ResultRangeTraits {
+	typedef typename std::decay<typename std::iterator_traits<Iterator>::value_type>::type ResultType;
+	typedef typename ResultType::SucceededType SucceededType;
+	typedef typename ResultType::FailedType FailedType;
+	/// *iteratorが右辺値参照(std::move_iteratorなど)ならばtrue. その場合、値をムーブする.
+	static const bool movable = std::is_rvalue_reference<typename std::iterator_traits<Iterator>::reference>::value;
+};
+
+/// movableならば値をムーブし、それ以外はコピーする為の参照を返す. Tはconst修飾されていても良い.
+template<bool movable, typename T>
+typename std::conditional<movable, T &&, const T &>::type forwardResultValue(T &value) {
+	return static_cast<typename std::conditional<movable, T &&, const T &>::type>(value);
+}
+
+/// 要素数が事前に分かる範囲ならば、その数を返す. 分からなければ0.
+template<typename Iterator>
+std::size_t resultRangeSize(Iterator first, Iterator last, std::forward_iterator_tag) {
+	return static_cast<std::size_t>(std::distance(first, last));
+}
+template<typename Iterator>
+std::size_t resultRangeSize(Iterator, Iterator, std::input_iterator_tag) {
+	return 0;
+}
+
+}	// namespace detail
+
+/**
+ * Resultの列を、正常値の配列を持つResultにまとめる.
+ * 全ての要素が正常値であれば、その配列を正常値として返す. 正常値でない要素があれば、最初のそれと同じ状態(エラー値か未初期化)のResultを返し、以降の要素は走査しない.
+ * 配列の領域確保は、前方向イテレータならば1度のみ行う. std::move_iteratorを渡した場合は、各要素の値をムーブする.
+ * @code
+ *	std::vector<aslib::Result<Record, Error> > parsed = ...;
+ *	aslib::Result<std::vector<Record>, Error> all = aslib::collect(std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+ * @endcode
+ * @param[in]	first	範囲の先頭.
+ * @param[in]	last	範囲の末尾の次.
+ * @return	正常値の配列、或いは最初のエラー値.
+ */
+template<typename InputIterator>
+Result<std::vector<typename detail::ResultRangeTraits<InputIterator>::SucceededType>, typename detail::ResultRangeTraits<InputIterator>::FailedType>
+collect(InputIterator first, InputIterator last) {
+	typedef detail::ResultRangeTraits<InputIterator> Traits;
+	typedef Result<std::vector<typename Traits::SucceededType>, typename Traits::FailedType> ReturnType;
+
+	std::vector<typename Traits::SucceededType> values;
+	values.reserve(detail::resultRangeSize(first, last, typename std::iterator_traits<InputIterator>::iterator_category()));
+	for(; first != last; ++first) {
+		auto &&r = *first;
+		if(r) {
+			values.push_back(detail::forwardResultValue<Traits::movable>(r.unchecked_value()));
+		} else if(r.fail_if()) {
+			return ReturnType(detail::forwardResultValue<Traits::movable>(r.unchecked_fail()));
+		} else {
+			return ReturnType();
+		}
+	}
+	return ReturnType(std::move(values));
+}
+
+/**
+ * 右辺値の配列から、各要素の値をムーブしてまとめる.
+ * @sa	aslib::collect(InputIterator, InputIterator)
+ */
+template<typename S, typename F>
+Result<std::vector<S>, F> collect(std::vector<Result<S, F> > &&results) {
+	return collect(std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
+}
+
+/**
+ * Resultの列を、正常値の配列とエラー値の配列に分ける. それぞれ元の順序を保つ. 未初期化の要素は無視する.
+ * 前方向イテレータならば、最初に個数を数えて双方の配列の領域確保を1度のみ行う. std::move_iteratorを渡した場合は、各要素の値をムーブする.
+ * @param[in]	first	範囲の先頭.
+ * @param[in]	last	範囲の末尾の次.
+ * @return	firstが正常値の配列、secondがエラー値の配列.
+ */
+template<typename InputIterator>
+std::pair<std::vector<typename detail::ResultRangeTraits<InputIterator>::SucceededType>, std::vector<typename detail::ResultRangeTraits<InputIterator>::FailedType> >
+partition_results(InputIterator first, InputIterator last) {
+	typedef detail::ResultRangeTraits<InputIterator> Traits;
+	typedef typename Traits::ResultType ResultType;
+
+	std::pair<std::vector<typename Traits::SucceededType>, std::vector<typename Traits::FailedType> > partitioned;
+	if(std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<InputIterator>::iterator_category>::value) {
+		std::size_t succeeded = 0, failed = 0;
+		for(InputIterator it = first; it != last; ++it) {
+			const ResultType &r = *it;
+			if(r) ++succeeded;
+			else if(r.fail_if()) ++failed;
+		}
+		partitioned.first.reserve(succeeded);
+		partitioned.second.reserve(failed);
+	}
+	for(; first != last; ++first) {
+		auto &&r = *first;
+		if(r) partitioned.first.push_back(detail::forwardResultValue<Traits::movable>(r.unchecked_value()));
+		else if(r.fail_if()) partitioned.second.push_back(detail::forwardResultValue<Traits::movable>(r.unchecked_fail()));
+	}
+	return partitioned;
+}
+
+/**
+ * 右辺値の配列から、各要素の値をムーブして分ける.
+ * @sa	aslib::partition_results(InputIterator, InputIterator)
+ */
+template<typename S, typename F>
+std::pair<std::vector<S>, std::vector<F> > partition_results(std::vector<Result<S, F> > &&results) {
+	return partition_results(std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
+}
+
+#if ASLIB_HAS_PARALLEL_ALGORITHMS
+/**
+ * 実行ポリシーを指定するcollect.
+ * 正常値でない要素の探索を並列に行い、いずれかのスレッドが見つけた時点で、それ以降の範囲の探索を打ち切る. 見つからなければ、全ての値を並列にムーブ(またはコピー)する.
+ * 値の並列な移動は正常値の型が例外を送出せずにデフォルト構築出来る場合のみ行い、それ以外は逐次的に移動する.
+ * @param[in]	policy	std::execution::parなどの実行ポリシー.
+ * @param[in]	first	範囲の先頭. ランダムアクセスイテレータである事.
+ * @param[in]	last	範囲の末尾の次.
+ * @sa	aslib::collect(InputIterator, InputIterator)
+ */
+template<typename ExecutionPolicy, typename RandomAccessIterator, typename = typename std::enable_if<std::is_execution_policy<typename std::decay<ExecutionPolicy>::type>::value>::type>
+Result<std::vector<typename detail::ResultRangeTraits<RandomAccessIterator>::SucceededType>, typename detail::ResultRangeTraits<RandomAccessIterator>::FailedType>
+collect(ExecutionPolicy &&policy, RandomAccessIterator first, RandomAccessIterator last) {
+	typedef detail::ResultRangeTraits<RandomAccessIterator> Traits;
+	typedef typename Traits::ResultType ResultType;
+	typedef typename Traits::SucceededType SucceededType;
+	typedef Result<std::vector<SucceededType>, typename Traits::FailedType> ReturnType;
+
+	const RandomAccessIterator found = std::find_if(policy, first, last, [](const ResultType &r) { return !r; });
+	if(found != last) {
+		auto &&r = *found;
+		if(!r.fail_if()) return ReturnType();
+		return ReturnType(detail::forwardResultValue<Traits::movable>(r.unchecked_fail()));
+	}
+
+	std::vector<SucceededType> values;
+	if constexpr(std::is_nothrow_default_constructible<SucceededType>::value) {
+		values.resize(static_cast<std::size_t>(last - first));
+		std::transform(policy, first, last, values.begin(), [](auto &&r) -> SucceededType {
+			return detail::forwardResultValue<Traits::movable>(r.unchecked_value());
+		});
+	} else {
+		values.reserve(static_cast<std::size_t>(last - first));
+		for(; first != last; ++first) {
+			auto &&r = *first;
+			values.push_back(detail::forwardResultValue<Traits::movable>(r.unchecked_value()));
+		}
+	}
+	return ReturnType(std::move(values));
+}
+
+/**
+ * 実行ポリシーを指定するpartition_results.
+ * 正常値・エラー値の数えあげを並列に行い、双方の配列の領域確保を1度のみ行った後、順序を保って逐次的に振り分ける.
+ * @param[in]	policy	std::execution::parなどの実行ポリシー.
+ * @param[in]	first	範囲の先頭. ランダムアクセスイテレータである事.
+ * @param[in]	last	範囲の末尾の次.
+ * @sa	aslib::partition_results(InputIterator, InputIterator)
+ */
+template<typename ExecutionPolicy, typename RandomAccessIterator, typename = typename std::enable_if<std::is_execution_policy<typename std::decay<ExecutionPolicy>::type>::value>::type>
+std::pair<std::vector<typename detail::ResultRangeTraits<RandomAccessIterator>::SucceededType>, std::vector<typename detail::ResultRangeTraits<RandomAccessIterator>::FailedType> >
+partition_results(ExecutionPolicy &&policy, RandomAccessIterator first, RandomAccessIterator last) {
+	typedef detail::ResultRangeTraits<RandomAccessIterator> Traits;
+	typedef typename Traits::ResultType ResultType;
+
+	std::pair<std::vector<typename Traits::SucceededType>, std::vector<typename Traits::FailedType> > partitioned;
+	partitioned.first.reserve(static_cast<std::size_t>(std::count_if(policy, first, last, [](const ResultType &r) { return static_cast<bool>(r); })));
+	partitioned.second.reserve(static_cast<std::size_t>(std::count_if(policy, first, last, [](const ResultType &r) { return r.fail_if() != nullptr; })));
+	for(; first != last; ++first) {
+		auto &&r = *first;
+		if(r) partitioned.first.push_back(detail::forwardResultValue<Traits::movable>(r.unchecked_value()));
+		else if(r.fail_if()) partitioned.second.push_back(detail::forwardResultValue<Traits::movable>(r.unchecked_fail()));
+	}
+	return partitioned;
+}
+#endif	// ASLIB_HAS_PARALLEL_ALGORITHMS
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_RESULTALGORITHM_HPP_
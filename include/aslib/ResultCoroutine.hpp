@@ -0,0 +1,173 @@
+﻿/**
+ * @file
+ * aslib::ResultをC++20のコルーチンの戻り値として用いる為の定義.
+ * Result<S, F>を返す関数の中でco_awaitにResultを渡すと、正常値ならばその値を取り出して処理を続け、エラー値ならばそれをムーブして直ちに呼出元へ返す.
+ * @code
+ *	aslib::Result<Config, Error> load(const std::string &path) {
+ *		std::string text = co_await readFile(path);	// readFileはResult<std::string, Error>を返す
+ *		Config config = co_await parse(text);
+ *		co_return config;
+ *	}
+ * @endcode
+ * コルーチンは途中で中断せずに完了するが、呼出毎にコルーチンフレームを確保する(コンパイラが省略しない限り).
+ * 頻繁に呼ばれる関数では、代わりにASLIB_TRY・ASLIB_TRY_ASSIGN(aslib/Result.hpp)を用いる事.
+ * ASLIB_HAS_COROUTINEが0の場合は何も定義しない.
+ */
+#ifndef ASLIB_INCLUDED_RESULTCOROUTINE_HPP_
+#define ASLIB_INCLUDED_RESULTCOROUTINE_HPP_
+
+#include <aslib/Config.hpp>
+#include <aslib/Result.hpp>
+
+#if ASLIB_HAS_COROUTINE
+#	include <coroutine>
+#	include <type_traits>
+#	include <utility>
+
+namespace aslib {
+
+namespace detail {
+
+template<typename S, typename F>
+class ResultPromiseBase;
+
+/**
+ * ResultPromise::get_return_object()の戻り値. Result<S, F>へ変換して呼出元へ返す.
+ * 変換の時期はコンパイラにより異なり、コルーチンの本体の実行前(Clang 16以前)と実行後(GCC、MSVC、Clang 17以降)のいずれにも対応する.
+ * 実行前に変換される場合は、変換先のResultのアドレスをResultPromiseへ渡し、本体の結果を直接書き込ませる.
+ * 但し自明にコピー出来るResultはレジスタで返され、アドレスが変わる為、その場合はコンパイル時エラーにする.
+ * 実行後に変換される場合は、本体の結果をこのオブジェクト内に受け取り、変換時にムーブする.
+ */
+template<typename S, typename F>
+class ResultReturnObject {
+	friend class ResultPromiseBase<S, F>;
+
+public:
+	explicit ResultReturnObject(ResultPromiseBase<S, F> &promise) : promise_(&promise) { promise.bind(this, &storage_); }
+	ResultReturnObject(ResultReturnObject &&src) : storage_(std::move(src.storage_)), promise_(src.promise_) {
+		src.promise_ = nullptr;
+		if(promise_) promise_->bind(this, &storage_);
+	}
+	ResultReturnObject &operator=(const ResultReturnObject &) = delete;
+	~ResultReturnObject() { if(promise_) promise_->bind(nullptr, nullptr); }
+
+	operator Result<S, F>() {
+		if(!promise_) return std::move(storage_);
+
+		ResultPromiseBase<S, F> *promise = promise_;
+		promise_ = nullptr;
+		promise->bind(nullptr, nullptr);
+		return Result<S, F>(ResultReturnSlotTag(), &promise->target_);
+	}
+
+private:
+	/// 本体の実行後に変換される場合に、本体の結果を受け取る.
+	Result<S, F> storage_;
+	/// 本体の実行が終わっていなければ、そのResultPromise. 終わった後はnullptr.
+	ResultPromiseBase<S, F> *promise_;
+};
+
+/**
+ * co_awaitに渡したResultの待機.
+ * 正常値ならば中断せずに値を返し、エラー値ならばそれをコルーチンの戻り値へ移してコルーチンを破棄する.
+ * @param[in]	Awaited	co_awaitに渡したResultの参照型. 右辺値参照ならば、エラー値と正常値をムーブする.
+ */
+template<typename Awaited>
+class ResultAwaiter {
+	typedef typename std::remove_reference<Awaited>::type ResultType;
+
+public:
+	explicit ResultAwaiter(ResultType &awaited) : awaited_(&awaited) {}
+
+	bool await_ready() const noexcept { return static_cast<bool>(*awaited_); }
+	template<typename Promise>
+	void await_suspend(std::coroutine_handle<Promise> handle) {
+		handle.promise().propagate(resultPropagate(static_cast<Awaited>(*awaited_)));
+		handle.destroy();
+	}
+	decltype(auto) await_resume() { return resultTakeValue(static_cast<Awaited>(*awaited_)); }
+
+private:
+	ResultType *awaited_;
+};
+
+/// ResultPromiseの、戻り値の型に依らない部分.
+template<typename S, typename F>
+class ResultPromiseBase {
+	friend class ResultReturnObject<S, F>;
+
+#	if defined(__clang__) && __clang_major__ < 17
+	static_assert(!std::is_trivially_copyable<Result<S, F> >::value, "Clang 16 or earlier cannot return a trivially copyable Result from a coroutine.");
+#	endif
+
+public:
+	ResultPromiseBase() : target_(nullptr), return_(nullptr) {}
+	ResultPromiseBase(const ResultPromiseBase &) = delete;
+	ResultPromiseBase &operator=(const ResultPromiseBase &) = delete;
+	/// 本体の実行後に変換されるResultReturnObjectへ、実行が終わった事を伝える.
+	~ResultPromiseBase() { if(return_) return_->promise_ = nullptr; }
+
+	ResultReturnObject<S, F> get_return_object() { return ResultReturnObject<S, F>(*this); }
+	std::suspend_never initial_suspend() noexcept { return {}; }
+	std::suspend_never final_suspend() noexcept { return {}; }
+	void unhandled_exception() { throw; }
+
+	/// co_awaitにはResultのみを渡せる.
+	template<typename T, typename G>
+	ResultAwaiter<Result<T, G> &&> await_transform(Result<T, G> &&awaited) { return ResultAwaiter<Result<T, G> &&>(awaited); }
+	/// @overload
+	template<typename T, typename G>
+	ResultAwaiter<Result<T, G> &> await_transform(Result<T, G> &awaited) { return ResultAwaiter<Result<T, G> &>(awaited); }
+	/// @overload
+	template<typename T, typename G>
+	ResultAwaiter<const Result<T, G> &> await_transform(const Result<T, G> &awaited) { return ResultAwaiter<const Result<T, G> &>(awaited); }
+
+	/// co_awaitに渡したResultのエラー値を、コルーチンの戻り値にする.
+	template<typename Ref>
+	void propagate(const ResultPropagation<Ref> &propagation) { *target_ = propagation; }
+
+	/// 本体の結果を受け取るResultReturnObjectとResultを設定する.
+	void bind(ResultReturnObject<S, F> *returnObject, Result<S, F> *target) {
+		return_ = returnObject;
+		if(target) target_ = target;
+	}
+
+protected:
+	/// コルーチンの戻り値の書き込み先.
+	Result<S, F> *target_;
+	/// 本体の実行後に変換される場合の、ResultReturnObject.
+	ResultReturnObject<S, F> *return_;
+};
+
+/// Result<S, F>を返すコルーチンのpromise_type.
+template<typename S, typename F>
+class ResultPromise : public ResultPromiseBase<S, F> {
+public:
+	/// co_returnの値. SかF、またはResult<S, F>に変換出来る値.
+	template<typename U>
+	void return_value(U &&value) { *this->target_ = Result<S, F>(std::forward<U>(value)); }
+};
+
+/// Result<void, F>を返すコルーチンのpromise_type. co_return;で成功を返す.
+template<typename F>
+class ResultPromise<void, F> : public ResultPromiseBase<void, F> {
+public:
+	void return_void() { *this->target_ = Result<void, F>(in_place_success); }
+};
+
+}	// namespace detail
+
+}	// namespace aslib
+
+namespace std {
+
+/// Result<S, F>を返す関数をコルーチンにする.
+template<typename S, typename F, typename... Args>
+struct coroutine_traits<aslib::Result<S, F>, Args...> {
+	typedef aslib::detail::ResultPromise<S, F> promise_type;
+};
+
+}	// namespace std
+#endif
+
+#endif	// ASLIB_INCLUDED_RESULTCOROUTINE_HPP_
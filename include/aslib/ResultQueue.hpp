@@ -0,0 +1,253 @@
+﻿/**
+ * @file
+ * 複数のスレッド間でaslib::Resultを受け渡す、ロックを用いないキュー.
+ */
+#ifndef ASLIB_INCLUDED_RESULTQUEUE_HPP_
+#define ASLIB_INCLUDED_RESULTQUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <aslib/Result.hpp>
+
+namespace aslib {
+
+namespace detail {
+
+/// ResultQueueで、スレッド毎に更新する変数を別のキャッシュラインに置く為のキャッシュラインのサイズ.
+static const std::size_t resultQueueCacheLine = 64;
+
+/// @return	n以上の最小の2の冪. 2未満ならば2.
+inline std::size_t resultQueueCapacity(std::size_t n) {
+	std::size_t capacity = 2;
+	while(capacity < n) capacity <<= 1;
+	return capacity;
+}
+
+/**
+ * ResultQueueの位置(リングバッファへの添字).
+ * 生産者同士・消費者同士の競合が他方の位置に及ばないよう、前後をキャッシュラインのサイズまで詰め物をする.
+ * (C++17より前はnewが拡張アライメントを扱えない為、alignasは用いない)
+ */
+struct ResultQueuePosition {
+	ResultQueuePosition() : value(0) {}
+
+	char leading_[resultQueueCacheLine];
+	std::atomic<std::size_t> value;
+	char trailing_[resultQueueCacheLine - sizeof(std::atomic<std::size_t>)];
+};
+
+}	// namespace detail
+
+/**
+ * 複数の生産者と複数の消費者の間でResult<S, F>を受け渡す、容量固定のキュー.
+ * std::mutexで保護したstd::dequeの代わりに用いる. ロックを用いず、要素の追加・取出しはそれぞれ1回のcompare_exchangeで位置を確保する.
+ * 要素は確保済みのリングバッファ内にResult<S, F>として直接格納し、追加時と取出し時に1度ずつムーブする. 動的確保は構築時のみ行う.
+ * @code
+ *	aslib::ResultQueue<Record, ParseError> queue(1024);
+ *	// 解析スレッド
+ *	while(!queue.try_push(parse(line))) std::this_thread::yield();
+ *	// 書込スレッド
+ *	aslib::Result<Record, ParseError> records[64];
+ *	const std::size_t n = queue.try_pop_bulk(records, 64);	// 一度に最大64件を取り出す
+ * @endcode
+ * 各要素は、リングバッファ上の位置毎の通し番号で状態(空き・格納済み)を表す(D. Vyukovの有界MPMCキュー).
+ * try_push_bulk/try_pop_bulkは連続するn件の位置をまとめて確保する為、位置の更新による競合がn分の1になる.
+ * 追加の途中で例外が発生すると、確保した位置が空きのまま残り、以降の取出しが出来なくなる.
+ * その為、S・Fは例外を送出しないムーブコンストラクタを持つ事. コピーによる追加は、位置を確保する前にコピーを作る.
+ * @param[in]	S	正常値の型.
+ * @param[in]	F	エラー値の型.
+ */
+template<typename S, typename F>
+class ResultQueue {
+public:	// public types {{{
+	/// 要素の型.
+	typedef Result<S, F> ResultType;
+// }}}
+
+	static_assert(std::is_nothrow_move_constructible<ResultType>::value, "ResultQueue requires nothrow move constructible S and F.");
+
+private:	// private types {{{
+	/// リングバッファの要素. sequenceが位置と等しければ空き、位置+1ならば格納済み.
+	struct Cell {
+		std::atomic<std::size_t> sequence;
+		typename std::aligned_storage<sizeof(ResultType), alignof(ResultType)>::type storage;
+
+		ResultType *get() { return reinterpret_cast<ResultType *>(&storage); }
+	};
+// }}}
+
+public:	// constructors / destructor {{{
+	/**
+	 * @param[in]	capacity	格納出来る要素の最大数. 2の冪に切り上げる.
+	 */
+	explicit ResultQueue(std::size_t capacity) : mask_(detail::resultQueueCapacity(capacity) - 1), cells_(new Cell[mask_ + 1]) {
+		for(std::size_t i = 0; i <= mask_; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	ResultQueue(const ResultQueue &) = delete;
+	ResultQueue &operator=(const ResultQueue &) = delete;
+	/// 残っている要素を破棄する. 他のスレッドが操作中であってはならない.
+	~ResultQueue() {
+		const std::size_t last = enqueuePosition_.value.load(std::memory_order_relaxed);
+		for(std::size_t pos = dequeuePosition_.value.load(std::memory_order_relaxed); pos != last; ++pos) {
+			cells_[pos & mask_].get()->~ResultType();
+		}
+	}
+// }}}
+
+public:	// functions {{{
+	/// @return	格納出来る要素の最大数.
+	std::size_t capacity() const { return mask_ + 1; }
+
+	/**
+	 * 要素を末尾に追加する.
+	 * @param[in]	value	追加する値. 追加出来た場合はムーブする.
+	 * @return	追加出来ればtrue. キューが満杯ならばfalseを返し、valueは変更しない.
+	 */
+	bool try_push(ResultType &&value) {
+		std::size_t pos = 0;
+		if(reserve(enqueuePosition_, 1, 0, pos) == 0) return false;
+		publish(pos, std::move(value));
+		return true;
+	}
+	/// @overload
+	bool try_push(const ResultType &value) {
+		// 確保した位置へのコピーが失敗しないよう、先にコピーする
+		ResultType copy(value);
+		return try_push(std::move(copy));
+	}
+
+	/**
+	 * 要素を先頭から取り出す.
+	 * @param[out]	out	取り出した値をムーブ代入する. 代入で例外が発生した場合、取り出した要素は破棄する.
+	 * @return	取り出せればtrue. キューが空ならばfalseを返し、outは変更しない.
+	 */
+	bool try_pop(ResultType &out) {
+		std::size_t pos = 0;
+		if(reserve(dequeuePosition_, 1, 1, pos) == 0) return false;
+		consume(pos, out);
+		return true;
+	}
+
+	/**
+	 * [first, last)の要素を、連続する位置へまとめて追加する. 追加した要素はムーブする.
+	 * 空きが足りなければ、先頭から空きの数だけ追加する.
+	 * @param[in]	first	追加するResultTypeの列の先頭を指す前方反復子.
+	 * @param[in]	last	列の末尾を指す前方反復子.
+	 * @return	追加した要素の数. 追加した要素はfirstから数える.
+	 */
+	template<typename ForwardIterator>
+	std::size_t try_push_bulk(ForwardIterator first, ForwardIterator last) {
+		std::size_t pos = 0;
+		const std::size_t n = reserve(enqueuePosition_, static_cast<std::size_t>(std::distance(first, last)), 0, pos);
+		for(std::size_t i = 0; i < n; ++i, ++first) publish(pos + i, std::move(*first));
+		return n;
+	}
+
+	/**
+	 * 先頭から最大count件の要素をまとめて取り出す.
+	 * outへの代入で例外が発生した場合、まとめて確保した残りの要素は破棄する.
+	 * @param[out]	out	取り出した値をムーブ代入する出力反復子.
+	 * @param[in]	count	取り出す最大の数.
+	 * @return	取り出した要素の数.
+	 */
+	template<typename OutputIterator>
+	std::size_t try_pop_bulk(OutputIterator out, std::size_t count) {
+		std::size_t pos = 0;
+		const std::size_t n = reserve(dequeuePosition_, count, 1, pos);
+		Release release(*this, pos, pos + n);
+		for(; release.next != release.last; ++release.next, ++out) {
+			Cell &cell = cells_[release.next & mask_];
+			*out = std::move(*cell.get());
+			cell.get()->~ResultType();
+			cell.sequence.store(release.next + mask_ + 1, std::memory_order_release);
+		}
+		return n;
+	}
+// }}}
+
+private:	// inner types {{{
+	/// 取出しでの例外発生時に、確保した位置のうちnext以降の要素を破棄して空きに戻す.
+	struct Release {
+		Release(ResultQueue &queue, std::size_t first, std::size_t last) : queue(queue), next(first), last(last) {}
+		~Release() {
+			for(; next != last; ++next) {
+				Cell &cell = queue.cells_[next & queue.mask_];
+				cell.get()->~ResultType();
+				cell.sequence.store(next + queue.mask_ + 1, std::memory_order_release);
+			}
+		}
+
+		ResultQueue &queue;
+		std::size_t next;
+		const std::size_t last;
+	};
+// }}}
+
+private:	// inner functions {{{
+	/**
+	 * positionから最大count個の連続する位置を確保する.
+	 * 各位置の要素のsequenceが位置+readyであるものを先頭から数え、その数だけpositionを進める.
+	 * @param[in,out]	position	確保する位置. 追加ならばenqueuePosition_、取出しならばdequeuePosition_.
+	 * @param[in]	count	確保する最大の数.
+	 * @param[in]	ready	確保出来る要素のsequenceと位置の差. 追加ならば0(空き)、取出しならば1(格納済み).
+	 * @param[out]	first	確保した先頭の位置.
+	 * @return	確保した数. 空き(取出しならば格納済みの要素)が無ければ0.
+	 */
+	std::size_t reserve(detail::ResultQueuePosition &position, std::size_t count, std::size_t ready, std::size_t &first) {
+		if(count == 0) return 0;
+		if(count > mask_ + 1) count = mask_ + 1;
+		std::size_t pos = position.value.load(std::memory_order_relaxed);
+		for(;;) {
+			std::size_t n = 0;
+			bool stale = false;
+			for(; n < count; ++n) {
+				const std::size_t sequence = cells_[(pos + n) & mask_].sequence.load(std::memory_order_acquire);
+				const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence - (pos + n + ready));
+				if(diff == 0) continue;
+				// 負ならば満杯(取出しならば空)、正ならば他のスレッドが既にこの位置を確保している
+				stale = diff > 0;
+				break;
+			}
+			if(stale && n == 0) {
+				pos = position.value.load(std::memory_order_relaxed);
+				continue;
+			}
+			if(n == 0) return 0;
+			// 確保するまでの間に他のスレッドがposを確保しなければ、数えたn個の要素は別のスレッドに変更されない
+			if(position.value.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+				first = pos;
+				return n;
+			}
+		}
+	}
+
+	/// 確保した位置posへvalueをムーブし、取り出せるようにする.
+	void publish(std::size_t pos, ResultType &&value) {
+		Cell &cell = cells_[pos & mask_];
+		::new(static_cast<void *>(&cell.storage)) ResultType(std::move(value));
+		cell.sequence.store(pos + 1, std::memory_order_release);
+	}
+	/// 確保した位置posの要素をoutへムーブし、空きに戻す.
+	void consume(std::size_t pos, ResultType &out) {
+		Release release(*this, pos, pos + 1);
+		out = std::move(*cells_[pos & mask_].get());
+	}
+// }}}
+
+private:	// fields {{{
+	const std::size_t mask_;
+	const std::unique_ptr<Cell[]> cells_;
+	detail::ResultQueuePosition enqueuePosition_;
+	detail::ResultQueuePosition dequeuePosition_;
+// }}}
+};
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_RESULTQUEUE_HPP_
@@ -0,0 +1,295 @@
+﻿/**
+ * @file
+ */
+#ifndef ASLIB_INCLUDED_RESULTVECTOR_HPP_
+#define ASLIB_INCLUDED_RESULTVECTOR_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <aslib/Result.hpp>
+
+namespace aslib {
+
+namespace detail {
+
+/// @return	64ビット値の立っているビットの数.
+inline unsigned popcount64(std::uint64_t x) {
+#if defined(__GNUC__)
+	return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return static_cast<unsigned>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * ResultVectorの要素への参照を表すプロキシ.
+ * aslib::Resultと同じ名前のアクセサを持つ. 要素の種類(正常値かエラー値か)は変更出来ない.
+ * @param[in]	S	正常値の型. const修飾されていれば、値を変更出来ない.
+ * @param[in]	F	エラー値の型. const修飾されていれば、値を変更出来ない.
+ */
+template<typename S, typename F>
+class ResultVectorReference {
+	typedef Result<typename std::remove_const<S>::type, typename std::remove_const<F>::type> ValueType;
+
+public:	// public types {{{
+	typedef typename ValueType::CantDereference CantDereference;
+	typedef typename ValueType::NotHaveFailedObject NotHaveFailedObject;
+// }}}
+
+public:	// constructors {{{
+	/// @param[in]	succeeded	正常値への参照ならばtrue. その場合object はSを、それ以外はFを指す.
+	ResultVectorReference(bool succeeded, void *object) : succeeded_(succeeded), object_(object) {}
+// }}}
+
+public:	// functions / operators {{{
+	/// @return	正常値ならばtrue.
+	operator bool() const { return succeeded_; }
+	/// @return	要素のコピー.
+	operator ValueType() const { return succeeded_ ? ValueType(unchecked_value()) : ValueType(unchecked_fail()); }
+
+	/// @exception	aslib::Result::CantDereference	エラー値である場合に発生する.
+	S &operator*() const { if(!succeeded_) throw CantDereference(); return unchecked_value(); }
+	/// @sa	operator*
+	S *operator->() const { return &operator*(); }
+	/// @exception	aslib::Result::NotHaveFailedObject	正常値である場合に発生する.
+	F &fail() const { if(succeeded_) throw NotHaveFailedObject(); return unchecked_fail(); }
+
+	S *get_if() const { return succeeded_ ? static_cast<S *>(object_) : nullptr; }
+	F *fail_if() const { return succeeded_ ? nullptr : static_cast<F *>(object_); }
+	template<typename U>
+	typename std::remove_const<S>::type value_or(U &&defaultValue) const {
+		return succeeded_ ? unchecked_value() : static_cast<typename std::remove_const<S>::type>(std::forward<U>(defaultValue));
+	}
+	S &unchecked_value() const { assert(succeeded_); return *static_cast<S *>(object_); }
+	F &unchecked_fail() const { assert(!succeeded_); return *static_cast<F *>(object_); }
+// }}}
+
+private:	// fields {{{
+	bool succeeded_;
+	void *object_;
+// }}}
+};
+
+}	// namespace detail
+
+/**
+ * aslib::Resultの列を、値の種類ごとに分けて格納するコンテナ.
+ * std::vector<Result<S, F> >では要素ごとに大きい方の型のサイズと種別を持つが、このクラスは
+ * - 各要素の種別を1ビットで表すビット列
+ * - 正常値のみを詰めて格納した配列
+ * - エラー値のみを詰めて格納した配列
+ * に分けて保持する(struct of arrays). その為、正常値のみ・エラー値のみの走査は連続したメモリへのアクセスとなり、エラー値の数えあげはビット列のpopcountで済む.
+ * 要素の追加は末尾へのみ行える. 要素へのアクセスはoperator[]で、aslib::Resultと同じ名前のアクセサを持つプロキシを返す.
+ * 要素の位置から各配列内の位置への変換は、64要素毎に記録したエラー値の累計とpopcountで定数時間で行う.
+ * @param[in]	S	正常値の型.
+ * @param[in]	F	エラー値の型.
+ */
+template<typename S, typename F>
+class ResultVector {
+	typedef std::uint64_t Word;
+	static const std::size_t wordBits = 64;
+
+public:	// public types {{{
+	typedef S SucceededType;
+	typedef F FailedType;
+	typedef std::size_t size_type;
+	/// 要素への参照.
+	typedef detail::ResultVectorReference<SucceededType, FailedType> reference;
+	/// 要素へのconst参照.
+	typedef detail::ResultVectorReference<const SucceededType, const FailedType> const_reference;
+// }}}
+
+public:	// constructors {{{
+	ResultVector() : size_(0) {}
+// }}}
+
+public:	// functions {{{
+	/// @return	要素数.
+	size_type size() const { return size_; }
+	/// @return	要素を持たなければtrue.
+	bool empty() const { return size_ == 0; }
+
+	/// @return	エラー値の要素数.
+	size_type count_failed() const { return failures_.size(); }
+	/**
+	 * @param[in]	first	範囲の先頭の位置.
+	 * @param[in]	last	範囲の末尾の次の位置.
+	 * @return	[first, last)に含まれるエラー値の要素数.
+	 */
+	size_type count_failed(size_type first, size_type last) const {
+		assert(first <= last && last <= size_);
+		return failedBefore(last) - failedBefore(first);
+	}
+	/// @return	正常値の要素数.
+	size_type count_succeeded() const { return successes_.size(); }
+
+	/**
+	 * 全ての正常値に対し、格納順にfuncを呼び出す. 正常値は連続した領域に格納されている為、キャッシュ効率が良い.
+	 * @param[in]	func	正常値への参照を受け取る関数オブジェクト.
+	 */
+	template<typename Func>
+	void for_each_success(Func func) {
+		for(SucceededType *p = successes_.data(), *end = p + successes_.size(); p != end; ++p) func(*p);
+	}
+	/// @overload
+	template<typename Func>
+	void for_each_success(Func func) const {
+		for(const SucceededType *p = successes_.data(), *end = p + successes_.size(); p != end; ++p) func(*p);
+	}
+	/**
+	 * 全てのエラー値に対し、格納順にfuncを呼び出す.
+	 * @param[in]	func	エラー値への参照を受け取る関数オブジェクト.
+	 */
+	template<typename Func>
+	void for_each_failure(Func func) {
+		for(FailedType *p = failures_.data(), *end = p + failures_.size(); p != end; ++p) func(*p);
+	}
+	/// @overload
+	template<typename Func>
+	void for_each_failure(Func func) const {
+		for(const FailedType *p = failures_.data(), *end = p + failures_.size(); p != end; ++p) func(*p);
+	}
+
+	/// @return	正常値のみを格納順に詰めた配列.
+	const std::vector<SucceededType> &successes() const { return successes_; }
+	/// @return	エラー値のみを格納順に詰めた配列.
+	const std::vector<FailedType> &failures() const { return failures_; }
+
+	/// @return	index番目の要素が正常値ならばtrue.
+	bool succeeded(size_type index) const {
+		assert(index < size_);
+		return ((kinds_[index / wordBits] >> (index % wordBits)) & 1) == 0;
+	}
+
+	/// @return	index番目の要素への参照.
+	reference operator[](size_type index) {
+		return succeeded(index)
+			? reference(true, &successes_[index - failedBefore(index)])
+			: reference(false, &failures_[failedBefore(index)]);
+	}
+	/// @overload
+	const_reference operator[](size_type index) const {
+		return succeeded(index)
+			? const_reference(true, const_cast<SucceededType *>(&successes_[index - failedBefore(index)]))
+			: const_reference(false, const_cast<FailedType *>(&failures_[failedBefore(index)]));
+	}
+
+	/**
+	 * 末尾にResultを追加する.
+	 * @param[in]	src	追加する値. 正常値かエラー値を保持している事.
+	 */
+	void push_back(const Result<SucceededType, FailedType> &src) {
+		if(src) push_back_success(src.unchecked_value());
+		else push_back_failure(src.fail());
+	}
+	/// @overload
+	void push_back(Result<SucceededType, FailedType> &&src) {
+		if(src) push_back_success(std::move(src.unchecked_value()));
+		else push_back_failure(std::move(src.fail()));
+	}
+	/// 末尾に正常値を追加する.
+	void push_back_success(const SucceededType &src) { emplace_success(src); }
+	void push_back_success(SucceededType &&src) { emplace_success(std::move(src)); }
+	/// 末尾にエラー値を追加する.
+	void push_back_failure(const FailedType &src) { emplace_failure(src); }
+	void push_back_failure(FailedType &&src) { emplace_failure(std::move(src)); }
+
+	/**
+	 * 末尾に正常値を直接構築する.
+	 * @param[in]	args	SucceededTypeのコンストラクタへ渡す引数.
+	 * @return	構築した正常値への参照.
+	 */
+	template<typename... Args>
+	SucceededType &emplace_success(Args &&...args) {
+		successes_.emplace_back(std::forward<Args>(args)...);
+		try {
+			appendKind(false);
+		} catch(...) {
+			successes_.pop_back();
+			throw;
+		}
+		return successes_.back();
+	}
+	/**
+	 * 末尾にエラー値を直接構築する.
+	 * @param[in]	args	FailedTypeのコンストラクタへ渡す引数.
+	 * @return	構築したエラー値への参照.
+	 */
+	template<typename... Args>
+	FailedType &emplace_failure(Args &&...args) {
+		failures_.emplace_back(std::forward<Args>(args)...);
+		try {
+			appendKind(true);
+		} catch(...) {
+			failures_.pop_back();
+			throw;
+		}
+		return failures_.back();
+	}
+
+	/**
+	 * 領域を予約する.
+	 * @param[in]	n	予約する要素数.
+	 * @param[in]	expectedFailures	そのうちエラー値となる要素数の見込み.
+	 */
+	void reserve(size_type n, size_type expectedFailures = 0) {
+		kinds_.reserve((n + wordBits - 1) / wordBits);
+		ranks_.reserve((n + wordBits - 1) / wordBits);
+		successes_.reserve(n - (expectedFailures < n ? expectedFailures : n));
+		failures_.reserve(expectedFailures);
+	}
+
+	/// 全ての要素を破棄する.
+	void clear() {
+		kinds_.clear();
+		ranks_.clear();
+		successes_.clear();
+		failures_.clear();
+		size_ = 0;
+	}
+// }}}
+
+private:	// inner functions {{{
+	/// @return	index番目より前にあるエラー値の要素数.
+	size_type failedBefore(size_type index) const {
+		const size_type word = index / wordBits, bit = index % wordBits;
+		if(bit == 0) return (word < ranks_.size()) ? ranks_[word] : failures_.size();
+		return ranks_[word] + detail::popcount64(kinds_[word] & ((Word(1) << bit) - 1));
+	}
+
+	/**
+	 * ビット列に種別を追加する. 値は既に対応する配列へ追加済みである事.
+	 * @param[in]	isFailed	エラー値ならばtrue.
+	 */
+	void appendKind(bool isFailed) {
+		if(size_ % wordBits == 0) {
+			kinds_.reserve(kinds_.size() + 1);
+			ranks_.push_back(failures_.size() - (isFailed ? 1 : 0));
+			kinds_.push_back(0);
+		}
+		if(isFailed) kinds_.back() |= Word(1) << (size_ % wordBits);
+		++size_;
+	}
+// }}}
+
+private:	// fields {{{
+	/// 各要素の種別. エラー値のビットが立つ.
+	std::vector<Word> kinds_;
+	/// kinds_の各ワードより前にあるエラー値の要素数.
+	std::vector<size_type> ranks_;
+	std::vector<SucceededType> successes_;
+	std::vector<FailedType> failures_;
+	size_type size_;
+// }}}
+};
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_RESULTVECTOR_HPP_
@@ -0,0 +1,533 @@
+﻿/**
+ * @file
+ * DeepCopyPtrが保持するオブジェクトの木を、1つの連続したバッファへ書き出すスナップショット.
+ * バッファ内の参照は全て相対オフセットで表す為、ファイルへ書き出したものをmmap等でそのまま読み込み、復元せずに辿れる.
+ */
+#ifndef ASLIB_INCLUDED_SNAPSHOT_HPP_
+#define ASLIB_INCLUDED_SNAPSHOT_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <aslib/DeepCopyPtr.hpp>
+#include <aslib/Error.hpp>
+#include <aslib/Result.hpp>
+
+namespace aslib {
+
+class SnapshotWriter;
+
+/// スナップショット内の全ての値のアライメントの上限.
+static const std::size_t snapshotAlignment = 8;
+
+/**
+ * スナップショット内の値を指すポインタ. 自身のアドレスからの相対オフセットを保持する.
+ * 自明にコピー出来、バッファをどのアドレスへ読み込んでもそのまま辿れる. オフセット0はNULLを表す.
+ * @param[in]	T	指し示す値の型.
+ */
+template<typename T>
+class SnapshotOffset {
+public:
+	/// @return	指し示す値. NULLならばnullptr.
+	const T *get() const { return offset_ ? reinterpret_cast<const T *>(reinterpret_cast<const char *>(this) + offset_) : nullptr; }
+	const T *operator->() const { assert(offset_); return get(); }
+	const T &operator*() const { assert(offset_); return *get(); }
+	/// @return	NULLでなければtrue.
+	operator bool() const { return offset_ != 0; }
+
+private:
+	std::int64_t offset_;
+};
+
+/**
+ * スナップショット内の配列. 要素へのSnapshotOffsetと要素数を保持する.
+ * SnapshotWriter::writeStringで書き出した文字列は、size()の位置に終端文字を持つ.
+ * @param[in]	T	要素の型.
+ */
+template<typename T>
+class SnapshotArray {
+public:
+	typedef const T *const_iterator;
+
+	const T *data() const { return data_.get(); }
+	std::size_t size() const { return static_cast<std::size_t>(size_); }
+	bool empty() const { return size_ == 0; }
+	const T &operator[](std::size_t i) const { assert(i < size()); return data()[i]; }
+	const_iterator begin() const { return data(); }
+	const_iterator end() const { return data() + size(); }
+
+private:
+	SnapshotOffset<T> data_;
+	std::uint64_t size_;
+};
+/// 終端文字を持つ文字列.
+typedef SnapshotArray<char> SnapshotString;
+
+/**
+ * スナップショット内のオブジェクト. 型を表す値とサイズを持ち、直後にその型のイメージが続く.
+ * DeepCopyPtrを書き出すとこの形式になり、派生クラスのオブジェクトもas()で元の型のイメージとして読める.
+ */
+class SnapshotObject {
+public:
+	/// @return	イメージの型を表す値. Image::snapshotTypeと比較する.
+	std::uint32_t type() const { return type_; }
+	/// @return	イメージのバイト数.
+	std::uint32_t size() const { return size_; }
+
+	/**
+	 * @param[in]	Image	読み出すイメージの型.
+	 * @return	Image型のイメージであればそのアドレス、それ以外はnullptr.
+	 */
+	template<typename Image>
+	const Image *as() const {
+		if(type_ != Image::snapshotType) return nullptr;
+		return reinterpret_cast<const Image *>(this + 1);
+	}
+
+private:
+	friend class SnapshotWriter;
+
+	std::uint32_t type_;
+	std::uint32_t size_;
+};
+
+/**
+ * 型Typeのオブジェクトをスナップショットへ書き出す方法. 書き出す型毎に特殊化する.
+ * 特殊化には以下を定義する.
+ * - Image : 書き出す値の型. 自明にコピー出来、アライメントがsnapshotAlignment以下で、型を表す一意な値 static const std::uint32_t snapshotType を持つ事.
+ *   他のオブジェクトや配列は、SnapshotOffset、SnapshotArrayで参照する.
+ * - static void write(SnapshotWriter &writer, const Type &object, SnapshotSlot<Image> image) : objectの内容をimageへ書き込む.
+ * @code
+ *	struct NodeImage {
+ *		static const std::uint32_t snapshotType = 1;
+ *		std::int32_t value;
+ *		aslib::SnapshotOffset<aslib::SnapshotObject> child;
+ *	};
+ *	namespace aslib {
+ *	template<> struct SnapshotTraits<Node> {
+ *		typedef NodeImage Image;
+ *		static void write(SnapshotWriter &writer, const Node &node, SnapshotSlot<Image> image) {
+ *			image->value = node.value;
+ *			image.link(&Image::child, writer.write(node.child));	// 子のDeepCopyPtr
+ *		}
+ *	};
+ *	}
+ * @endcode
+ */
+template<typename Type>
+struct SnapshotTraits;
+
+/**
+ * 書き出し中のスナップショット内の値. バッファの再確保に備えて、オフセットで保持する.
+ * operator->やget()で得たポインタは、次にSnapshotWriterへ書き出すまでのみ有効.
+ * @param[in]	T	値の型.
+ */
+template<typename T>
+class SnapshotSlot {
+public:
+	/// NULLを表すSlot.
+	SnapshotSlot() : writer_(nullptr), offset_(0) {}
+	SnapshotSlot(SnapshotWriter &writer, std::size_t offset) : writer_(&writer), offset_(offset) {}
+
+	/// @return	バッファの先頭からのオフセット. NULLならば0.
+	std::size_t offset() const { return offset_; }
+	/// @return	NULLでなければtrue.
+	operator bool() const { return offset_ != 0; }
+
+	T *get() const;
+	T *operator->() const { return get(); }
+	T &operator*() const { return *get(); }
+	/// @return	このSlotを配列の先頭とした、i番目の要素.
+	SnapshotSlot at(std::size_t i) const { assert(offset_); return SnapshotSlot(*writer_, offset_ + i * sizeof(T)); }
+
+	/**
+	 * このSlotの値のメンバmemberが、targetを指すようにする.
+	 * @param[in]	member	T(またはその基底クラス)のSnapshotOffset型のメンバへのポインタ.
+	 * @param[in]	target	指し示す値. NULLならばmemberもNULLになる.
+	 */
+	template<typename U, typename Class>
+	void link(SnapshotOffset<U> Class::*member, SnapshotSlot<U> target) const;
+	/**
+	 * このSlotの値のメンバmemberが、targetの配列を指すようにする.
+	 * @param[in]	member	T(またはその基底クラス)のSnapshotArray型のメンバへのポインタ.
+	 * @param[in]	target	配列の先頭の要素.
+	 * @param[in]	size	配列の要素数.
+	 */
+	template<typename U, typename Class>
+	void link(SnapshotArray<U> Class::*member, SnapshotSlot<U> target, std::size_t size) const;
+
+private:
+	SnapshotWriter *writer_;
+	std::size_t offset_;
+};
+
+/// ファイルの先頭に置くヘッダ.
+struct SnapshotHeader {
+	/// "ASSN".
+	char magic[4];
+	/// 形式のバージョン.
+	std::uint32_t version;
+	/// 書き出したマシンのバイトオーダーでの0x01020304.
+	std::uint32_t byteOrder;
+	std::uint32_t reserved;
+	/// ヘッダを含む全体のバイト数.
+	std::uint64_t size;
+	/// 先頭からのルートの値のオフセット.
+	std::uint64_t root;
+};
+
+/// スナップショットを開けなかった理由を表すエラーコード. 分類はsnapshotErrorCategory().
+enum SnapshotErrorCode {
+	/// ヘッダより小さい、またはヘッダに記録されたサイズより小さい.
+	snapshotTruncated = 1,
+	/// 先頭がスナップショットのヘッダではない.
+	snapshotBadMagic,
+	/// 対応していない形式のバージョン.
+	snapshotUnsupportedVersion,
+	/// バイトオーダーの異なるマシンで書き出した.
+	snapshotByteOrderMismatch,
+	/// バッファがsnapshotAlignmentに揃っていない、またはルートが範囲外.
+	snapshotBadLayout
+};
+
+namespace detail {
+
+class SnapshotErrorCategory : public ErrorCategory {
+public:
+	const char *name() const { return "aslib.snapshot"; }
+	std::string message(int code) const {
+		switch(code) {
+		case snapshotTruncated: return "The snapshot is truncated.";
+		case snapshotBadMagic: return "Not a snapshot.";
+		case snapshotUnsupportedVersion: return "Unsupported snapshot version.";
+		case snapshotByteOrderMismatch: return "The snapshot was written with a different byte order.";
+		case snapshotBadLayout: return "The snapshot is misaligned or its root is out of range.";
+		default: return "Unknown snapshot error.";
+		}
+	}
+};
+
+static const char snapshotMagic[4] = { 'A', 'S', 'S', 'N' };
+static const std::uint32_t snapshotVersion = 1;
+static const std::uint32_t snapshotByteOrder = 0x01020304;
+
+/// Typeが多態型ならば動的な型で、それ以外は静的な型で書き出す.
+template<typename Type, bool = std::is_polymorphic<Type>::value /* == false */>
+struct SnapshotDispatch {
+	static SnapshotSlot<SnapshotObject> write(SnapshotWriter &writer, const Type &object);
+};
+template<typename Type>
+struct SnapshotDispatch<Type, true> {
+	static SnapshotSlot<SnapshotObject> write(SnapshotWriter &writer, const Type &object);
+};
+
+}	// namespace detail
+
+/// @return	SnapshotErrorCodeの分類.
+inline const ErrorCategory &snapshotErrorCategory() {
+	static const detail::SnapshotErrorCategory category;
+	return category;
+}
+
+/**
+ * DeepCopyPtrが保持するオブジェクトの木を、1つの連続したバッファへ書き出す.
+ * 各オブジェクトはSnapshotTraitsで定めたイメージとして書き出す. 多態型のDeepCopyPtrは、registerType()で登録した動的な型毎のSnapshotTraitsを用いる.
+ * @code
+ *	aslib::SnapshotWriter writer;
+ *	writer.registerType<Circle>();
+ *	writer.registerType<Group>();
+ *	std::vector<unsigned char> snapshot = writer.finish(writer.write(root));	// rootはDeepCopyPtr<Shape>
+ *	file.write(snapshot.data(), snapshot.size());
+ * @endcode
+ * 書き出した値はネイティブのバイトオーダー・レイアウトの為、同じイメージの定義を持つ、同じバイトオーダーのマシンでのみ読める.
+ * @sa	aslib::SnapshotView
+ */
+class SnapshotWriter {
+	template<typename> friend class SnapshotSlot;
+	template<typename, bool> friend struct detail::SnapshotDispatch;
+
+public:	// public types {{{
+	/// registerType()で登録していない多態型のオブジェクトを書き出した場合に発生する例外.
+	struct UnregisteredType : std::runtime_error {
+		UnregisteredType() : runtime_error("The dynamic type is not registered to SnapshotWriter.") {}
+	};
+// }}}
+
+public:	// constructors {{{
+	SnapshotWriter() { buffer_.resize(sizeof(SnapshotHeader)); }
+// }}}
+
+public:	// functions {{{
+	/// 書き出すバイト数の見込みに合わせて、バッファを予め確保する.
+	void reserve(std::size_t bytes) { buffer_.reserve(bytes); }
+
+	/**
+	 * 多態型のDeepCopyPtrを書き出す為に、動的な型Typeを登録する. SnapshotTraits<Type>を特殊化しておく事.
+	 * 同じ型を複数回登録しても良い.
+	 */
+	template<typename Type>
+	void registerType() {
+		for(std::size_t i = 0; i < types_.size(); ++i) {
+			if(*types_[i].first == typeid(Type)) return;
+		}
+		types_.push_back(std::make_pair(&typeid(Type), &writeObject<Type>));
+	}
+
+	/**
+	 * 0で初期化したT型の値を確保する.
+	 * @param[in]	T	自明にコピー出来、アライメントがsnapshotAlignment以下の型.
+	 */
+	template<typename T>
+	SnapshotSlot<T> allocate() {
+		static_assert(std::is_trivially_copyable<T>::value, "Snapshot values must be trivially copyable.");
+		static_assert(std::alignment_of<T>::value <= snapshotAlignment, "Snapshot values must not be over-aligned.");
+		return SnapshotSlot<T>(*this, allocateBytes(sizeof(T)));
+	}
+	/**
+	 * 0で初期化したT型の配列を確保する.
+	 * @param[in]	size	要素数.
+	 * @return	先頭の要素. sizeが0ならばNULL.
+	 */
+	template<typename T>
+	SnapshotSlot<T> allocateArray(std::size_t size) {
+		static_assert(std::is_trivially_copyable<T>::value, "Snapshot values must be trivially copyable.");
+		static_assert(std::alignment_of<T>::value <= snapshotAlignment, "Snapshot values must not be over-aligned.");
+		if(size == 0) return SnapshotSlot<T>();
+		return SnapshotSlot<T>(*this, allocateBytes(sizeof(T) * size));
+	}
+	/**
+	 * 配列をコピーして書き出す.
+	 * @return	先頭の要素. sizeが0ならばNULL.
+	 */
+	template<typename T>
+	SnapshotSlot<T> writeArray(const T *data, std::size_t size) {
+		SnapshotSlot<T> slot = allocateArray<T>(size);
+		if(size) std::memcpy(slot.get(), data, sizeof(T) * size);
+		return slot;
+	}
+	/**
+	 * 終端文字を付けて文字列を書き出す. SnapshotSlot::linkには、終端文字を除いたsizeを渡す.
+	 * @return	先頭の文字.
+	 */
+	SnapshotSlot<char> writeString(const char *data, std::size_t size) {
+		SnapshotSlot<char> slot = allocateArray<char>(size + 1);
+		std::memcpy(slot.get(), data, size);
+		return slot;
+	}
+	/// @overload
+	SnapshotSlot<char> writeString(const std::string &s) { return writeString(s.data(), s.size()); }
+
+	/**
+	 * objectをSnapshotObjectとして書き出す. 多態型であれば、registerType()で登録した動的な型のSnapshotTraitsを用いる.
+	 * @exception	UnregisteredType	多態型で、動的な型が登録されていない場合.
+	 */
+	template<typename Type>
+	SnapshotSlot<SnapshotObject> write(const Type &object) { return detail::SnapshotDispatch<Type>::write(*this, object); }
+	/**
+	 * DeepCopyPtrが保持するオブジェクトを書き出す.
+	 * @return	書き出したオブジェクト. ptrがNULLならばNULL.
+	 */
+	template<typename Type, std::size_t InlineBytes>
+	SnapshotSlot<SnapshotObject> write(const DeepCopyPtr<Type, InlineBytes> &ptr) {
+		if(!ptr) return SnapshotSlot<SnapshotObject>();
+		return write(*ptr);
+	}
+
+	/**
+	 * offsetの値が、targetを指すようにする. SnapshotOffsetの配列の要素に用いる.
+	 * @param[in]	target	指し示す値. NULLならばoffsetもNULLになる.
+	 */
+	template<typename U>
+	void link(SnapshotSlot<SnapshotOffset<U> > offset, SnapshotSlot<U> target) { setOffset(offset.offset(), target.offset()); }
+
+	/**
+	 * ヘッダを書き込み、完成したスナップショットを返す. 呼出後のSnapshotWriterは空になり、再び書き出しに使える.
+	 * @param[in]	root	SnapshotView::rootで得る値. 通常はwrite()の戻り値.
+	 */
+	template<typename T>
+	std::vector<unsigned char> finish(SnapshotSlot<T> root) {
+		SnapshotHeader header;
+		std::memcpy(header.magic, detail::snapshotMagic, sizeof(header.magic));
+		header.version = detail::snapshotVersion;
+		header.byteOrder = detail::snapshotByteOrder;
+		header.reserved = 0;
+		header.size = buffer_.size();
+		header.root = root.offset();
+		std::memcpy(buffer_.data(), &header, sizeof(header));
+
+		std::vector<unsigned char> result;
+		result.swap(buffer_);
+		buffer_.resize(sizeof(SnapshotHeader));
+		return result;
+	}
+// }}}
+
+private:	// inner functions {{{
+	typedef SnapshotSlot<SnapshotObject> (*WriteFunction)(SnapshotWriter &, const void *);
+
+	/// @return	0で初期化した、snapshotAlignmentに揃えたsizeバイトの領域のオフセット.
+	std::size_t allocateBytes(std::size_t size) {
+		const std::size_t offset = (buffer_.size() + snapshotAlignment - 1) & ~(snapshotAlignment - 1);
+		buffer_.resize(offset + size);
+		return offset;
+	}
+
+	/// SnapshotObjectのヘッダとType型のイメージを確保し、SnapshotTraits<Type>で書き込む.
+	template<typename Type>
+	static SnapshotSlot<SnapshotObject> writeObject(SnapshotWriter &writer, const void *object) {
+		typedef SnapshotTraits<Type> Traits;
+		typedef typename Traits::Image Image;
+		static_assert(std::is_trivially_copyable<Image>::value, "Snapshot images must be trivially copyable.");
+		static_assert(std::alignment_of<Image>::value <= snapshotAlignment, "Snapshot images must not be over-aligned.");
+		static_assert(sizeof(SnapshotObject) == snapshotAlignment, "The image must immediately follow SnapshotObject.");
+
+		const SnapshotSlot<SnapshotObject> header(writer, writer.allocateBytes(sizeof(SnapshotObject) + sizeof(Image)));
+		header->type_ = Image::snapshotType;
+		header->size_ = static_cast<std::uint32_t>(sizeof(Image));
+		Traits::write(writer, *static_cast<const Type *>(object), SnapshotSlot<Image>(writer, header.offset() + sizeof(SnapshotObject)));
+		return header;
+	}
+
+	/// @return	動的な型typeの書き出し関数.
+	WriteFunction find(const std::type_info &type) const {
+		for(std::size_t i = 0; i < types_.size(); ++i) {
+			if(*types_[i].first == type) return types_[i].second;
+		}
+		throw UnregisteredType();
+	}
+
+	/// offsetの位置のSnapshotOffsetに、targetへの相対オフセットを書き込む.
+	void setOffset(std::size_t offset, std::size_t target) {
+		const std::int64_t relative = target ? static_cast<std::int64_t>(target) - static_cast<std::int64_t>(offset) : 0;
+		std::memcpy(&buffer_[offset], &relative, sizeof(relative));
+	}
+// }}}
+
+private:	// fields {{{
+	std::vector<unsigned char> buffer_;
+	std::vector<std::pair<const std::type_info *, WriteFunction> > types_;
+// }}}
+};
+
+template<typename T>
+T *SnapshotSlot<T>::get() const {
+	return offset_ ? reinterpret_cast<T *>(&writer_->buffer_[offset_]) : nullptr;
+}
+
+template<typename T>
+template<typename U, typename Class>
+void SnapshotSlot<T>::link(SnapshotOffset<U> Class::*member, SnapshotSlot<U> target) const {
+	const std::size_t field = reinterpret_cast<const unsigned char *>(&(get()->*member)) - &writer_->buffer_[0];
+	writer_->setOffset(field, target.offset());
+}
+
+template<typename T>
+template<typename U, typename Class>
+void SnapshotSlot<T>::link(SnapshotArray<U> Class::*member, SnapshotSlot<U> target, std::size_t size) const {
+	// SnapshotArrayは先頭の要素へのSnapshotOffsetと、要素数の順に並ぶ
+	const std::size_t field = reinterpret_cast<const unsigned char *>(&(get()->*member)) - &writer_->buffer_[0];
+	writer_->setOffset(field, target.offset());
+	const std::uint64_t count = target ? size : 0;
+	std::memcpy(&writer_->buffer_[field + sizeof(SnapshotOffset<U>)], &count, sizeof(count));
+}
+
+namespace detail {
+
+template<typename Type, bool isPolymorphic>
+SnapshotSlot<SnapshotObject> SnapshotDispatch<Type, isPolymorphic>::write(SnapshotWriter &writer, const Type &object) {
+	return SnapshotWriter::writeObject<Type>(writer, &object);
+}
+
+template<typename Type>
+SnapshotSlot<SnapshotObject> SnapshotDispatch<Type, true>::write(SnapshotWriter &writer, const Type &object) {
+	// 登録した関数は最派生クラスのオブジェクトを受け取る
+	return writer.find(typeid(object))(writer, dynamic_cast<const void *>(&object));
+}
+
+}	// namespace detail
+
+/**
+ * SnapshotWriterで書き出したスナップショットを、復元せずに読む為のビュー.
+ * バッファはコピーせずに参照する為、mmapしたファイルをそのまま扱える. バッファはビューより長く生存させる事.
+ * @code
+ *	void *mapped = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+ *	aslib::Result<aslib::SnapshotView, aslib::Error> view = aslib::SnapshotView::open(mapped, size);
+ *	if(!view) return view.fail();
+ *	const aslib::SnapshotObject &root = view->root<aslib::SnapshotObject>();
+ *	if(const GroupImage *group = root.as<GroupImage>()) { ... }
+ * @endcode
+ * open()ではヘッダのみを検証し、値の中のオフセットは検証しない. 信頼出来ないファイルを読む用途には用いない事.
+ */
+class SnapshotView {
+public:	// constructors {{{
+	/// 空のビュー.
+	SnapshotView() : data_(nullptr), size_(0) {}
+// }}}
+
+public:	// functions {{{
+	/**
+	 * dataから始まるsizeバイトのスナップショットを開く.
+	 * @param[in]	data	スナップショットの先頭. snapshotAlignmentに揃っている事.
+	 * @param[in]	size	バイト数.
+	 * @return	ビュー. ヘッダが不正であれば、snapshotErrorCategory()のエラー.
+	 */
+	static Result<SnapshotView, Error> open(const void *data, std::size_t size) {
+		if(size < sizeof(SnapshotHeader)) return Error(snapshotTruncated, snapshotErrorCategory());
+		if(reinterpret_cast<std::uintptr_t>(data) % snapshotAlignment != 0) return Error(snapshotBadLayout, snapshotErrorCategory());
+
+		const SnapshotHeader &header = *static_cast<const SnapshotHeader *>(data);
+		if(std::memcmp(header.magic, detail::snapshotMagic, sizeof(header.magic)) != 0) return Error(snapshotBadMagic, snapshotErrorCategory());
+		if(header.version != detail::snapshotVersion) return Error(snapshotUnsupportedVersion, snapshotErrorCategory());
+		if(header.byteOrder != detail::snapshotByteOrder) return Error(snapshotByteOrderMismatch, snapshotErrorCategory());
+		if(header.size > size) return Error(snapshotTruncated, snapshotErrorCategory());
+		if(header.root < sizeof(SnapshotHeader) || header.root >= header.size || header.root % snapshotAlignment != 0) return Error(snapshotBadLayout, snapshotErrorCategory());
+
+		SnapshotView view;
+		view.data_ = static_cast<const unsigned char *>(data);
+		view.size_ = static_cast<std::size_t>(header.size);
+		return view;
+	}
+
+	/// @return	ヘッダを含むスナップショットのバイト数.
+	std::size_t size() const { return size_; }
+	/// @return	スナップショットの先頭.
+	const void *data() const { return data_; }
+
+	/**
+	 * @param[in]	T	SnapshotWriter::finishに渡した値の型. 通常はSnapshotObject.
+	 * @return	ルートの値.
+	 */
+	template<typename T>
+	const T &root() const {
+		assert(data_);
+		return *reinterpret_cast<const T *>(data_ + header().root);
+	}
+
+	/// @return	pからのbytesバイトがスナップショットの範囲内ならばtrue.
+	bool contains(const void *p, std::size_t bytes) const {
+		const unsigned char *begin = static_cast<const unsigned char *>(p);
+		return data_ <= begin && begin <= data_ + size_ && bytes <= static_cast<std::size_t>(data_ + size_ - begin);
+	}
+// }}}
+
+private:	// inner functions {{{
+	const SnapshotHeader &header() const { return *reinterpret_cast<const SnapshotHeader *>(data_); }
+// }}}
+
+private:	// fields {{{
+	const unsigned char *data_;
+	std::size_t size_;
+// }}}
+};
+
+}	// namespace aslib
+
+#endif	// ASLIB_INCLUDED_SNAPSHOT_HPP_
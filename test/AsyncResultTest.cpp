@@ -0,0 +1,149 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <aslib/AsyncResult.hpp>
+
+using aslib::AsyncResult;
+using aslib::Result;
+
+namespace {
+	enum ErrorCode { noError, someError };
+
+	typedef AsyncResult<int, ErrorCode> AsyncInt;
+	typedef Result<int, ErrorCode> IntR;
+
+	// 生存期間中のオブジェクトの数を数える
+	struct Tracked {
+		Tracked(int *alive) : alive_(alive) { ++*alive_; }
+		Tracked(const Tracked &src) : alive_(src.alive_) { ++*alive_; }
+		~Tracked() { --*alive_; }
+		int *alive_;
+	};
+}
+
+BOOST_AUTO_TEST_SUITE(AsyncResultTest)
+
+BOOST_AUTO_TEST_CASE(testSetThenContinue) {
+	// 結果の格納が先ならば、then()の中で呼び出す
+	AsyncInt a;
+	BOOST_CHECK(!a.ready());
+	a.set(1);
+	BOOST_CHECK(a.ready());
+	int received = 0;
+	a.then([&](IntR &&r) { received = *r; });
+	BOOST_CHECK_EQUAL(received, 1);
+}
+
+BOOST_AUTO_TEST_CASE(testContinueThenSet) {
+	// 継続の登録が先ならば、set()の中で呼び出す
+	AsyncInt a;
+	ErrorCode received = noError;
+	a.then([&](IntR &&r) { received = r.fail(); });
+	BOOST_CHECK_EQUAL(received, noError);
+	a.set(someError);
+	BOOST_CHECK_EQUAL(received, someError);
+}
+
+BOOST_AUTO_TEST_CASE(testGetAndWait) {
+	AsyncResult<std::string, ErrorCode> a;
+	std::thread producer([&]() { a.set(std::string("value")); });
+	a.wait();
+	BOOST_CHECK_EQUAL(*a.get(), "value");
+	producer.join();
+
+	a.reset();
+	BOOST_CHECK(!a.ready());
+	a.set(someError);
+	BOOST_CHECK_EQUAL(a.get().fail(), someError);
+}
+
+BOOST_AUTO_TEST_CASE(testPipeline) {
+	// 次の段のAsyncResultへ、コンビネータで変換した結果を渡す
+	AsyncInt read;
+	AsyncResult<std::string, ErrorCode> decoded;
+	read.then(decoded, [](IntR &&r) { return std::move(r).map([](int v) { return std::string(static_cast<std::size_t>(v), 'x'); }); });
+	std::string received;
+	decoded.then([&](Result<std::string, ErrorCode> &&r) { received = *r; });
+
+	read.set(3);
+	BOOST_CHECK_EQUAL(received, "xxx");
+
+	AsyncInt failedRead;
+	AsyncResult<std::string, ErrorCode> failedDecoded;
+	failedRead.then(failedDecoded, [](IntR &&r) { return std::move(r).map([](int v) { return std::string(static_cast<std::size_t>(v), 'x'); }); });
+	failedRead.set(someError);
+	BOOST_CHECK_EQUAL(failedDecoded.get().fail(), someError);
+}
+
+BOOST_AUTO_TEST_CASE(testVoid) {
+	AsyncResult<void, ErrorCode> a;
+	bool succeeded = false;
+	a.then([&](Result<void, ErrorCode> &&r) { succeeded = static_cast<bool>(r); });
+	a.set(Result<void, ErrorCode>(aslib::in_place_success));
+	BOOST_CHECK(succeeded);
+}
+
+BOOST_AUTO_TEST_CASE(testContinuationLifetime) {
+	int alive = 0;
+	{
+		// 呼び出されなかった継続は、AsyncResultと共に破棄する
+		AsyncInt a;
+		Tracked t(&alive);
+		a.then([t](IntR &&) {});
+		BOOST_CHECK_EQUAL(alive, 2);
+	}
+	BOOST_CHECK_EQUAL(alive, 0);
+	{
+		// 呼び出した継続は、呼出の後に破棄する
+		AsyncInt a;
+		Tracked t(&alive);
+		a.then([t](IntR &&) {});
+		a.set(1);
+		BOOST_CHECK_EQUAL(alive, 1);
+	}
+	BOOST_CHECK_EQUAL(alive, 0);
+
+	// 継続の中でAsyncResultを破棄出来る
+	std::unique_ptr<AsyncInt> owned(new AsyncInt());
+	int received = 0;
+	owned->then([&](IntR &&r) { received = *r; owned.reset(); });
+	owned->set(2);
+	BOOST_CHECK_EQUAL(received, 2);
+	BOOST_CHECK(!owned);
+}
+
+BOOST_AUTO_TEST_CASE(testConcurrentHandoff) {
+	// 継続の登録と結果の格納を別スレッドで同時に行っても、継続は1度だけ呼ばれる
+	static const int count = 2000;
+	std::vector<AsyncInt> results(count);
+	std::atomic<int> calls(0), sum(0);
+	std::thread producer([&]() {
+		for(int i = 0; i < count; ++i) results[i].set(i);
+	});
+	for(int i = 0; i < count; ++i) {
+		results[i].then([&](IntR &&r) { sum.fetch_add(*r); calls.fetch_add(1); });
+	}
+	producer.join();
+	BOOST_CHECK_EQUAL(calls.load(), count);
+	BOOST_CHECK_EQUAL(sum.load(), count * (count - 1) / 2);
+}
+
+BOOST_AUTO_TEST_CASE(testWaitThenDestroy) {
+	// wait()から戻った直後に破棄しても、完了させたスレッドはもう触れない
+	for(int i = 0; i < 200; ++i) {
+		std::unique_ptr<AsyncInt> a(new AsyncInt);
+		AsyncInt *target = a.get();
+		std::thread producer([target, i]() { target->set(i); });
+		a->wait();
+		BOOST_CHECK_EQUAL(*a->get(), i);
+		a.reset();
+		producer.join();
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
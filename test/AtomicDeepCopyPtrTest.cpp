@@ -0,0 +1,148 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <aslib/AtomicDeepCopyPtr.hpp>
+
+using aslib::AtomicDeepCopyPtr;
+using aslib::DeepCopyPtr;
+
+namespace {
+	/// 破棄された事を記録する.
+	struct Tracked {
+		Tracked(int v, bool *destroyed) : value(v), destroyed_(destroyed) {}
+		~Tracked() { if(destroyed_) *destroyed_ = true; }
+		int value;
+		bool *destroyed_;
+	};
+
+	/// 一貫性を確認する為の、2つの値を持つ設定.
+	struct Config {
+		explicit Config(long v) : a(v), b(v * 2) {}
+		long a, b;
+	};
+}
+
+BOOST_AUTO_TEST_SUITE(AtomicDeepCopyPtrTest)
+	BOOST_AUTO_TEST_CASE(testDefault) {
+		AtomicDeepCopyPtr<int> p;
+		BOOST_CHECK(!p.is_lock_free());
+		AtomicDeepCopyPtr<int>::Snapshot s = p.load();
+		BOOST_CHECK(!s);
+		BOOST_CHECK(s.get() == nullptr);
+		BOOST_CHECK(!p.copy());
+	}
+
+	BOOST_AUTO_TEST_CASE(testStoreLoad) {
+		DeepCopyPtr<int> original(new int(1));
+		AtomicDeepCopyPtr<int> p(original);
+		BOOST_CHECK_EQUAL(*p.load(), 1);
+		BOOST_CHECK_NE(p.load().get(), original.get());	// 深いコピーを保持する
+
+		p.store(DeepCopyPtr<int>(new int(2)));
+		BOOST_CHECK_EQUAL(*p.load(), 2);
+
+		p.store(original);
+		BOOST_CHECK_EQUAL(*p.copy(), 1);
+
+		p.store(DeepCopyPtr<int>());
+		BOOST_CHECK(!p.load());
+	}
+
+	BOOST_AUTO_TEST_CASE(testExchange) {
+		AtomicDeepCopyPtr<int> p(DeepCopyPtr<int>(new int(1)));
+		const int *published = p.load().get();
+		DeepCopyPtr<int> old = p.exchange(DeepCopyPtr<int>(new int(2)));
+		BOOST_CHECK_EQUAL(*old, 1);
+		BOOST_CHECK_EQUAL(old.get(), published);	// コピーせずに所有権を返す
+		BOOST_CHECK_EQUAL(*p.load(), 2);
+		BOOST_CHECK_EQUAL(*p.exchange(DeepCopyPtr<int>()), 2);
+		BOOST_CHECK(!p.exchange(DeepCopyPtr<int>(new int(3))));
+	}
+
+	BOOST_AUTO_TEST_CASE(testExchangeWaitsForSnapshot) {
+		AtomicDeepCopyPtr<int> p(DeepCopyPtr<int>(new int(1)));
+		std::atomic<bool> loaded(false), released(false);
+		std::atomic<int> seen(0);
+		std::thread reader([&] {
+			AtomicDeepCopyPtr<int>::Snapshot s = p.load();
+			loaded = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			seen = *s;
+			released = true;
+		});
+		while(!loaded) std::this_thread::yield();
+		// 読み出し中のSnapshotが破棄されるまで、差し替え前のオブジェクトを返さない
+		DeepCopyPtr<int> old = p.exchange(DeepCopyPtr<int>(new int(2)));
+		BOOST_CHECK(released.load());
+		BOOST_CHECK_EQUAL(*old, 1);
+		reader.join();
+		BOOST_CHECK_EQUAL(seen.load(), 1);
+	}
+
+	BOOST_AUTO_TEST_CASE(testHazardRecordLayout) {
+		// 記録はそれぞれ1つのキャッシュラインを占める
+		aslib::detail::HazardRecord *r = aslib::detail::HazardRecord::create();
+		BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(r) % aslib::detail::hazardCacheLine, 0u);
+		aslib::detail::HazardRecord::destroy(r);
+	}
+
+	BOOST_AUTO_TEST_CASE(testSnapshotKeepsObject) {
+		bool destroyed = false;
+		AtomicDeepCopyPtr<Tracked> p(DeepCopyPtr<Tracked>(new Tracked(1, &destroyed)));
+		{
+			AtomicDeepCopyPtr<Tracked>::Snapshot s = p.load();
+			p.store(DeepCopyPtr<Tracked>(new Tracked(2, nullptr)));
+			// 解放を促しても、Snapshotが指している間は解放されない
+			for(std::size_t i = 0; i < 2 * aslib::detail::HazardDomain::scanThreshold; ++i) p.store(DeepCopyPtr<Tracked>(new Tracked(3, nullptr)));
+			BOOST_CHECK(!destroyed);
+			BOOST_CHECK_EQUAL(s->value, 1);
+			BOOST_CHECK_EQUAL(p.load()->value, 3);
+		}
+		for(std::size_t i = 0; i < 2 * aslib::detail::HazardDomain::scanThreshold; ++i) p.store(DeepCopyPtr<Tracked>(new Tracked(4, nullptr)));
+		BOOST_CHECK(destroyed);
+	}
+
+	BOOST_AUTO_TEST_CASE(testSnapshotMove) {
+		AtomicDeepCopyPtr<int> p(DeepCopyPtr<int>(new int(1)));
+		AtomicDeepCopyPtr<int>::Snapshot s = p.load();
+		AtomicDeepCopyPtr<int>::Snapshot moved(std::move(s));
+		BOOST_CHECK(!s);
+		BOOST_CHECK_EQUAL(*moved, 1);
+
+		p.store(DeepCopyPtr<int>(new int(2)));
+		moved = p.load();
+		BOOST_CHECK_EQUAL(*moved, 2);
+	}
+
+	BOOST_AUTO_TEST_CASE(testConcurrentReaders) {
+		const long writes = 20000;
+		AtomicDeepCopyPtr<Config> config(DeepCopyPtr<Config>(new Config(0)));
+		std::atomic<bool> done(false);
+		std::atomic<long> inconsistent(0), reads(0);
+
+		std::vector<std::thread> readers;
+		for(int i = 0; i < 4; ++i) {
+			readers.push_back(std::thread([&]() {
+				long last = 0;
+				do {	// 書き込みが先に終わっても、各スレッドが少なくとも1回は読む
+					AtomicDeepCopyPtr<Config>::Snapshot s = config.load();
+					if(s->b != s->a * 2 || s->a < last) inconsistent.fetch_add(1);
+					last = s->a;
+					reads.fetch_add(1, std::memory_order_relaxed);
+				} while(!done.load(std::memory_order_acquire));
+			}));
+		}
+		for(long i = 1; i <= writes; ++i) config.store(DeepCopyPtr<Config>(new Config(i)));
+		done.store(true, std::memory_order_release);
+		for(std::size_t i = 0; i < readers.size(); ++i) readers[i].join();
+
+		BOOST_CHECK_EQUAL(inconsistent.load(), 0);
+		BOOST_CHECK_GT(reads.load(), 0);
+		BOOST_CHECK_EQUAL(config.load()->a, writes);
+	}
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,161 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <aslib/CowPtr.hpp>
+
+using aslib::CowPtr;
+using aslib::DeepCopyPtr;
+
+namespace {
+	// テストで使用するユーザー定義クラス群
+
+	// コピーされた回数を記録するクラス
+	struct Counted {
+		Counted(int *copies, int i = 0) : copies_(copies), i_(i) {}
+		Counted(const Counted &src) : copies_(src.copies_), i_(src.i_) { ++*copies_; }
+		virtual ~Counted() {}
+		int *copies_;
+		int i_;
+	};
+	struct DerivedCounted : Counted {
+		DerivedCounted(int *copies, int i) : Counted(copies, i) {}
+	};
+}
+
+BOOST_AUTO_TEST_SUITE(CowPtrTest)
+
+BOOST_AUTO_TEST_CASE(testConstructor) {
+	CowPtr<int> p;
+	BOOST_CHECK(!p);
+	BOOST_CHECK_EQUAL(p.use_count(), 0);
+
+	int copies = 0;
+	Counted *c = new Counted(&copies);
+	CowPtr<Counted> cp(c);
+	BOOST_CHECK_EQUAL(static_cast<const CowPtr<Counted> &>(cp).get(), c);
+	BOOST_CHECK_EQUAL(cp.use_count(), 1);
+
+	CowPtr<int> p0(static_cast<int *>(0));
+	BOOST_CHECK(!p0);
+
+	// DeepCopyPtrから
+	DeepCopyPtr<Counted> dp(new Counted(&copies, 1));
+	CowPtr<Counted> fromCopy(dp);
+	BOOST_CHECK_EQUAL(copies, 1);
+	BOOST_CHECK(dp);
+	CowPtr<Counted> fromMove(std::move(dp));
+	BOOST_CHECK_EQUAL(copies, 1);
+	BOOST_CHECK(!dp);
+	BOOST_CHECK_EQUAL(fromMove->i_, 1);
+}
+
+BOOST_AUTO_TEST_CASE(testCopyShares) {
+	int copies = 0;
+	CowPtr<Counted> src(new Counted(&copies, 1));
+	const CowPtr<Counted> dst1(src), dst2 = src;
+
+	// 読み出しのみではコピーされない
+	BOOST_CHECK_EQUAL(copies, 0);
+	BOOST_CHECK_EQUAL(src.use_count(), 3);
+	BOOST_CHECK_EQUAL(dst1.get(), dst2.get());
+	BOOST_CHECK_EQUAL(dst1->i_, 1);
+	BOOST_CHECK_EQUAL((*dst2).i_, 1);
+	BOOST_CHECK_EQUAL(copies, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testCopyOnWrite) {
+	int copies = 0;
+	CowPtr<Counted> src(new Counted(&copies, 1));
+	CowPtr<Counted> dst(src);
+	const Counted *shared = static_cast<const CowPtr<Counted> &>(src).get();
+
+	// 最初の非constアクセスでコピーされる
+	dst->i_ = 2;
+	BOOST_CHECK_EQUAL(copies, 1);
+	BOOST_CHECK_NE(static_cast<const CowPtr<Counted> &>(dst).get(), shared);
+	BOOST_CHECK_EQUAL(src.use_count(), 1);
+	BOOST_CHECK_EQUAL(dst.use_count(), 1);
+	BOOST_CHECK_EQUAL(static_cast<const CowPtr<Counted> &>(src)->i_, 1);
+
+	// 共有していなければ、それ以上コピーされない
+	(*dst).i_ = 3;
+	src->i_ = 4;
+	BOOST_CHECK_EQUAL(copies, 1);
+	BOOST_CHECK_EQUAL(static_cast<const CowPtr<Counted> &>(src).get(), shared);
+}
+
+BOOST_AUTO_TEST_CASE(testCopyOnWrite_keepDynamicType) {
+	int copies = 0;
+	CowPtr<Counted> src(new DerivedCounted(&copies, 1));
+	CowPtr<Counted> dst(src);
+	dst.get();
+	BOOST_CHECK_EQUAL(copies, 1);
+	BOOST_CHECK(typeid(*dst) == typeid(DerivedCounted));
+}
+
+BOOST_AUTO_TEST_CASE(testMove) {
+	int copies = 0;
+	CowPtr<Counted> src(new Counted(&copies));
+	CowPtr<Counted> dst(std::move(src));
+	BOOST_CHECK(!src);
+	BOOST_CHECK(dst);
+	BOOST_CHECK_EQUAL(dst.use_count(), 1);
+
+	CowPtr<Counted> other;
+	other = std::move(dst);
+	BOOST_CHECK(!dst);
+	BOOST_CHECK_EQUAL(other.use_count(), 1);
+	BOOST_CHECK_EQUAL(copies, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testOpequal) {
+	int copies = 0;
+	CowPtr<Counted> p1(new Counted(&copies, 1)), p2(new Counted(&copies, 2));
+	p1 = p2;
+	BOOST_CHECK(p1 == p2);
+	BOOST_CHECK_EQUAL(p1.use_count(), 2);
+	BOOST_CHECK_EQUAL(copies, 0);
+
+	const Counted c(&copies, 3);
+	p1 = &c;
+	BOOST_CHECK(p1 != p2);
+	BOOST_CHECK_EQUAL(copies, 1);
+	BOOST_CHECK_EQUAL(p2.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(testReset) {
+	int copies = 0;
+	CowPtr<Counted> p1(new Counted(&copies)), p2(p1);
+	p1.reset();
+	BOOST_CHECK(!p1);
+	BOOST_CHECK_EQUAL(p2.use_count(), 1);
+
+	p1.reset(new DerivedCounted(&copies, 1));
+	BOOST_CHECK(typeid(*p1) == typeid(DerivedCounted));
+}
+
+BOOST_AUTO_TEST_CASE(testThreads) {
+	// 別スレッドでのコピー・破棄が参照カウントを壊さない
+	int copies = 0;
+	CowPtr<Counted> src(new Counted(&copies, 1));
+	// Boost.Testの検査はスレッドセーフではない為、不一致の数を数えて後で検査する
+	std::atomic<int> mismatches(0);
+	std::vector<std::thread> threads;
+	for(int i = 0; i < 4; ++i) {
+		threads.push_back(std::thread([&src, &mismatches]() {
+			for(int j = 0; j < 1000; ++j) {
+				const CowPtr<Counted> copy(src);
+				if(copy->i_ != 1) ++mismatches;
+			}
+		}));
+	}
+	for(std::size_t i = 0; i < threads.size(); ++i) threads[i].join();
+	BOOST_CHECK_EQUAL(mismatches.load(), 0);
+	BOOST_CHECK_EQUAL(src.use_count(), 1);
+	BOOST_CHECK_EQUAL(copies, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
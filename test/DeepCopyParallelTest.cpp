@@ -0,0 +1,329 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <aslib/AtomicDeepCopyPtr.hpp>
+#include <aslib/CowPtr.hpp>
+#include <aslib/DeepCopyParallel.hpp>
+
+using aslib::DeepCopyPtr;
+
+namespace {
+	// コピーする木の節. 子はメンバと標準コンテナの要素に持ち、そのコピーを後回しにさせる
+	struct Node {
+		Node(int value) : value_(value) {}
+		Node(const Node &src) : value_(src.value_), first_(aslib::deferred_copy, src.first_) {
+			children_.reserve(src.children_.size());
+			for(std::size_t i = 0; i < src.children_.size(); ++i) children_.emplace_back(aslib::deferred_copy, src.children_[i]);
+		}
+		// DeepCopyPtr<Node, 64>の内部に格納出来るようにする
+		Node(Node &&) noexcept = default;
+		virtual ~Node() {}
+		virtual int kind() const { return 0; }
+
+		int value_;
+		DeepCopyPtr<Node> first_;
+		std::vector<DeepCopyPtr<Node, 64> > children_;
+	};
+	struct Leaf : Node {
+		Leaf(int value) : Node(value) {}
+		virtual int kind() const { return 1; }
+	};
+
+	// コピー中に例外を送出する節
+	struct Throwing : Node {
+		Throwing() : Node(-1) {}
+		Throwing(const Throwing &src) : Node(src) { throw std::runtime_error("Throwing"); }
+	};
+
+	// コピーコンストラクタで子を代入する節
+	struct Assigned {
+		Assigned(int value) : value_(value) {}
+		Assigned(const Assigned &src) : value_(src.value_) {
+			child_ = src.child_;
+			for(std::size_t i = 0; i < 2; ++i) children_[i] = src.children_[i];
+		}
+
+		int value_;
+		DeepCopyPtr<Assigned> child_;
+		DeepCopyPtr<Assigned> children_[2];
+	};
+
+	// コピーコンストラクタで子を標準コンテナへ追加し、その一時的なコピーを参照する節
+	struct Pushed {
+		Pushed(int value) : value_(value), firstValue_(-1) {}
+		Pushed(const Pushed &src) : value_(src.value_), firstValue_(-1) {
+			for(std::size_t i = 0; i < src.kids_.size(); ++i) kids_.push_back(src.kids_[i]);
+			if(src.kids_.empty()) return;
+			const DeepCopyPtr<Pushed> first(src.kids_.front());
+			firstValue_ = first ? first->value_ : -2;
+		}
+
+		int value_;
+		/// コピー時に読んだ最初の子の値. 子が無ければ-1.
+		int firstValue_;
+		std::vector<DeepCopyPtr<Pushed> > kids_;
+	};
+
+	/// 深さdepth、幅widthのPushedの木を作る. 作った節の数をcountへ加える.
+	DeepCopyPtr<Pushed> buildPushed(int depth, int width, int &count) {
+		DeepCopyPtr<Pushed> node(new Pushed(count++));
+		if(depth == 0) return node;
+		for(int i = 0; i < width; ++i) node->kids_.push_back(buildPushed(depth - 1, width, count));
+		node->firstValue_ = node->kids_.front()->value_;
+		return node;
+	}
+	/// aとbが同じ値で、異なるオブジェクトから成る木ならば、その節の数を返す. そうでなければ-1.
+	int samePushed(const DeepCopyPtr<Pushed> &a, const DeepCopyPtr<Pushed> &b) {
+		if(!a || !b) return !a && !b ? 0 : -1;
+		if(a.get() == b.get() || a->value_ != b->value_ || a->firstValue_ != b->firstValue_ || a->kids_.size() != b->kids_.size()) return -1;
+		int count = 1;
+		for(std::size_t i = 0; i < a->kids_.size(); ++i) {
+			const int n = samePushed(a->kids_[i], b->kids_[i]);
+			if(n < 0) return -1;
+			count += n;
+		}
+		return count;
+	}
+
+	// コピーコンストラクタで、CowPtrとAtomicDeepCopyPtrへコピーする節
+	struct Holder {
+		Holder(int value) : value_(value) {}
+		Holder(const Holder &src) : value_(src.value_), child_(aslib::deferred_copy, src.child_), leaf_(src.leaf_), cow_(src.leaf_), shared_(src.shared_) {
+			// 共有を解いてコピーする
+			shared_.get();
+			stored_.store(src.leaf_);
+			loaded_.store(src.loaded_.copy());
+		}
+
+		int value_;
+		DeepCopyPtr<Holder> child_;
+		DeepCopyPtr<Holder> leaf_;
+		/// leaf_のコピー.
+		aslib::CowPtr<Holder> cow_;
+		aslib::CowPtr<Holder> shared_;
+		/// leaf_のコピー.
+		aslib::AtomicDeepCopyPtr<Holder> stored_;
+		aslib::AtomicDeepCopyPtr<Holder> loaded_;
+	};
+
+	/// 深さdepthのHolderの木を作る.
+	DeepCopyPtr<Holder> buildHolder(int depth, int &count) {
+		DeepCopyPtr<Holder> node(new Holder(count++));
+		if(depth == 0) return node;
+		node->child_ = buildHolder(depth - 1, count);
+		node->leaf_.reset(new Holder(count++));
+		node->cow_ = aslib::CowPtr<Holder>(node->leaf_);
+		node->shared_ = aslib::CowPtr<Holder>(new Holder(count++));
+		node->stored_.store(node->leaf_);
+		node->loaded_.store(DeepCopyPtr<Holder>(new Holder(count++)));
+		return node;
+	}
+	/// @return	pが指す節の値. NULLならば-1.
+	int valueOf(const Holder *p) { return p ? p->value_ : -1; }
+	/// aとbが同じ値で、異なるオブジェクトから成る木ならば、その節の数を返す. そうでなければ-1.
+	int sameHolder(const DeepCopyPtr<Holder> &a, const DeepCopyPtr<Holder> &b) {
+		if(!a || !b) return !a && !b ? 0 : -1;
+		if(a.get() == b.get() || a->value_ != b->value_) return -1;
+		const aslib::CowPtr<Holder> &aShared = a->shared_, &bShared = b->shared_;
+		if(aShared.get() && aShared.get() == bShared.get()) return -1;
+		if(valueOf(a->leaf_.get()) != valueOf(b->leaf_.get()) || valueOf(b->cow_.get()) != valueOf(b->leaf_.get())
+			|| valueOf(aShared.get()) != valueOf(bShared.get())
+			|| valueOf(b->stored_.copy().get()) != valueOf(b->leaf_.get()) || valueOf(a->loaded_.copy().get()) != valueOf(b->loaded_.copy().get())) return -1;
+		const int n = sameHolder(a->child_, b->child_);
+		return n < 0 ? -1 : n + 1;
+	}
+
+	// aslib::deferred_copyを指定したか否かで、コピーコンストラクタの中で子を読んだ結果を記録する節
+	struct Probe {
+		Probe() : deferredWasNull_(false), copiedWasNull_(false) {}
+		Probe(const Probe &src) : deferred_(aslib::deferred_copy, src.deferred_), copied_(src.copied_), deferredWasNull_(!deferred_), copiedWasNull_(!copied_) {}
+
+		DeepCopyPtr<Probe> deferred_;
+		DeepCopyPtr<Probe> copied_;
+		bool deferredWasNull_;
+		bool copiedWasNull_;
+	};
+
+	/// 深さdepthのAssignedの木を作る. 作った節の数をcountへ加える.
+	DeepCopyPtr<Assigned> buildAssigned(int depth, int &count) {
+		DeepCopyPtr<Assigned> node(new Assigned(count++));
+		if(depth == 0) return node;
+		node->child_ = buildAssigned(depth - 1, count);
+		for(std::size_t i = 0; i < 2; ++i) node->children_[i] = buildAssigned(depth - 1, count);
+		return node;
+	}
+	/// aとbが同じ値で、異なるオブジェクトから成る木ならば、その節の数を返す. そうでなければ-1.
+	int sameAssigned(const DeepCopyPtr<Assigned> &a, const DeepCopyPtr<Assigned> &b) {
+		if(!a || !b) return !a && !b ? 0 : -1;
+		if(a.get() == b.get() || a->value_ != b->value_) return -1;
+		int count = 1;
+		const DeepCopyPtr<Assigned> *as[] = { &a->child_, &a->children_[0], &a->children_[1] };
+		const DeepCopyPtr<Assigned> *bs[] = { &b->child_, &b->children_[0], &b->children_[1] };
+		for(std::size_t i = 0; i < 3; ++i) {
+			const int n = sameAssigned(*as[i], *bs[i]);
+			if(n < 0) return -1;
+			count += n;
+		}
+		return count;
+	}
+
+	/// 深さdepth、幅widthの木を作る. 作った節の数をcountへ加える.
+	DeepCopyPtr<Node> build(int depth, int width, int &count) {
+		DeepCopyPtr<Node> node(new Node(count++));
+		if(depth == 0) return node;
+		node->first_.reset(new Leaf(count++));
+		for(int i = 0; i < width; ++i) {
+			node->children_.push_back(DeepCopyPtr<Node, 64>());
+			if(i % 2) node->children_.back().emplace<Leaf>(count++);
+			else node->children_.back() = build(depth - 1, width, count);
+		}
+		return node;
+	}
+
+	/// aとbが同じ構造・値で、異なるオブジェクトから成る木ならばtrue. 節の数をcountへ加える.
+	template<std::size_t A, std::size_t B>
+	bool same(const DeepCopyPtr<Node, A> &a, const DeepCopyPtr<Node, B> &b, int &count) {
+		if(!a || !b) return !a && !b;
+		++count;
+		if(a.get() == b.get() || a->kind() != b->kind() || a->value_ != b->value_) return false;
+		if(!same(a->first_, b->first_, count)) return false;
+		if(a->children_.size() != b->children_.size()) return false;
+		for(std::size_t i = 0; i < a->children_.size(); ++i) {
+			if(!same(a->children_[i], b->children_[i], count)) return false;
+		}
+		return true;
+	}
+
+	// ジョブ毎にスレッドを開始し、破棄時に終了を待つ
+	struct ThreadExecutor {
+		~ThreadExecutor() { for(std::size_t i = 0; i < threads.size(); ++i) threads[i].join(); }
+		void operator()(std::function<void()> job) { threads.push_back(std::thread(job)); }
+		std::vector<std::thread> threads;
+	};
+}
+
+BOOST_AUTO_TEST_SUITE(DeepCopyParallelTest)
+
+BOOST_AUTO_TEST_CASE(testSameAsSerial) {
+	int built = 0;
+	const DeepCopyPtr<Node> src = build(6, 4, built);
+
+	ThreadExecutor executor;
+	const DeepCopyPtr<Node> copy = aslib::deep_copy(src, executor, 4);
+	int compared = 0;
+	BOOST_CHECK(same(src, copy, compared));
+	BOOST_CHECK_EQUAL(compared, built);
+
+	// 通常のコピーは後回しにしない
+	const DeepCopyPtr<Node> serial(src);
+	compared = 0;
+	BOOST_CHECK(same(copy, serial, compared));
+	BOOST_CHECK_EQUAL(compared, built);
+}
+
+BOOST_AUTO_TEST_CASE(testSingleThread) {
+	int built = 0;
+	const DeepCopyPtr<Node> src = build(3, 3, built);
+	const DeepCopyPtr<Node> copy = aslib::deep_copy(src, [](std::function<void()>) { BOOST_ERROR("The executor must not be used."); }, 1);
+	int compared = 0;
+	BOOST_CHECK(same(src, copy, compared));
+	BOOST_CHECK_EQUAL(compared, built);
+
+	BOOST_CHECK(!aslib::deep_copy(DeepCopyPtr<Node>(), [](std::function<void()>) {}));
+}
+
+BOOST_AUTO_TEST_CASE(testLateJobs) {
+	// deep_copyの終了後に開始したジョブは何もしない
+	int built = 0;
+	const DeepCopyPtr<Node> src = build(3, 3, built);
+	std::vector<std::function<void()> > jobs;
+	const DeepCopyPtr<Node> copy = aslib::deep_copy(src, [&](std::function<void()> job) { jobs.push_back(job); }, 3);
+	BOOST_CHECK_EQUAL(jobs.size(), 2u);
+	for(std::size_t i = 0; i < jobs.size(); ++i) jobs[i]();
+	int compared = 0;
+	BOOST_CHECK(same(src, copy, compared));
+	BOOST_CHECK_EQUAL(compared, built);
+}
+
+BOOST_AUTO_TEST_CASE(testAssignInCopyConstructor) {
+	// コピーコンストラクタ中の代入は後回しにせず、その場でコピーする
+	int built = 0;
+	const DeepCopyPtr<Assigned> src = buildAssigned(5, built);
+	ThreadExecutor executor;
+	const DeepCopyPtr<Assigned> copy = aslib::deep_copy(src, executor, 4);
+	BOOST_CHECK_EQUAL(sameAssigned(src, copy), built);
+}
+
+BOOST_AUTO_TEST_CASE(testPushBackInCopyConstructor) {
+	// 標準コンテナへの追加や一時的なコピーは後回しにせず、その場でコピーする
+	int built = 0;
+	const DeepCopyPtr<Pushed> src = buildPushed(4, 3, built);
+	ThreadExecutor executor;
+	const DeepCopyPtr<Pushed> copy = aslib::deep_copy(src, executor, 4);
+	BOOST_CHECK_EQUAL(samePushed(src, copy), built);
+}
+
+BOOST_AUTO_TEST_CASE(testCowAndAtomicMembers) {
+	// CowPtrとAtomicDeepCopyPtrが内部で作る一時的なコピーも、その場でコピーする
+	int built = 0;
+	const DeepCopyPtr<Holder> src = buildHolder(6, built);
+	ThreadExecutor executor;
+	const DeepCopyPtr<Holder> copy = aslib::deep_copy(src, executor, 4);
+	BOOST_CHECK_EQUAL(sameHolder(src, copy), 7);
+}
+
+BOOST_AUTO_TEST_CASE(testDeferredCopyOnly) {
+	DeepCopyPtr<Probe> src(new Probe());
+	src->deferred_.reset(new Probe());
+	src->copied_.reset(new Probe());
+
+	// deep_copyの中では、deferred_copyを指定したコピーのみを後回しにする
+	ThreadExecutor executor;
+	const DeepCopyPtr<Probe> copy = aslib::deep_copy(src, executor, 2);
+	BOOST_CHECK(copy->deferredWasNull_);
+	BOOST_CHECK(!copy->copiedWasNull_);
+	BOOST_CHECK(copy->deferred_ && copy->copied_);
+
+	// deep_copyの外では、deferred_copyを指定しても通常のコピーと同じ
+	const DeepCopyPtr<Probe> serial(src);
+	BOOST_CHECK(!serial->deferredWasNull_);
+	BOOST_CHECK(!serial->copiedWasNull_);
+}
+
+BOOST_AUTO_TEST_CASE(testException) {
+	int built = 0;
+	DeepCopyPtr<Node> src = build(4, 3, built);
+	src->children_[2]->children_[0]->first_.reset(new Throwing());
+
+	ThreadExecutor executor;
+	BOOST_CHECK_THROW(aslib::deep_copy(src, executor, 4), std::runtime_error);
+
+	// executorの例外も送出する
+	BOOST_CHECK_THROW(aslib::deep_copy(src, [](std::function<void()>) { throw std::logic_error("executor"); }, 2), std::logic_error);
+}
+
+#if ASLIB_HAS_MEMORY_RESOURCE
+BOOST_AUTO_TEST_CASE(testArenas) {
+	int built = 0;
+	const DeepCopyPtr<Node> src = build(5, 4, built);
+
+	aslib::DeepCopyArenas arenas;
+	ThreadExecutor executor;
+	DeepCopyPtr<Node> copy = aslib::deep_copy(src, executor, arenas, 4);
+	int compared = 0;
+	BOOST_CHECK(same(src, copy, compared));
+	BOOST_CHECK_EQUAL(compared, built);
+
+	// deep_copyの後の通常のコピーは、コピー元と同じarenaから確保する
+	const DeepCopyPtr<Node> again(copy);
+	compared = 0;
+	BOOST_CHECK(same(copy, again, compared));
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,9 +1,30 @@
 ﻿#include <boost/test/unit_test.hpp>
 
+#include <vector>
+
 #include <aslib/DeepCopyPtr.hpp>
 
+#if ASLIB_HAS_MEMORY_RESOURCE
+#	include <memory_resource>
+#endif
+
 using aslib::DeepCopyPtr;
 
+namespace {
+	struct Pooled;
+	struct Counted;
+	struct Q;
+}
+namespace aslib {
+	template<> struct DeepCopyPoolTraits<Pooled> {
+		static const bool enabled = true;
+		static const std::size_t maxCached = 4;
+	};
+	// operator=()がコピーコンストラクタと同じ意味を持つ
+	template<> struct DeepCopyAssignTraits<Counted> { static const bool enabled = true; };
+	template<> struct DeepCopyAssignTraits<Q> { static const bool enabled = true; };
+}
+
 namespace {
 	// テストで使用するユーザー定義クラス群
 
@@ -19,6 +40,84 @@ namespace {
 		D(const D &src) : C(src.i_) {}
 	};
 
+	// 仮想関数を持つ基底クラスと、それを継承したクラス
+	struct P {
+		virtual ~P() {}
+		virtual int kind() const { return 0; }
+	};
+	struct Q : P {
+		Q(int j) : j_(j) {}
+		virtual int kind() const { return 1; }
+		int j_;
+	};
+
+	// コピーされた回数を記録するクラス
+	struct Counted {
+		Counted(int *copies) : copies_(copies) {}
+		Counted(const Counted &src) : copies_(src.copies_) { ++*copies_; }
+		Counted &operator=(const Counted &rhs) { copies_ = rhs.copies_; ++*copies_; return *this; }
+		int *copies_;
+	};
+
+	// 生存しているオブジェクトの数を記録するクラス
+	struct Alive {
+		Alive(int *alive, int i = 0) : alive_(alive), i_(i) { ++*alive_; }
+		Alive(const Alive &src) : alive_(src.alive_), i_(src.i_) { ++*alive_; }
+		Alive(Alive &&src) noexcept : alive_(src.alive_), i_(src.i_) { ++*alive_; }
+		Alive &operator=(const Alive &rhs) { i_ = rhs.i_; return *this; }
+		~Alive() { --*alive_; }
+		int *alive_;
+		int i_;
+	};
+	// 内部に格納するには大きすぎるクラス
+	struct Big {
+		Big(int i) : i_(i) {}
+		int i_;
+		char padding_[60];
+	};
+
+	/// @return	pがobjの領域内を指しているならばtrue.
+	template<typename T>
+	bool isInside(const void *p, const T &obj) {
+		const char *b = reinterpret_cast<const char *>(&obj);
+		const char *q = static_cast<const char *>(p);
+		return b <= q && q < b + sizeof(T);
+	}
+
+#if ASLIB_HAS_MEMORY_RESOURCE
+	// 確保・解放の回数を記録するmemory_resource
+	struct CountingResource : std::pmr::memory_resource {
+		CountingResource() : allocated_(0), deallocated_(0) {}
+		void *do_allocate(std::size_t bytes, std::size_t alignment) {
+			++allocated_;
+			return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+		}
+		void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) {
+			++deallocated_;
+			std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+		}
+		bool do_is_equal(const std::pmr::memory_resource &other) const noexcept { return this == &other; }
+		int allocated_, deallocated_;
+	};
+#endif
+
+	// フリーリストから確保されるクラス
+	struct Pooled {
+		Pooled(int i) : i_(i) {}
+		int i_;
+	};
+
+	/// 代入演算子を持たないクラス
+	struct NoAssign {
+		NoAssign(int i) : i_(i) {}
+		const int i_;
+	};
+
+	DeepCopyPtr<Counted> makeCounted(int *copies) {
+		DeepCopyPtr<Counted> p(new Counted(copies));
+		return p;
+	}
+
 	std::ostream &operator<<(std::ostream &stream, const C &src)
 	{
 		stream << "[[" << typeid(src).name() << "::i_ = " << src.i_ << "]]";
@@ -58,6 +157,23 @@ BOOST_AUTO_TEST_CASE(testCopyConstructor) {
 	BOOST_CHECK_NE(cp.get(), dp1.get());
 }
 
+BOOST_AUTO_TEST_CASE(testCopyConstructor_keepDynamicType) {
+	// 基底クラスのDeepCopyPtrからコピーしてもスライシングされない
+	DeepCopyPtr<P> src(new Q(5));
+	DeepCopyPtr<P> dst(src);
+	BOOST_REQUIRE(dst);
+	BOOST_CHECK_NE(dst.get(), src.get());
+	BOOST_CHECK(typeid(*dst) == typeid(Q));
+	BOOST_CHECK_EQUAL(dst->kind(), 1);
+	BOOST_CHECK_EQUAL(static_cast<Q &>(*dst).j_, 5);
+
+	// 派生クラスのDeepCopyPtrから
+	DeepCopyPtr<Q> qsrc(new Q(6));
+	DeepCopyPtr<P> pdst(qsrc);
+	BOOST_CHECK(typeid(*pdst) == typeid(Q));
+	BOOST_CHECK_EQUAL(static_cast<Q &>(*pdst).j_, 6);
+}
+
 BOOST_AUTO_TEST_CASE(testCopyConstructor_fromConstPtr) {
 	const C *cnp = new C();
 	DeepCopyPtr<C> cdp(cnp);
@@ -66,6 +182,41 @@ BOOST_AUTO_TEST_CASE(testCopyConstructor_fromConstPtr) {
 	delete cnp;
 }
 
+BOOST_AUTO_TEST_CASE(testMoveConstructor) {
+	int copies = 0;
+	Counted *raw = new Counted(&copies);
+	DeepCopyPtr<Counted> src(raw);
+
+	DeepCopyPtr<Counted> dst(std::move(src));
+	BOOST_CHECK_EQUAL(copies, 0);
+	BOOST_CHECK_EQUAL(dst.get(), raw);
+	BOOST_CHECK(!src);
+
+	// 派生クラスのDeepCopyPtrから
+	D *d = new D(1);
+	DeepCopyPtr<D> dsrc(d);
+	DeepCopyPtr<C> cdst(std::move(dsrc));
+	BOOST_CHECK_EQUAL(cdst.get(), d);
+	BOOST_CHECK(!dsrc);
+
+	// 関数の戻り値
+	DeepCopyPtr<Counted> ret = makeCounted(&copies);
+	BOOST_CHECK(ret);
+	BOOST_CHECK_EQUAL(copies, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testMoveConstructor_inVector) {
+	// 再確保時に要素がコピーされない
+	int copies = 0;
+	std::vector<DeepCopyPtr<Counted> > v;
+	for(int i = 0; i < 100; ++i) v.push_back(makeCounted(&copies));
+	BOOST_CHECK_EQUAL(copies, 0);
+
+	// vector自体のコピーでは、要素毎に1回ずつコピーされる
+	std::vector<DeepCopyPtr<Counted> > w(v);
+	BOOST_CHECK_EQUAL(copies, 100);
+}
+
 BOOST_AUTO_TEST_CASE(testSwap) {
 	DeepCopyPtr<C> p1(new C(1)), p2(new C(2));
 	p1.swap(p2);
@@ -177,6 +328,44 @@ BOOST_AUTO_TEST_CASE(testOpequal_sp_toSuper_from0) {	// operator=
 	BOOST_CHECK(!lhs);
 }
 
+BOOST_AUTO_TEST_CASE(testOpequal_sp_keepDynamicType) {	// operator=
+	// 基底クラスのDeepCopyPtr同士の代入でもスライシングされない
+	DeepCopyPtr<P> src(new Q(7)), dst;
+	dst = src;
+	BOOST_REQUIRE(dst);
+	BOOST_CHECK(typeid(*dst) == typeid(Q));
+	BOOST_CHECK_EQUAL(static_cast<Q &>(*dst).j_, 7);
+
+	// 派生クラスのDeepCopyPtrから
+	DeepCopyPtr<Q> qsrc(new Q(8));
+	dst = qsrc;
+	BOOST_CHECK(typeid(*dst) == typeid(Q));
+	BOOST_CHECK_EQUAL(static_cast<Q &>(*dst).j_, 8);
+}
+
+BOOST_AUTO_TEST_CASE(testOpequal_move) {	// operator=(&&)
+	int copies = 0;
+	Counted *raw = new Counted(&copies);
+	DeepCopyPtr<Counted> src(raw), dst(new Counted(&copies));
+
+	dst = std::move(src);
+	BOOST_CHECK_EQUAL(copies, 0);
+	BOOST_CHECK_EQUAL(dst.get(), raw);
+	BOOST_CHECK(!src);
+
+	// 同じオブジェクトへのムーブ代入
+	dst = std::move(dst);
+	BOOST_CHECK_EQUAL(dst.get(), raw);
+
+	// 派生クラスのDeepCopyPtrから
+	D *d = new D(1);
+	DeepCopyPtr<D> dsrc(d);
+	DeepCopyPtr<C> cdst(new C(2));
+	cdst = std::move(dsrc);
+	BOOST_CHECK_EQUAL(cdst.get(), d);
+	BOOST_CHECK(!dsrc);
+}
+
 BOOST_AUTO_TEST_CASE(testOpequal_lp_toSame) {	// operator=
 	// 同型、素のポインタから
 	DeepCopyPtr<D> dsp;
@@ -229,6 +418,223 @@ BOOST_AUTO_TEST_CASE(testOpequal_lp_toSuper_from0) {	// operator=
 	BOOST_CHECK(!rhs);
 }
 
+BOOST_AUTO_TEST_CASE(testSizeof) {
+	// 削除子は型毎の静的な関数テーブルで表す為、生ポインタ2つ分に収まる
+	BOOST_CHECK_EQUAL(sizeof(DeepCopyPtr<C>), sizeof(void *) * 2);
+	BOOST_CHECK_EQUAL(sizeof(DeepCopyPtr<int>), sizeof(void *) * 2);
+}
+
+BOOST_AUTO_TEST_CASE(testInline_copy) {
+	// 小さいオブジェクトは内部に格納する
+	DeepCopyPtr<C, 16> src(new C(1));
+	BOOST_CHECK(!isInside(src.get(), src));	// ポインタから構築した場合はそのまま保持する
+	DeepCopyPtr<C, 16> dst(src);
+	BOOST_CHECK(isInside(dst.get(), dst));
+	BOOST_CHECK_EQUAL(*dst, *src);
+
+	// 大きいオブジェクトはヒープに置く
+	DeepCopyPtr<Big, 16> bsrc(new Big(2));
+	DeepCopyPtr<Big, 16> bdst(bsrc);
+	BOOST_CHECK(!isInside(bdst.get(), bdst));
+	BOOST_CHECK_EQUAL(bdst->i_, 2);
+
+	// 動的な型を保ったまま格納する
+	DeepCopyPtr<P, 32> psrc(new Q(3)), pdst;
+	pdst = psrc;
+	BOOST_CHECK(isInside(pdst.get(), pdst));
+	BOOST_CHECK(typeid(*pdst) == typeid(Q));
+	BOOST_CHECK_EQUAL(static_cast<Q &>(*pdst).j_, 3);
+
+	// 内部に格納しないDeepCopyPtrとの相互コピー
+	DeepCopyPtr<P> heap(pdst);
+	BOOST_CHECK(typeid(*heap) == typeid(Q));
+	DeepCopyPtr<P, 32> back(heap);
+	BOOST_CHECK(isInside(back.get(), back));
+	BOOST_CHECK(typeid(*back) == typeid(Q));
+}
+
+BOOST_AUTO_TEST_CASE(testInline_move) {
+	int alive = 0;
+	{
+		DeepCopyPtr<Alive, 32> src;
+		src.emplace<Alive>(&alive, 4);
+		BOOST_REQUIRE(isInside(src.get(), src));
+		BOOST_CHECK_EQUAL(alive, 1);
+
+		DeepCopyPtr<Alive, 32> dst(std::move(src));
+		BOOST_CHECK(!src);
+		BOOST_CHECK(isInside(dst.get(), dst));
+		BOOST_CHECK_EQUAL(dst->i_, 4);
+		BOOST_CHECK_EQUAL(alive, 1);
+
+		DeepCopyPtr<Alive, 32> heap(new Alive(&alive, 5));
+		heap.swap(dst);
+		BOOST_CHECK(isInside(heap.get(), heap));
+		BOOST_CHECK_EQUAL(heap->i_, 4);
+		BOOST_CHECK(!isInside(dst.get(), dst));
+		BOOST_CHECK_EQUAL(dst->i_, 5);
+		BOOST_CHECK_EQUAL(alive, 2);
+
+		heap.reset();
+		BOOST_CHECK_EQUAL(alive, 1);
+	}
+	BOOST_CHECK_EQUAL(alive, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testEmplace) {
+	DeepCopyPtr<C> p;
+	p.emplace<D>(9);
+	BOOST_CHECK_EQUAL(p->i_, 9);
+
+	DeepCopyPtr<P, 16> ip;
+	ip.emplace<Q>(10);
+	BOOST_CHECK(isInside(ip.get(), ip));
+	BOOST_CHECK_EQUAL(static_cast<Q &>(*ip).j_, 10);
+
+	// ムーブコンストラクタが例外を送出し得る型はヒープに置く
+	DeepCopyPtr<C, 16> dp;
+	dp.emplace<D>(12);
+	BOOST_CHECK(!isInside(dp.get(), dp));
+	BOOST_CHECK_EQUAL(dp->i_, 12);
+
+	DeepCopyPtr<Big, 16> bp;
+	bp.emplace<Big>(11);
+	BOOST_CHECK(!isInside(bp.get(), bp));
+	BOOST_CHECK_EQUAL(bp->i_, 11);
+}
+
+#if ASLIB_HAS_MEMORY_RESOURCE
+BOOST_AUTO_TEST_CASE(testMemoryResource_emplace) {
+	CountingResource resource;
+	int alive = 0;
+	{
+		DeepCopyPtr<Alive> p;
+		p.emplace<Alive>(std::allocator_arg, &resource, &alive, 1);
+		BOOST_CHECK_EQUAL(resource.allocated_, 1);
+		BOOST_CHECK_EQUAL(p->i_, 1);
+		BOOST_CHECK_EQUAL(alive, 1);
+
+		// コピーも同じmemory_resourceから確保される
+		DeepCopyPtr<Alive> q(p);
+		BOOST_CHECK_EQUAL(resource.allocated_, 2);
+		BOOST_CHECK_EQUAL(q->i_, 1);
+
+		// 内部に格納出来る大きさでも、確保元を保つ為にヒープに置く
+		DeepCopyPtr<Alive, 32> r(p);
+		BOOST_CHECK(!isInside(r.get(), r));
+		BOOST_CHECK_EQUAL(resource.allocated_, 3);
+
+		q.reset();
+		BOOST_CHECK_EQUAL(resource.deallocated_, 1);
+		BOOST_CHECK_EQUAL(alive, 2);
+	}
+	BOOST_CHECK_EQUAL(resource.deallocated_, 3);
+	BOOST_CHECK_EQUAL(alive, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testMemoryResource_copy) {
+	CountingResource resource;
+	{
+		// 動的な型を保ったまま、memory_resourceへコピーする
+		DeepCopyPtr<P> src(new Q(3));
+		DeepCopyPtr<P> dst(std::allocator_arg, &resource, src);
+		BOOST_CHECK_EQUAL(resource.allocated_, 1);
+		BOOST_CHECK(typeid(*dst) == typeid(Q));
+		BOOST_CHECK_EQUAL(static_cast<Q &>(*dst).j_, 3);
+
+		DeepCopyPtr<P> copied;
+		copied = dst;
+		BOOST_CHECK_EQUAL(resource.allocated_, 2);
+		BOOST_CHECK(typeid(*copied) == typeid(Q));
+
+		// NULLからのコピーでは確保しない
+		DeepCopyPtr<P> null;
+		DeepCopyPtr<P> nullCopied(std::allocator_arg, &resource, null);
+		BOOST_CHECK(!nullCopied);
+		BOOST_CHECK_EQUAL(resource.allocated_, 2);
+	}
+	BOOST_CHECK_EQUAL(resource.deallocated_, 2);
+}
+
+BOOST_AUTO_TEST_CASE(testMemoryResource_monotonic) {
+	// 一括解放するmemory_resourceから確保する
+	char buffer[1024];
+	std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+	{
+		DeepCopyPtr<C> src(new C(4));
+		std::vector<DeepCopyPtr<C> > copies;
+		for(int i = 0; i < 8; ++i) copies.push_back(DeepCopyPtr<C>(std::allocator_arg, &arena, src));
+		for(std::size_t i = 0; i < copies.size(); ++i) {
+			BOOST_CHECK_EQUAL(copies[i]->i_, 4);
+			BOOST_CHECK(reinterpret_cast<char *>(copies[i].get()) >= buffer);
+			BOOST_CHECK(reinterpret_cast<char *>(copies[i].get()) < buffer + sizeof(buffer));
+		}
+	}
+	arena.release();
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(testOpequal_inPlace) {	// operator=
+	// 同じ動的な型同士の代入は、領域を確保し直さない
+	int copies = 0;
+	DeepCopyPtr<Counted> src(new Counted(&copies)), dst(new Counted(&copies));
+	Counted *before = dst.get();
+	dst = src;
+	BOOST_CHECK_EQUAL(dst.get(), before);
+	BOOST_CHECK_EQUAL(copies, 1);	// operator=()のみ
+
+	// 基底クラスのDeepCopyPtrでも、動的な型が同じならば代入する
+	DeepCopyPtr<P> p(new Q(1)), q(new Q(2));
+	P *pBefore = p.get();
+	p = q;
+	BOOST_CHECK_EQUAL(p.get(), pBefore);
+	BOOST_CHECK_EQUAL(static_cast<Q &>(*p).j_, 2);
+
+	// 動的な型が異なれば、コピーし直す
+	DeepCopyPtr<P> base(new P);
+	base = q;
+	BOOST_CHECK(typeid(*base) == typeid(Q));
+
+	// 代入演算子を持たない型は、コピーし直す
+	DeepCopyPtr<NoAssign> na(new NoAssign(1)), nb(new NoAssign(2));
+	na = nb;
+	BOOST_CHECK_EQUAL(na->i_, 2);
+	BOOST_CHECK_NE(na.get(), nb.get());
+
+	// DeepCopyAssignTraitsで代入を許していない型は、コピーコンストラクタでコピーし直す
+	DeepCopyPtr<D> da(new D(1)), db(new D(2));
+	static_assert(!aslib::DeepCopyAssignTraits<D>::enabled, "D has a user-provided copy constructor.");
+	static_assert(aslib::DeepCopyAssignTraits<C>::enabled, "C is trivially copyable.");
+	da = db;
+	BOOST_CHECK_EQUAL(da->i_, 2);
+	BOOST_CHECK_NE(da.get(), db.get());
+}
+
+BOOST_AUTO_TEST_CASE(testPool) {
+	DeepCopyPtr<Pooled> src(new Pooled(1));
+	Pooled *freed;
+	{
+		DeepCopyPtr<Pooled> copy(src);
+		freed = copy.get();
+	}
+	// 破棄したコピーの領域を再利用する
+	DeepCopyPtr<Pooled> reused(src);
+	BOOST_CHECK_EQUAL(reused.get(), freed);
+	BOOST_CHECK_EQUAL(reused->i_, 1);
+
+	reused.reset();
+	DeepCopyPtr<Pooled> emplaced;
+	emplaced.emplace<Pooled>(2);
+	BOOST_CHECK_EQUAL(emplaced.get(), freed);
+	BOOST_CHECK_EQUAL(emplaced->i_, 2);
+
+	// プールの上限を超えて破棄しても問題無い
+	std::vector<DeepCopyPtr<Pooled> > many(16, src);
+	many.clear();
+	DeepCopyPtr<Pooled> again(src);
+	BOOST_CHECK_EQUAL(again->i_, 1);
+}
+
 BOOST_AUTO_TEST_CASE(testOpbool) {	// operator bool
 	DeepCopyPtr<int> p1, p2(static_cast<int *>(0)), p3(new int());
 	BOOST_CHECK_EQUAL(static_cast<bool>(p1), false);
@@ -0,0 +1,107 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <type_traits>
+
+#include <aslib/Error.hpp>
+#include <aslib/Result.hpp>
+
+using aslib::BasicError;
+using aslib::Error;
+using aslib::ErrorCategory;
+using aslib::Result;
+
+namespace {
+	enum ParseErrorCode { unexpectedEof = 1, invalidToken };
+
+	class ParseErrorCategory : public ErrorCategory {
+	public:
+		const char *name() const { return "parse"; }
+		std::string message(int code) const {
+			switch(code) {
+			case unexpectedEof: return "unexpected EOF";
+			case invalidToken: return "invalid token";
+			default: return "unknown";
+			}
+		}
+	};
+	const ErrorCategory &parseErrorCategory() { static const ParseErrorCategory c; return c; }
+
+	class IoErrorCategory : public ErrorCategory {
+	public:
+		const char *name() const { return "io"; }
+		std::string message(int) const { return "io error"; }
+	};
+	const ErrorCategory &ioErrorCategory() { static const IoErrorCategory c; return c; }
+
+	static_assert(sizeof(Error) <= 2 * sizeof(void *), "Error must fit in two words.");
+	static_assert(std::is_trivially_copyable<Error>::value, "");
+	static_assert(std::is_trivially_copyable<BasicError<32> >::value, "");
+	static_assert(std::is_trivially_copyable<Result<int, Error> >::value, "Result<int, Error> must be trivially copyable.");
+	static_assert(std::is_trivially_copyable<Result<int, BasicError<32> > >::value, "");
+
+	Result<int, Error> parseDigit(char c) {
+		if(c == '\0') return Error(unexpectedEof, parseErrorCategory());
+		if(c < '0' || '9' < c) return Error(invalidToken, parseErrorCategory());
+		return c - '0';
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(ErrorTest)
+	BOOST_AUTO_TEST_CASE(testDefault) {
+		Error e;
+		BOOST_CHECK_EQUAL(e.code(), 0);
+		BOOST_CHECK(e.category() == 0);
+		BOOST_CHECK_EQUAL(e.message(), "");
+		BOOST_CHECK(e == Error());
+	}
+
+	BOOST_AUTO_TEST_CASE(testCodeAndCategory) {
+		Error e(invalidToken, parseErrorCategory());
+		BOOST_CHECK_EQUAL(e.code(), invalidToken);
+		BOOST_CHECK_EQUAL(e.category(), &parseErrorCategory());
+		BOOST_CHECK_EQUAL(e.category()->name(), "parse");
+		BOOST_CHECK_EQUAL(e.message(), "invalid token");
+	}
+
+	BOOST_AUTO_TEST_CASE(testCompare) {
+		Error a(unexpectedEof, parseErrorCategory());
+		BOOST_CHECK(a == Error(unexpectedEof, parseErrorCategory()));
+		BOOST_CHECK(a != Error(invalidToken, parseErrorCategory()));
+		BOOST_CHECK(a != Error(unexpectedEof, ioErrorCategory()));	// コードが同じでも分類が異なる
+	}
+
+	BOOST_AUTO_TEST_CASE(testResult) {
+		Result<int, Error> ok = parseDigit('7'), eof = parseDigit('\0'), bad = parseDigit('x');
+		BOOST_CHECK_EQUAL(*ok, 7);
+		BOOST_CHECK(eof.fail() == Error(unexpectedEof, parseErrorCategory()));
+		BOOST_CHECK_EQUAL(bad.fail().message(), "invalid token");
+	}
+BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_SUITE(BasicErrorTest)
+	BOOST_AUTO_TEST_CASE(testDetail) {
+		BasicError<16> e(invalidToken, parseErrorCategory(), "near ')'");
+		BOOST_CHECK_EQUAL(e.detail(), "near ')'");
+		BOOST_CHECK_EQUAL(e.message(), "invalid token");
+		BOOST_CHECK(e == Error(invalidToken, parseErrorCategory()));	// Errorとして比較出来る
+
+		BasicError<16> d;
+		BOOST_CHECK_EQUAL(d.detail(), "");
+	}
+
+	BOOST_AUTO_TEST_CASE(testTruncate) {
+		BasicError<8> e(unexpectedEof, parseErrorCategory(), "0123456789");
+		BOOST_CHECK_EQUAL(e.detail(), "0123456");
+		BasicError<1> empty(unexpectedEof, parseErrorCategory(), "abc");
+		BOOST_CHECK_EQUAL(empty.detail(), "");
+	}
+
+	BOOST_AUTO_TEST_CASE(testResult) {
+		typedef BasicError<32> E;
+		Result<int, E> r = E(invalidToken, parseErrorCategory(), "line 3");
+		Result<int, E> copied = r;
+		BOOST_CHECK_EQUAL(copied.fail().detail(), "line 3");
+		BOOST_CHECK_EQUAL(copied.fail().code(), invalidToken);
+	}
+BOOST_AUTO_TEST_SUITE_END();
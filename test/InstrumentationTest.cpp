@@ -0,0 +1,173 @@
+﻿// このファイルのみ計測を有効にする. 他の翻訳単位と定義が食い違わないよう、計測する型はこのファイル内の無名名前空間に限る.
+#undef ASLIB_ENABLE_INSTRUMENTATION
+#define ASLIB_ENABLE_INSTRUMENTATION 1
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <aslib/DeepCopyPtr.hpp>
+#include <aslib/Instrumentation.hpp>
+#include <aslib/Result.hpp>
+
+using aslib::DeepCopyPtr;
+using aslib::InstrumentationCounters;
+using aslib::Result;
+using aslib::instrumentation_of;
+
+namespace {
+	// テストで使用するユーザー定義クラス群
+
+	// ヒープに確保されるオブジェクト
+	struct Heavy {
+		Heavy() {}
+		char data[256];
+	};
+
+	// DeepCopyPtr内部に格納されるオブジェクト
+	struct Small {
+		Small(int i) : i_(i) {}
+		Small(const Small &src) : i_(src.i_) {}
+		Small(Small &&src) noexcept : i_(src.i_) {}
+		Small &operator=(const Small &) = default;
+		int i_;
+	};
+
+	// 指定した場合にコピーで例外を送出するオブジェクト
+	struct Throwing {
+		Throwing(bool t) : throws_(t) {}
+		Throwing(const Throwing &src) : throws_(src.throws_) {
+			if(throws_) throw std::runtime_error("Throwing");
+		}
+		Throwing &operator=(const Throwing &) = default;
+		bool throws_;
+	};
+
+	// スレッド毎に計測するオブジェクト
+	struct Shared {
+		int i_;
+	};
+
+	// 自明にコピー出来るResultは計測しない為、コピーコンストラクタを定義する
+	struct Succeeded {
+		Succeeded() : i_(0) {}
+		Succeeded(const Succeeded &src) : i_(src.i_) {}
+		Succeeded &operator=(const Succeeded &) = default;
+		int i_;
+	};
+	struct Failed {
+		int code_;
+	};
+	typedef Result<Succeeded, Failed> TestResult;
+
+	/// @return	計測値begin, endの差.
+	InstrumentationCounters difference(const InstrumentationCounters &end, const InstrumentationCounters &begin) {
+		InstrumentationCounters d;
+		d.clones = end.clones - begin.clones;
+		d.moves = end.moves - begin.moves;
+		d.assignments = end.assignments - begin.assignments;
+		d.allocations = end.allocations - begin.allocations;
+		d.bytesAllocated = end.bytesAllocated - begin.bytesAllocated;
+		d.exceptions = end.exceptions - begin.exceptions;
+		return d;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(InstrumentationTest)
+
+BOOST_AUTO_TEST_CASE(testHeapClone) {
+	const InstrumentationCounters begin = instrumentation_of<Heavy>();
+
+	DeepCopyPtr<Heavy> p(new Heavy());
+	DeepCopyPtr<Heavy> q(p);
+	DeepCopyPtr<Heavy> r(std::move(q));
+	r = p;
+
+	const InstrumentationCounters d = difference(instrumentation_of<Heavy>(), begin);
+	BOOST_CHECK_EQUAL(d.clones, 1u);
+	BOOST_CHECK_EQUAL(d.moves, 0u);
+	BOOST_CHECK_EQUAL(d.assignments, 1u);
+	BOOST_CHECK_EQUAL(d.allocations, 1u);
+	BOOST_CHECK_EQUAL(d.bytesAllocated, sizeof(Heavy));
+	BOOST_CHECK_EQUAL(d.exceptions, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(testInlineStorage) {
+	const InstrumentationCounters begin = instrumentation_of<Small>();
+
+	DeepCopyPtr<Small, 16> p;
+	p.emplace<Small>(1);
+	DeepCopyPtr<Small, 16> q(p);
+	DeepCopyPtr<Small, 16> r(std::move(q));
+
+	const InstrumentationCounters d = difference(instrumentation_of<Small>(), begin);
+	BOOST_CHECK_EQUAL(d.clones, 1u);
+	BOOST_CHECK_EQUAL(d.moves, 1u);
+	BOOST_CHECK_EQUAL(d.allocations, 0u);
+	BOOST_CHECK_EQUAL(r->i_, 1);
+}
+
+BOOST_AUTO_TEST_CASE(testException) {
+	const InstrumentationCounters begin = instrumentation_of<Throwing>();
+
+	DeepCopyPtr<Throwing> p(new Throwing(true));
+	BOOST_CHECK_THROW(DeepCopyPtr<Throwing> q(p), std::runtime_error);
+
+	const InstrumentationCounters d = difference(instrumentation_of<Throwing>(), begin);
+	BOOST_CHECK_EQUAL(d.clones, 0u);
+	BOOST_CHECK_EQUAL(d.exceptions, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(testResult) {
+	const InstrumentationCounters begin = instrumentation_of<TestResult>();
+
+	TestResult r = Succeeded();
+	TestResult copied(r);
+	TestResult moved(std::move(copied));
+	moved = r;
+	const TestResult f = Failed();
+	BOOST_CHECK_THROW(*f, TestResult::CantDereference);
+	BOOST_CHECK_THROW(r.fail(), TestResult::NotHaveFailedObject);
+
+	const InstrumentationCounters d = difference(instrumentation_of<TestResult>(), begin);
+	BOOST_CHECK_EQUAL(d.clones, 1u);
+	BOOST_CHECK_EQUAL(d.moves, 1u);
+	BOOST_CHECK_EQUAL(d.assignments, 1u);
+	BOOST_CHECK_EQUAL(d.exceptions, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(testThreads) {
+	const InstrumentationCounters begin = instrumentation_of<Shared>();
+
+	static const int threadCount = 4;
+	static const int copies = 100;
+	DeepCopyPtr<Shared> p(new Shared());
+	std::vector<std::thread> threads;
+	for(int i = 0; i < threadCount; ++i) {
+		threads.push_back(std::thread([&p]() {
+			for(int j = 0; j < copies; ++j) DeepCopyPtr<Shared> q(p);
+		}));
+	}
+	for(int i = 0; i < threadCount; ++i) threads[i].join();
+
+	// 終了したスレッドの計測値も集計に含まれる
+	const InstrumentationCounters d = difference(instrumentation_of<Shared>(), begin);
+	BOOST_CHECK_EQUAL(d.clones, static_cast<std::uint64_t>(threadCount * copies));
+	BOOST_CHECK_EQUAL(d.allocations, static_cast<std::uint64_t>(threadCount * copies));
+}
+
+BOOST_AUTO_TEST_CASE(testSnapshot) {
+	DeepCopyPtr<Heavy> p(new Heavy());
+	DeepCopyPtr<Heavy> q(p);
+
+	const std::vector<aslib::InstrumentationRecord> records = aslib::instrumentation_snapshot();
+	bool found = false;
+	for(std::size_t i = 0; i < records.size(); ++i) {
+		if(records[i].type && *records[i].type == typeid(Heavy)) found = (records[i].counters.clones > 0);
+	}
+	BOOST_CHECK(found);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,219 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <aslib/NeverEmptyResult.hpp>
+
+using aslib::NeverEmptyResult;
+using aslib::Result;
+
+namespace {
+	enum ParseError { noInput, badSyntax };
+
+	typedef NeverEmptyResult<int, ParseError> Parsed;
+
+	// Resultと同じレイアウトで、自明にコピー出来る
+	static_assert(sizeof(Parsed) == sizeof(Result<int, ParseError>), "NeverEmptyResult must have the same layout as Result.");
+	static_assert(std::is_trivially_copyable<Parsed>::value, "NeverEmptyResult of trivially copyable types must be trivially copyable.");
+	static_assert(!std::is_trivially_copyable<NeverEmptyResult<std::string, ParseError> >::value, "NeverEmptyResult of std::string must not be trivially copyable.");
+	// 既定のコンストラクタはエラー値の型に依る
+	static_assert(std::is_default_constructible<Parsed>::value, "ParseError is default constructible.");
+	static_assert(!std::is_default_constructible<NeverEmptyResult<int, std::runtime_error> >::value, "std::runtime_error is not default constructible.");
+
+	// 生存期間中のオブジェクトの数を数え、指定した値からの構築で例外を送出する
+	struct Tracked {
+		Tracked(int *alive, int value = 0) : alive_(alive), value_(value) {
+			if(value < 0) throw std::invalid_argument("Tracked");
+			++*alive_;
+		}
+		Tracked(const Tracked &src) : alive_(src.alive_), value_(src.value_) { ++*alive_; }
+		Tracked(Tracked &&src) noexcept : alive_(src.alive_), value_(src.value_) { ++*alive_; }
+		Tracked &operator=(const Tracked &rhs) { value_ = rhs.value_; return *this; }
+		~Tracked() { --*alive_; }
+		int *alive_;
+		int value_;
+	};
+
+	// 構築と破棄の回数を数えるエラー値
+	int errorsConstructed = 0, errorsDestroyed = 0;
+	struct CountedError {
+		CountedError() { ++errorsConstructed; }
+		CountedError(const CountedError &) { ++errorsConstructed; }
+		CountedError(CountedError &&) noexcept { ++errorsConstructed; }
+		CountedError &operator=(const CountedError &) = default;
+		~CountedError() { ++errorsDestroyed; }
+	};
+	// コピーで例外を送出する正常値
+	struct CopyThrows {
+		CopyThrows() {}
+		CopyThrows(const CopyThrows &) { throw std::runtime_error("CopyThrows"); }
+		CopyThrows(CopyThrows &&) noexcept {}
+		CopyThrows &operator=(const CopyThrows &) = default;
+	};
+
+	Parsed parse(const std::string &text) {
+		if(text.empty()) return noInput;
+		if(text[0] < '0' || '9' < text[0]) return badSyntax;
+		return text[0] - '0';
+	}
+
+	Result<int, ParseError> parseResult(const std::string &text) { return parse(text); }
+
+	Parsed twice(const std::string &text) {
+		ASLIB_TRY_ASSIGN(const int value, parse(text));
+		return value * 2;
+	}
+	Parsed twiceResult(const std::string &text) {
+		ASLIB_TRY_ASSIGN(const int value, parseResult(text));
+		return value * 2;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(NeverEmptyResultTest)
+
+BOOST_AUTO_TEST_CASE(testConstruct) {
+	// 既定値のエラー値を保持する
+	const Parsed d;
+	BOOST_CHECK(!d);
+	BOOST_CHECK_EQUAL(d.fail(), noInput);
+
+	const Parsed s = parse("3");
+	BOOST_CHECK(static_cast<bool>(s));
+	BOOST_CHECK_EQUAL(*s, 3);
+	BOOST_CHECK(s.fail_if() == nullptr);
+	BOOST_CHECK_THROW(s.fail(), Parsed::NotHaveFailedObject);
+
+	const Parsed f = parse("x");
+	BOOST_CHECK(f.get_if() == nullptr);
+	BOOST_CHECK_EQUAL(f.unchecked_fail(), badSyntax);
+	BOOST_CHECK_EQUAL(f.value_or(-1), -1);
+	BOOST_CHECK_THROW(*f, Parsed::CantDereference);
+
+	const NeverEmptyResult<std::string, ParseError> inPlace(aslib::in_place_success, 3, 'a');
+	BOOST_CHECK_EQUAL(*inPlace, "aaa");
+	BOOST_CHECK_EQUAL(inPlace->size(), 3u);
+	BOOST_CHECK_EQUAL((NeverEmptyResult<std::string, ParseError>(aslib::in_place_failure, badSyntax).fail()), badSyntax);
+}
+
+BOOST_AUTO_TEST_CASE(testCopyAndAssign) {
+	int alive = 0;
+	{
+		typedef NeverEmptyResult<Tracked, ParseError> Tracking;
+		Tracking a(Tracked(&alive, 1));
+		BOOST_CHECK_EQUAL(alive, 1);
+		Tracking b(a);
+		BOOST_CHECK_EQUAL(alive, 2);
+
+		b = badSyntax;
+		BOOST_CHECK_EQUAL(alive, 1);
+		b = a;
+		BOOST_CHECK_EQUAL(alive, 2);
+		BOOST_CHECK_EQUAL(b->value_, 1);
+		b = Tracked(&alive, 2);
+		BOOST_CHECK_EQUAL(b->value_, 2);
+
+		Tracking c(std::move(b));
+		BOOST_CHECK_EQUAL(alive, 3);
+		c = Tracking();
+		BOOST_CHECK_EQUAL(alive, 2);
+		BOOST_CHECK_EQUAL(c.fail(), noInput);
+
+		c.emplace_success(&alive, 4);
+		BOOST_CHECK_EQUAL(c->value_, 4);
+		BOOST_CHECK_EQUAL(alive, 3);
+		c.emplace_failure(badSyntax);
+		BOOST_CHECK_EQUAL(alive, 2);
+	}
+	BOOST_CHECK_EQUAL(alive, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testStrongGuarantee) {
+	// 構築中に例外が発生しても、元の値を保持したままになる
+	int alive = 0;
+	{
+		NeverEmptyResult<Tracked, ParseError> r(badSyntax);
+		BOOST_CHECK_THROW(r.emplace_success(&alive, -1), std::invalid_argument);
+		BOOST_CHECK_EQUAL(r.fail(), badSyntax);
+
+		r.emplace_success(&alive, 1);
+		BOOST_CHECK_THROW(r.emplace_success(&alive, -1), std::invalid_argument);
+		BOOST_CHECK_EQUAL(r->value_, 1);
+		BOOST_CHECK_EQUAL(alive, 1);
+	}
+	BOOST_CHECK_EQUAL(alive, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testConstructionFailure) {
+	// 値の構築前・構築中に例外が発生しても、構築していない値は破棄しない
+	typedef NeverEmptyResult<CopyThrows, CountedError> Throwing;
+	errorsConstructed = errorsDestroyed = 0;
+	BOOST_CHECK_THROW(Throwing((Result<CopyThrows, CountedError>())), Throwing::EmptySource);
+	const Result<CopyThrows, CountedError> empty;
+	BOOST_CHECK_THROW(Throwing{empty}, Throwing::EmptySource);
+
+	const CopyThrows value;
+	BOOST_CHECK_THROW(Throwing{value}, std::runtime_error);
+	const Throwing succeeded(aslib::in_place_success);
+	BOOST_CHECK_THROW(Throwing{succeeded}, std::runtime_error);
+	BOOST_CHECK_EQUAL(errorsConstructed, 0);
+	BOOST_CHECK_EQUAL(errorsDestroyed, 0);
+
+	// エラー値は構築した数だけ破棄する
+	{
+		const Throwing failed(aslib::in_place_failure);
+		const Throwing copied(failed);
+		BOOST_CHECK(!copied);
+	}
+	BOOST_CHECK_EQUAL(errorsConstructed, 2);
+	BOOST_CHECK_EQUAL(errorsDestroyed, 2);
+}
+
+BOOST_AUTO_TEST_CASE(testCombinators) {
+	const auto half = [](int v) { return v / 2; };
+	BOOST_CHECK_EQUAL(*parse("8").map(half), 4);
+	BOOST_CHECK_EQUAL(parse("").map(half).fail(), noInput);
+	BOOST_CHECK_EQUAL(*parse("8").and_then([](int v) { return Parsed(v + 1); }), 9);
+	BOOST_CHECK_EQUAL(*parse("x").or_else([](ParseError) { return Parsed(0); }), 0);
+	BOOST_CHECK_EQUAL(parse("x").map_error([](ParseError e) { return static_cast<long>(e) + 10; }).fail(), 11L);
+
+	// 右辺値は値をムーブして渡す
+	NeverEmptyResult<std::string, ParseError> str(std::string("moved"));
+	const NeverEmptyResult<std::size_t, ParseError> size = std::move(str).map([](std::string &&s) { const std::string taken(std::move(s)); return taken.size(); });
+	BOOST_CHECK_EQUAL(*size, 5u);
+	BOOST_CHECK(str->empty());
+}
+
+BOOST_AUTO_TEST_CASE(testResultConversion) {
+	const Result<int, ParseError> fromNeverEmpty = parse("5");
+	BOOST_CHECK_EQUAL(*fromNeverEmpty, 5);
+	BOOST_CHECK_EQUAL(Parsed(Result<int, ParseError>(badSyntax)).fail(), badSyntax);
+	BOOST_CHECK_EQUAL(*Parsed(fromNeverEmpty), 5);
+	BOOST_CHECK_THROW(Parsed(Result<int, ParseError>()), Parsed::EmptySource);
+}
+
+BOOST_AUTO_TEST_CASE(testTry) {
+	BOOST_CHECK_EQUAL(*twice("4"), 8);
+	BOOST_CHECK_EQUAL(twice("").fail(), noInput);
+	BOOST_CHECK_EQUAL(*twiceResult("4"), 8);
+	BOOST_CHECK_EQUAL(twiceResult("x").fail(), badSyntax);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#if ASLIB_HAS_CONSTEXPR_RESULT
+namespace {
+	constexpr NeverEmptyResult<std::string, ParseError> label(int value) {
+		NeverEmptyResult<std::string, ParseError> r;
+		if(value < 0) return r;
+		r = std::string(static_cast<std::size_t>(value), 'x');
+		return r;
+	}
+
+	// 種類の変わる代入と、自明でない破棄を定数式中で行う
+	static_assert(label(3)->size() == 3, "");
+	static_assert(label(-1).fail() == noInput, "");
+}
+#endif
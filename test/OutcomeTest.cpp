@@ -0,0 +1,192 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <aslib/Outcome.hpp>
+
+using aslib::Outcome;
+
+namespace {
+	enum ProtocolError { badHeader, badLength };
+	struct IoError { int code; };
+	struct Pending {};
+
+	typedef Outcome<int, ProtocolError, IoError, Pending> Decoded;
+
+	// 入れ子のResultより小さく、自明にコピー出来る
+	static_assert(sizeof(Decoded) == 8, "Outcome stores a one-byte discriminant next to the largest alternative.");
+	static_assert(sizeof(Decoded) < sizeof(aslib::Result<int, aslib::Result<ProtocolError, aslib::Result<IoError, Pending> > >), "Outcome must be smaller than nested Results.");
+	static_assert(std::is_trivially_copyable<Decoded>::value, "Outcome of trivially copyable types must be trivially copyable.");
+	static_assert(!std::is_trivially_copyable<Outcome<std::string, int> >::value, "Outcome of std::string must not be trivially copyable.");
+
+	// 生存期間中のオブジェクトの数を数える
+	struct Tracked {
+		Tracked(int *alive, int value = 0) : alive_(alive), value_(value) { ++*alive_; }
+		Tracked(const Tracked &src) : alive_(src.alive_), value_(src.value_) { ++*alive_; }
+		Tracked &operator=(const Tracked &rhs) { value_ = rhs.value_; return *this; }
+		~Tracked() { --*alive_; }
+		int *alive_;
+		int value_;
+	};
+	struct Other {
+		Other(int *alive) : tracked_(alive) {}
+		Tracked tracked_;
+	};
+
+	// 保持している値の種類を文字列で返す
+	struct Describe {
+		std::string operator()(int v) const { return "int:" + std::to_string(v); }
+		std::string operator()(ProtocolError e) const { return "protocol:" + std::to_string(static_cast<int>(e)); }
+		std::string operator()(const IoError &e) const { return "io:" + std::to_string(e.code); }
+		std::string operator()(Pending) const { return "pending"; }
+	};
+
+	// 正常値のみを書き換える
+	struct Increment {
+		void operator()(int &v) const { ++v; }
+		template<typename T>
+		void operator()(T &) const { BOOST_ERROR("A failure must not be visited."); }
+	};
+
+	// 保持している値をムーブして取り出す
+	struct Take {
+		std::string operator()(std::string &&s) const { return std::move(s); }
+		std::string operator()(int &&) const { return "int"; }
+	};
+
+	Decoded decode(int input) {
+		if(input < 0) return badLength;
+		if(input == 0) return Pending();
+		if(input > 100) return IoError{input};
+		return input;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(OutcomeTest)
+
+BOOST_AUTO_TEST_CASE(testConstruct) {
+	const Decoded s = decode(1);
+	BOOST_CHECK(static_cast<bool>(s));
+	BOOST_CHECK_EQUAL(s.index(), 0u);
+	BOOST_CHECK_EQUAL(*s, 1);
+	BOOST_CHECK(s.holds<int>());
+
+	const Decoded f = decode(-1);
+	BOOST_CHECK(!f);
+	BOOST_CHECK_EQUAL(f.index(), 1u);
+	BOOST_CHECK_EQUAL(f.fail(), badLength);
+	BOOST_CHECK(f.fail_if<IoError>() == nullptr);
+
+	const Decoded io = decode(200);
+	BOOST_CHECK_EQUAL(io.index(), 2u);
+	BOOST_CHECK_EQUAL(io.fail<IoError>().code, 200);
+	BOOST_CHECK(decode(0).holds<Pending>());
+
+	const Decoded u;
+	BOOST_CHECK_EQUAL(u.index(), Decoded::npos);
+	BOOST_CHECK(!u);
+	BOOST_CHECK(u.fail_if() == nullptr);
+
+	const Decoded inPlace(aslib::InPlaceTypeTag<IoError>(), IoError{3});
+	BOOST_CHECK_EQUAL(inPlace.unchecked_fail<IoError>().code, 3);
+	BOOST_CHECK_EQUAL(*Decoded(aslib::in_place_success, 4), 4);
+}
+
+BOOST_AUTO_TEST_CASE(testAccess) {
+	Decoded s = decode(1);
+	*s = 2;
+	BOOST_CHECK_EQUAL(s.unchecked_value(), 2);
+	BOOST_CHECK_EQUAL(*s.get_if(), 2);
+	BOOST_CHECK_EQUAL(s.value_or(0), 2);
+	BOOST_CHECK_THROW(s.fail(), Decoded::NotHaveFailedObject);
+
+	const Decoded f = decode(-1);
+	BOOST_CHECK(f.get_if() == nullptr);
+	BOOST_CHECK_EQUAL(f.value_or(9), 9);
+	BOOST_CHECK_THROW(*f, Decoded::CantDereference);
+	BOOST_CHECK_THROW(f.fail<Pending>(), Decoded::NotHaveFailedObject);
+}
+
+BOOST_AUTO_TEST_CASE(testVisit) {
+	BOOST_CHECK_EQUAL(decode(5).visit(Describe()), "int:5");
+	BOOST_CHECK_EQUAL(decode(-1).visit(Describe()), "protocol:1");
+	BOOST_CHECK_EQUAL(decode(300).visit(Describe()), "io:300");
+	BOOST_CHECK_EQUAL(decode(0).visit(Describe()), "pending");
+	BOOST_CHECK_THROW(Decoded().visit(Describe()), Decoded::CantVisit);
+
+	// 左辺値は参照を渡す
+	Decoded s = decode(5);
+	s.visit(Increment());
+	BOOST_CHECK_EQUAL(*s, 6);
+
+	// 右辺値はムーブして渡す
+	Outcome<std::string, int> str(std::string("moved"));
+	BOOST_CHECK_EQUAL(std::move(str).visit(Take()), "moved");
+	BOOST_CHECK(str.get_if()->empty());
+}
+
+BOOST_AUTO_TEST_CASE(testCopyAndAssign) {
+	int alive = 0;
+	{
+		typedef Outcome<Tracked, Other, int> Tracking;
+		Tracking a(Tracked(&alive, 1));
+		BOOST_CHECK_EQUAL(alive, 1);
+
+		// 同じ種類ならば代入, 異なる種類ならば破棄して構築する
+		Tracking b(a);
+		BOOST_CHECK_EQUAL(alive, 2);
+		b = Tracked(&alive, 2);
+		BOOST_CHECK_EQUAL(alive, 2);
+		BOOST_CHECK_EQUAL(b->value_, 2);
+		b = Other(&alive);
+		BOOST_CHECK_EQUAL(alive, 2);
+		BOOST_CHECK(b.holds<Other>());
+		b = 3;
+		BOOST_CHECK_EQUAL(alive, 1);
+		BOOST_CHECK_EQUAL(b.fail<int>(), 3);
+
+		b = a;
+		BOOST_CHECK_EQUAL(alive, 2);
+		BOOST_CHECK_EQUAL(b->value_, 1);
+		Tracking c(std::move(b));
+		BOOST_CHECK_EQUAL(alive, 3);
+		c = Tracking();
+		BOOST_CHECK_EQUAL(alive, 2);
+		BOOST_CHECK_EQUAL(c.index(), Tracking::npos);
+
+		c.emplace_failure<Other>(&alive);
+		BOOST_CHECK_EQUAL(alive, 3);
+		c.emplace_success(&alive, 4);
+		BOOST_CHECK_EQUAL(c->value_, 4);
+		BOOST_CHECK_EQUAL(alive, 3);
+	}
+	BOOST_CHECK_EQUAL(alive, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testSingleFailure) {
+	// エラー値の型が1つならば、Resultと同じメンバ関数で扱える
+	Outcome<std::string, ProtocolError> r = badHeader;
+	BOOST_CHECK_EQUAL(r.fail(), badHeader);
+	BOOST_CHECK(r.fail_if() != nullptr);
+	r.emplace_failure(badLength);
+	BOOST_CHECK_EQUAL(r.unchecked_fail(), badLength);
+	r = std::string("ok");
+	BOOST_CHECK_EQUAL(*r, "ok");
+	BOOST_CHECK_EQUAL(r->size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(testFromResult) {
+	const aslib::Result<int, IoError> io = IoError{7};
+	const Decoded fromIo(io);
+	BOOST_CHECK_EQUAL(fromIo.fail<IoError>().code, 7);
+
+	const Decoded fromValue(aslib::Result<int, Pending>(8));
+	BOOST_CHECK_EQUAL(*fromValue, 8);
+
+	const Decoded fromUninit = aslib::Result<int, Pending>();
+	BOOST_CHECK_EQUAL(fromUninit.index(), Decoded::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,245 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+
+#include <aslib/PolyVector.hpp>
+
+using aslib::PolyVector;
+
+namespace {
+	struct Shape {
+		virtual ~Shape() {}
+		virtual int area() const = 0;
+	};
+	struct Square : Shape {
+		Square(int side) : side_(side) {}
+		int area() const { return side_ * side_; }
+		int side_;
+	};
+	struct Rect : Shape {
+		Rect(int w, int h) : w_(w), h_(h) {}
+		int area() const { return w_ * h_; }
+		int w_, h_;
+	};
+	// 例外を送出し得るムーブ(=コピー)しか持たず、生存数を記録するクラス
+	struct Named : Shape {
+		Named(int *alive, const std::string &name) : alive_(alive), name_(name) { ++*alive_; }
+		Named(const Named &src) : alive_(src.alive_), name_(src.name_) {
+			if(name_ == "throw") throw std::runtime_error("copy");
+			++*alive_;
+		}
+		~Named() { --*alive_; }
+		int area() const { return static_cast<int>(name_.size()); }
+		int *alive_;
+		std::string name_;
+	};
+
+	// 自明にコピー出来る型
+	struct Point {
+		int x, y;
+	};
+	struct Point3 : Point {
+		int z;
+	};
+}
+
+BOOST_AUTO_TEST_SUITE(PolyVectorTest)
+	BOOST_AUTO_TEST_CASE(testEmpty) {
+		PolyVector<Shape> v;
+		BOOST_CHECK(v.empty());
+		BOOST_CHECK_EQUAL(v.size(), 0u);
+		BOOST_CHECK(v.begin() == v.end());
+		PolyVector<Shape> copied(v);
+		BOOST_CHECK(copied.empty());
+	}
+
+	BOOST_AUTO_TEST_CASE(testEmplace) {
+		PolyVector<Shape> v;
+		v.emplace_back<Square>(2);
+		v.emplace_back<Rect>(2, 3);
+		v.push_back(Square(4));
+		BOOST_REQUIRE_EQUAL(v.size(), 3u);
+		BOOST_CHECK_EQUAL(v[0].area(), 4);
+		BOOST_CHECK_EQUAL(v[1].area(), 6);
+		BOOST_CHECK_EQUAL(v.back().area(), 16);
+		BOOST_CHECK(typeid(v[1]) == typeid(Rect));
+	}
+
+	BOOST_AUTO_TEST_CASE(testContiguous) {
+		PolyVector<Shape> v;
+		for(int i = 0; i < 100; ++i) {
+			if(i % 2) v.emplace_back<Square>(i);
+			else v.emplace_back<Rect>(i, 1);
+		}
+		// 要素は追加した順に、1つの領域内に並ぶ
+		const char *first = reinterpret_cast<const char *>(&v.front());
+		const char *prev = first;
+		for(std::size_t i = 1; i < v.size(); ++i) {
+			const char *p = reinterpret_cast<const char *>(&v[i]);
+			BOOST_CHECK(prev < p);
+			prev = p;
+		}
+		BOOST_CHECK(prev < first + v.bytes());
+
+		int sum = 0, expected = 0;
+		for(PolyVector<Shape>::const_iterator it = v.begin(); it != v.end(); ++it) sum += it->area();
+		for(int i = 0; i < 100; ++i) expected += (i % 2) ? i * i : i;
+		BOOST_CHECK_EQUAL(sum, expected);
+		BOOST_CHECK_EQUAL(v.end() - v.begin(), 100);
+	}
+
+	BOOST_AUTO_TEST_CASE(testCopy) {
+		int alive = 0;
+		{
+			PolyVector<Shape> v;
+			v.emplace_back<Square>(3);
+			v.emplace_back<Named>(&alive, "abc");
+			PolyVector<Shape> copied(v);
+			BOOST_CHECK_EQUAL(alive, 2);
+			BOOST_REQUIRE_EQUAL(copied.size(), 2u);
+			BOOST_CHECK_NE(&copied[0], &v[0]);
+			BOOST_CHECK(typeid(copied[1]) == typeid(Named));	// スライシングされない
+			BOOST_CHECK_EQUAL(copied[1].area(), 3);
+
+			PolyVector<Shape> assigned;
+			assigned = copied;
+			BOOST_CHECK_EQUAL(alive, 3);
+			PolyVector<Shape> moved(std::move(assigned));
+			BOOST_CHECK(assigned.empty());
+			BOOST_CHECK_EQUAL(alive, 3);
+		}
+		BOOST_CHECK_EQUAL(alive, 0);
+	}
+
+	BOOST_AUTO_TEST_CASE(testCopy_trivial) {
+		PolyVector<Point> v;
+		Point p = { 1, 2 };
+		Point3 q;
+		q.x = 3; q.y = 4; q.z = 5;
+		v.push_back(p);
+		v.push_back(q);
+		PolyVector<Point> copied(v);
+		BOOST_CHECK_EQUAL(copied[0].y, 2);
+		BOOST_CHECK_EQUAL(static_cast<const Point3 &>(copied[1]).z, 5);
+
+		// 自明にコピー出来る要素も、Baseの参照から動的な型のままコピーする
+		copied.push_back(copied[1]);
+		BOOST_CHECK_EQUAL(static_cast<const Point3 &>(copied[2]).z, 5);
+	}
+
+	BOOST_AUTO_TEST_CASE(testCopy_throw) {
+		int alive = 0;
+		{
+			PolyVector<Shape> v;
+			v.emplace_back<Named>(&alive, "a");
+			v.emplace_back<Named>(&alive, "throw");
+			BOOST_CHECK_THROW(PolyVector<Shape> copied(v), std::runtime_error);
+			BOOST_CHECK_EQUAL(alive, 2);	// 途中までのコピーは破棄される
+		}
+		BOOST_CHECK_EQUAL(alive, 0);
+	}
+
+	BOOST_AUTO_TEST_CASE(testGrow) {
+		int alive = 0;
+		{
+			PolyVector<Shape> v;
+			for(int i = 0; i < 50; ++i) {
+				v.emplace_back<Named>(&alive, std::string(i % 7 + 1, 'x'));
+				v.emplace_back<Square>(i);
+			}
+			BOOST_CHECK_EQUAL(alive, 50);
+			for(int i = 0; i < 50; ++i) {
+				BOOST_CHECK_EQUAL(v[2 * i].area(), i % 7 + 1);
+				BOOST_CHECK_EQUAL(v[2 * i + 1].area(), i * i);
+			}
+		}
+		BOOST_CHECK_EQUAL(alive, 0);
+	}
+
+	BOOST_AUTO_TEST_CASE(testGrow_throw) {
+		int alive = 0;
+		{
+			PolyVector<Shape> v;
+			v.reserve_bytes(sizeof(Named) + sizeof(Square) + 16);
+			v.emplace_back<Named>(&alive, "throw");
+			v.emplace_back<Square>(2);
+			// 拡張中にコピーが失敗しても、元の要素は変わらない
+			BOOST_CHECK_THROW(v.reserve_bytes(v.bytes() * 4), std::runtime_error);
+			BOOST_CHECK_EQUAL(v.size(), 2u);
+			BOOST_CHECK_EQUAL(v[0].area(), 5);
+			BOOST_CHECK_EQUAL(v[1].area(), 4);
+			BOOST_CHECK_EQUAL(alive, 1);
+		}
+		BOOST_CHECK_EQUAL(alive, 0);
+	}
+
+	BOOST_AUTO_TEST_CASE(testGrow_selfReference) {
+		// 拡張を伴う追加でも、既存の要素を引数に渡せる
+		int alive = 0;
+		{
+			PolyVector<Shape> v;
+			v.emplace_back<Rect>(4, 10);
+			for(int i = 0; i < 8; ++i) {
+				v.push_back(static_cast<const Rect &>(v[0]));
+				v.emplace_back<Rect>(static_cast<const Rect &>(v[0]).w_, static_cast<const Rect &>(v[0]).h_);
+			}
+			for(std::size_t i = 0; i < v.size(); ++i) BOOST_CHECK_EQUAL(v[i].area(), 40);
+
+			PolyVector<Shape> n;
+			n.emplace_back<Named>(&alive, "abc");
+			for(int i = 0; i < 8; ++i) n.push_back(static_cast<const Named &>(n.back()));
+			for(std::size_t i = 0; i < n.size(); ++i) BOOST_CHECK_EQUAL(n[i].area(), 3);
+			BOOST_CHECK_EQUAL(alive, 9);
+		}
+		BOOST_CHECK_EQUAL(alive, 0);
+	}
+
+	BOOST_AUTO_TEST_CASE(testPushBack_dynamicType) {
+		// 要素はBaseの参照から追加しても、その動的な型のままコピーする
+		int alive = 0;
+		{
+			PolyVector<Shape> v;
+			v.emplace_back<Square>(3);
+			v.emplace_back<Named>(&alive, "abcd");
+			for(int i = 0; i < 4; ++i) v.push_back(v[0]);
+			const Shape &named = v[1];
+			v.push_back(named);
+			BOOST_REQUIRE_EQUAL(v.size(), 7u);
+			for(std::size_t i = 2; i < 6; ++i) {
+				BOOST_CHECK(typeid(v[i]) == typeid(Square));
+				BOOST_CHECK_EQUAL(v[i].area(), 9);
+			}
+			BOOST_CHECK(typeid(v.back()) == typeid(Named));
+			BOOST_CHECK_EQUAL(v.back().area(), 4);
+			BOOST_CHECK_EQUAL(alive, 2);
+
+			// 要素ではないBaseの参照は、動的な型が分からない
+			const Square outside(5);
+			const Shape &base = outside;
+			BOOST_CHECK_THROW(v.push_back(base), PolyVector<Shape>::UnknownDynamicType);
+			BOOST_CHECK_EQUAL(v.size(), 7u);
+			v.push_back(outside);
+			BOOST_CHECK_EQUAL(v.back().area(), 25);
+		}
+		BOOST_CHECK_EQUAL(alive, 0);
+	}
+
+	BOOST_AUTO_TEST_CASE(testPopBackAndClear) {
+		int alive = 0;
+		PolyVector<Shape> v;
+		v.emplace_back<Square>(1);
+		v.emplace_back<Named>(&alive, "ab");
+		v.pop_back();
+		BOOST_CHECK_EQUAL(alive, 0);
+		BOOST_CHECK_EQUAL(v.size(), 1u);
+		v.emplace_back<Rect>(2, 5);
+		BOOST_CHECK_EQUAL(v.back().area(), 10);
+
+		v.emplace_back<Named>(&alive, "cd");
+		v.clear();
+		BOOST_CHECK(v.empty());
+		BOOST_CHECK_EQUAL(alive, 0);
+	}
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,153 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <aslib/ResultAlgorithm.hpp>
+
+using aslib::Result;
+
+namespace {
+	typedef Result<int, std::string> R;
+	typedef Result<std::unique_ptr<int>, std::string> MoveOnlyR;
+
+	/// 入力イテレータとしてのみ振る舞うイテレータ.
+	struct InputIterator {
+		typedef std::input_iterator_tag iterator_category;
+		typedef R value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const R *pointer;
+		typedef const R &reference;
+
+		explicit InputIterator(std::vector<R>::const_iterator it) : it_(it) {}
+		reference operator*() const { return *it_; }
+		InputIterator &operator++() { ++it_; return *this; }
+		bool operator!=(const InputIterator &rhs) const { return it_ != rhs.it_; }
+		std::vector<R>::const_iterator it_;
+	};
+
+	std::vector<MoveOnlyR> makeMoveOnly(std::size_t n, std::size_t failAt) {
+		std::vector<MoveOnlyR> results;
+		for(std::size_t i = 0; i < n; ++i) {
+			if(i == failAt) results.push_back(MoveOnlyR(std::string("failed")));
+			else results.push_back(MoveOnlyR(std::unique_ptr<int>(new int(static_cast<int>(i)))));
+		}
+		return results;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(CollectTest)
+	BOOST_AUTO_TEST_CASE(testAllSucceeded) {
+		std::vector<R> results;
+		for(int i = 0; i < 10; ++i) results.push_back(i);
+
+		Result<std::vector<int>, std::string> collected = aslib::collect(results.begin(), results.end());
+		BOOST_REQUIRE(static_cast<bool>(collected));
+		BOOST_CHECK_EQUAL(collected->size(), 10u);
+		BOOST_CHECK_EQUAL(collected->capacity(), 10u);	// 領域確保は1度のみ
+		BOOST_CHECK_EQUAL((*collected)[9], 9);
+	}
+
+	BOOST_AUTO_TEST_CASE(testFirstFailure) {
+		std::vector<R> results;
+		results.push_back(1);
+		results.push_back(std::string("first"));
+		results.push_back(std::string("second"));
+		Result<std::vector<int>, std::string> collected = aslib::collect(results.begin(), results.end());
+		BOOST_CHECK(!static_cast<bool>(collected));
+		BOOST_CHECK_EQUAL(collected.fail(), "first");
+
+		results.insert(results.begin(), R());
+		BOOST_CHECK(aslib::collect(results.begin(), results.end()).fail_if() == nullptr);	// 未初期化はそのまま伝わる
+	}
+
+	BOOST_AUTO_TEST_CASE(testMove) {
+		std::vector<MoveOnlyR> results = makeMoveOnly(10, 10);
+		Result<std::vector<std::unique_ptr<int> >, std::string> collected = aslib::collect(std::move(results));
+		BOOST_REQUIRE(static_cast<bool>(collected));
+		BOOST_CHECK_EQUAL(*(*collected)[3], 3);
+	}
+
+	BOOST_AUTO_TEST_CASE(testShortCircuit) {
+		std::vector<MoveOnlyR> results = makeMoveOnly(10, 4);
+		Result<std::vector<std::unique_ptr<int> >, std::string> collected = aslib::collect(std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
+		BOOST_CHECK_EQUAL(collected.fail(), "failed");
+		BOOST_CHECK(!*results[0]);	// ムーブされた
+		BOOST_CHECK(static_cast<bool>(*results[5]));	// 最初のエラー値以降は走査しない
+	}
+
+	BOOST_AUTO_TEST_CASE(testInputIterator) {
+		std::vector<R> results(3, R(1));
+		Result<std::vector<int>, std::string> collected = aslib::collect(InputIterator(results.begin()), InputIterator(results.end()));
+		BOOST_REQUIRE(static_cast<bool>(collected));
+		BOOST_CHECK_EQUAL(collected->size(), 3u);
+	}
+BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_SUITE(PartitionResultsTest)
+	BOOST_AUTO_TEST_CASE(testPartition) {
+		std::vector<R> results;
+		for(int i = 0; i < 10; ++i) {
+			if(i % 4 == 0) results.push_back(std::to_string(i));
+			else results.push_back(i);
+		}
+		results.push_back(R());
+
+		std::pair<std::vector<int>, std::vector<std::string> > p = aslib::partition_results(results.begin(), results.end());
+		BOOST_CHECK_EQUAL(p.first.size(), 7u);
+		BOOST_CHECK_EQUAL(p.first.capacity(), 7u);
+		BOOST_CHECK_EQUAL(p.first[0], 1);
+		BOOST_CHECK_EQUAL(p.first[6], 9);
+		BOOST_REQUIRE_EQUAL(p.second.size(), 3u);
+		BOOST_CHECK_EQUAL(p.second.capacity(), 3u);
+		BOOST_CHECK_EQUAL(p.second[2], "8");
+	}
+
+	BOOST_AUTO_TEST_CASE(testMove) {
+		std::pair<std::vector<std::unique_ptr<int> >, std::vector<std::string> > p = aslib::partition_results(makeMoveOnly(5, 2));
+		BOOST_CHECK_EQUAL(p.first.size(), 4u);
+		BOOST_CHECK_EQUAL(*p.first[2], 3);
+		BOOST_CHECK_EQUAL(p.second.at(0), "failed");
+	}
+BOOST_AUTO_TEST_SUITE_END();
+
+#if ASLIB_HAS_PARALLEL_ALGORITHMS
+BOOST_AUTO_TEST_SUITE(ParallelResultAlgorithmTest)
+	BOOST_AUTO_TEST_CASE(testCollect) {
+		std::vector<R> results;
+		for(int i = 0; i < 10000; ++i) results.push_back(i);
+		Result<std::vector<int>, std::string> collected = aslib::collect(std::execution::par, results.begin(), results.end());
+		BOOST_REQUIRE(static_cast<bool>(collected));
+		BOOST_CHECK_EQUAL(collected->size(), 10000u);
+		BOOST_CHECK_EQUAL((*collected)[9999], 9999);
+
+		results[7000] = std::string("late");
+		results[3000] = std::string("early");
+		collected = aslib::collect(std::execution::par, results.begin(), results.end());
+		BOOST_CHECK_EQUAL(collected.fail(), "early");	// 並列でも最初のエラー値を返す
+	}
+
+	BOOST_AUTO_TEST_CASE(testCollect_move) {
+		std::vector<MoveOnlyR> results = makeMoveOnly(1000, 1000);
+		Result<std::vector<std::unique_ptr<int> >, std::string> collected = aslib::collect(std::execution::par, std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
+		BOOST_REQUIRE(static_cast<bool>(collected));
+		BOOST_CHECK_EQUAL(*(*collected)[999], 999);
+		BOOST_CHECK(!*results[999]);
+	}
+
+	BOOST_AUTO_TEST_CASE(testPartition) {
+		std::vector<R> results;
+		for(int i = 0; i < 10000; ++i) {
+			if(i % 10 == 0) results.push_back(std::to_string(i));
+			else results.push_back(i);
+		}
+		std::pair<std::vector<int>, std::vector<std::string> > p = aslib::partition_results(std::execution::par, results.begin(), results.end());
+		BOOST_CHECK_EQUAL(p.first.size(), 9000u);
+		BOOST_CHECK_EQUAL(p.first.capacity(), 9000u);
+		BOOST_CHECK_EQUAL(p.second.size(), 1000u);
+		BOOST_CHECK_EQUAL(p.second[999], "9990");
+	}
+BOOST_AUTO_TEST_SUITE_END();
+#endif
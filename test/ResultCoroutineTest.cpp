@@ -0,0 +1,131 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+
+#include <aslib/ResultCoroutine.hpp>
+
+#if ASLIB_HAS_COROUTINE
+using aslib::Result;
+
+namespace {
+	enum ErrorCode { noError, someError, otherError };
+
+	// コピーとムーブの回数を数えるエラー値
+	struct Counted {
+		Counted(int *copies, int *moves) : copies_(copies), moves_(moves) {}
+		Counted(const Counted &src) : copies_(src.copies_), moves_(src.moves_) { ++*copies_; }
+		Counted(Counted &&src) : copies_(src.copies_), moves_(src.moves_) { ++*moves_; }
+		Counted &operator=(const Counted &) = default;
+		Counted &operator=(Counted &&) = default;
+		int *copies_;
+		int *moves_;
+	};
+
+	// 生存期間中のオブジェクトの数を数える
+	struct Tracked {
+		Tracked(int *alive) : alive_(alive) { ++*alive_; }
+		Tracked(const Tracked &src) : alive_(src.alive_) { ++*alive_; }
+		~Tracked() { --*alive_; }
+		int *alive_;
+	};
+
+	Result<int, ErrorCode> parse(int v) {
+		if(v < 0) return someError;
+		return v;
+	}
+
+	Result<int, ErrorCode> sum(int a, int b) {
+		const int x = co_await parse(a);
+		const int y = co_await parse(b);
+		co_return x + y;
+	}
+
+	Result<void, ErrorCode> check(int v) {
+		co_await parse(v);
+		co_return;
+	}
+
+	Result<std::string, ErrorCode> describe(int v) {
+		co_await check(v);
+		co_return std::string(static_cast<std::size_t>(v), 'x');
+	}
+
+	Result<int, Counted> forward(int *copies, int *moves) {
+		co_await Result<int, Counted>(aslib::in_place_failure, copies, moves);
+		co_return 0;
+	}
+
+	Result<int, ErrorCode> holdLocal(int *alive, int v) {
+		Tracked t(alive);
+		const int x = co_await parse(v);
+		co_return x;
+	}
+
+	Result<int, ErrorCode> awaitNamed(const Result<int, ErrorCode> &r) {
+		const int x = co_await r;
+		co_return x * 2;
+	}
+
+	Result<int, ErrorCode> throwing() {
+		co_await parse(0);
+		throw std::runtime_error("throwing");
+	}
+
+	Result<int &, ErrorCode> refer(int &target, bool ok) {
+		if(!ok) co_return someError;
+		co_return target;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(ResultCoroutineTest)
+
+BOOST_AUTO_TEST_CASE(testSucceeded) {
+	Result<int, ErrorCode> r = sum(1, 2);
+	BOOST_REQUIRE(static_cast<bool>(r));
+	BOOST_CHECK_EQUAL(*r, 3);
+
+	BOOST_CHECK(static_cast<bool>(check(1)));
+	BOOST_CHECK_EQUAL(*describe(3), "xxx");
+	BOOST_CHECK_EQUAL(*awaitNamed(Result<int, ErrorCode>(4)), 8);
+}
+
+BOOST_AUTO_TEST_CASE(testFailed) {
+	BOOST_CHECK_EQUAL(sum(-1, 2).fail(), someError);
+	BOOST_CHECK_EQUAL(sum(1, -2).fail(), someError);
+	BOOST_CHECK_EQUAL(check(-1).fail(), someError);
+	BOOST_CHECK_EQUAL(describe(-1).fail(), someError);
+	BOOST_CHECK_EQUAL(awaitNamed(Result<int, ErrorCode>(otherError)).fail(), otherError);
+}
+
+BOOST_AUTO_TEST_CASE(testMoveFailure) {
+	// 一時オブジェクトのエラー値はコピーしない
+	int copies = 0, moves = 0;
+	Result<int, Counted> r = forward(&copies, &moves);
+	BOOST_CHECK(r.fail_if() != nullptr);
+	BOOST_CHECK_EQUAL(copies, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testDestroyLocals) {
+	// エラー値で抜けた場合も、コルーチン内のオブジェクトは破棄される
+	int alive = 0;
+	BOOST_CHECK_EQUAL(*holdLocal(&alive, 1), 1);
+	BOOST_CHECK_EQUAL(alive, 0);
+	BOOST_CHECK_EQUAL(holdLocal(&alive, -1).fail(), someError);
+	BOOST_CHECK_EQUAL(alive, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testException) {
+	BOOST_CHECK_THROW(throwing(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(testReference) {
+	int target = 5;
+	Result<int &, ErrorCode> r = refer(target, true);
+	BOOST_REQUIRE(static_cast<bool>(r));
+	BOOST_CHECK_EQUAL(&*r, &target);
+	BOOST_CHECK_EQUAL(refer(target, false).fail(), someError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
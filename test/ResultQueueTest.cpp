@@ -0,0 +1,180 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <aslib/ResultQueue.hpp>
+
+using aslib::Result;
+
+namespace {
+	enum ParseError { badRecord };
+
+	typedef aslib::ResultQueue<std::string, ParseError> Queue;
+	typedef Queue::ResultType Parsed;
+
+	// 生存期間中のオブジェクトの数を数える
+	struct Tracked {
+		Tracked(int *alive) : alive_(alive) { ++*alive_; }
+		Tracked(const Tracked &src) : alive_(src.alive_) { ++*alive_; }
+		Tracked(Tracked &&src) noexcept : alive_(src.alive_) { ++*alive_; }
+		Tracked &operator=(const Tracked &) = default;
+		~Tracked() { --*alive_; }
+		int *alive_;
+	};
+
+	// 指定した回数の代入の後に例外を送出する出力反復子
+	struct ThrowingOutput {
+		typedef std::output_iterator_tag iterator_category;
+		typedef void value_type;
+		typedef void difference_type;
+		typedef void pointer;
+		typedef void reference;
+
+		ThrowingOutput &operator*() { return *this; }
+		ThrowingOutput &operator++() { return *this; }
+		ThrowingOutput &operator=(Result<Tracked, ParseError> &&) {
+			if((*remaining)-- == 0) throw std::runtime_error("ThrowingOutput");
+			return *this;
+		}
+		int *remaining;
+	};
+}
+
+BOOST_AUTO_TEST_SUITE(ResultQueueTest)
+
+BOOST_AUTO_TEST_CASE(testPushPop) {
+	Queue queue(3);
+	BOOST_CHECK_EQUAL(queue.capacity(), 4u);
+
+	Parsed out;
+	BOOST_CHECK(!queue.try_pop(out));
+
+	// 先に追加した順に取り出す
+	BOOST_CHECK(queue.try_push(Parsed(std::string("a"))));
+	BOOST_CHECK(queue.try_push(Parsed(badRecord)));
+	const Parsed c(std::string("c"));
+	BOOST_CHECK(queue.try_push(c));
+	BOOST_CHECK_EQUAL(*c, "c");
+	BOOST_CHECK(queue.try_push(Parsed(std::string("d"))));
+
+	// 満杯ならば値を変更しない
+	Parsed rejected(std::string("e"));
+	BOOST_CHECK(!queue.try_push(std::move(rejected)));
+	BOOST_CHECK_EQUAL(*rejected, "e");
+
+	BOOST_CHECK(queue.try_pop(out));
+	BOOST_CHECK_EQUAL(*out, "a");
+	BOOST_CHECK(queue.try_pop(out));
+	BOOST_CHECK_EQUAL(out.fail(), badRecord);
+
+	// 取り出した位置は再び使える
+	BOOST_CHECK(queue.try_push(std::move(rejected)));
+	const char *expected[] = { "c", "d", "e" };
+	for(std::size_t i = 0; i < 3; ++i) {
+		BOOST_CHECK(queue.try_pop(out));
+		BOOST_CHECK_EQUAL(*out, expected[i]);
+	}
+	BOOST_CHECK(!queue.try_pop(out));
+}
+
+BOOST_AUTO_TEST_CASE(testBulk) {
+	Queue queue(8);
+	std::vector<Parsed> in;
+	for(int i = 0; i < 10; ++i) in.push_back(Parsed(std::to_string(i)));
+
+	// 空きの数だけ追加する
+	BOOST_CHECK_EQUAL(queue.try_push_bulk(in.begin(), in.begin() + 3), 3u);
+	BOOST_CHECK(in[0]->empty());
+	BOOST_CHECK_EQUAL(queue.try_push_bulk(in.begin() + 3, in.end()), 5u);
+	BOOST_CHECK_EQUAL(*in[8], "8");
+	BOOST_CHECK_EQUAL(queue.try_push_bulk(in.begin() + 8, in.end()), 0u);
+
+	std::vector<Parsed> out;
+	BOOST_CHECK_EQUAL(queue.try_pop_bulk(std::back_inserter(out), 5), 5u);
+	BOOST_CHECK_EQUAL(queue.try_push_bulk(in.begin() + 8, in.end()), 2u);
+	BOOST_CHECK_EQUAL(queue.try_pop_bulk(std::back_inserter(out), 100), 5u);
+	BOOST_CHECK_EQUAL(queue.try_pop_bulk(std::back_inserter(out), 100), 0u);
+	BOOST_REQUIRE_EQUAL(out.size(), 10u);
+	for(int i = 0; i < 10; ++i) BOOST_CHECK_EQUAL(*out[i], std::to_string(i));
+}
+
+BOOST_AUTO_TEST_CASE(testDestroy) {
+	int alive = 0;
+	{
+		aslib::ResultQueue<Tracked, ParseError> queue(4);
+		for(int i = 0; i < 3; ++i) BOOST_CHECK(queue.try_push(Result<Tracked, ParseError>(Tracked(&alive))));
+		BOOST_CHECK_EQUAL(alive, 3);
+
+		// 出力で例外が発生しても、確保した要素は破棄して空きに戻す
+		int remaining = 1;
+		const ThrowingOutput out = { &remaining };
+		BOOST_CHECK_THROW(queue.try_pop_bulk(out, 2), std::runtime_error);
+		BOOST_CHECK_EQUAL(alive, 1);
+		for(int i = 0; i < 3; ++i) BOOST_CHECK(queue.try_push(Result<Tracked, ParseError>(Tracked(&alive))));
+		BOOST_CHECK_EQUAL(alive, 4);
+	}
+	// 残っている要素はキューと共に破棄する
+	BOOST_CHECK_EQUAL(alive, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testThreads) {
+	// 生産者毎の値が、それぞれ追加した順に1度ずつ取り出される
+	static const int producers = 4, consumers = 4, perProducer = 20000;
+	aslib::ResultQueue<int, ParseError> queue(64);
+	std::atomic<int> consumed(0);
+	std::vector<std::vector<int> > received(consumers);
+
+	std::vector<std::thread> threads;
+	for(int p = 0; p < producers; ++p) {
+		threads.push_back(std::thread([&queue, p] {
+			std::vector<Result<int, ParseError> > batch;
+			for(int i = 0; i < perProducer; ) {
+				if(i % 3 == 0) {
+					// 半分ずつ単独とまとめて追加する
+					if(queue.try_push(Result<int, ParseError>(p * perProducer + i))) ++i;
+					else std::this_thread::yield();
+					continue;
+				}
+				batch.clear();
+				for(int j = i; j < perProducer && j < i + 2; ++j) batch.push_back(p * perProducer + j);
+				const std::size_t n = queue.try_push_bulk(batch.begin(), batch.end());
+				if(n == 0) std::this_thread::yield();
+				i += static_cast<int>(n);
+			}
+		}));
+	}
+	for(int c = 0; c < consumers; ++c) {
+		threads.push_back(std::thread([&queue, &consumed, &received, c] {
+			Result<int, ParseError> values[8];
+			while(consumed.load() < producers * perProducer) {
+				const std::size_t n = (c % 2) ? queue.try_pop_bulk(values, 8) : queue.try_pop(values[0]);
+				for(std::size_t i = 0; i < n; ++i) received[c].push_back(*values[i]);
+				if(n == 0) std::this_thread::yield();
+				consumed += static_cast<int>(n);
+			}
+		}));
+	}
+	for(std::size_t i = 0; i < threads.size(); ++i) threads[i].join();
+
+	std::vector<int> count(producers * perProducer, 0);
+	for(int c = 0; c < consumers; ++c) {
+		std::vector<int> last(producers, -1);
+		for(std::size_t i = 0; i < received[c].size(); ++i) {
+			const int value = received[c][i];
+			++count[value];
+			BOOST_CHECK_LT(last[value / perProducer], value);
+			last[value / perProducer] = value;
+		}
+	}
+	for(std::size_t i = 0; i < count.size(); ++i) {
+		if(count[i] != 1) BOOST_ERROR("value " << i << " was received " << count[i] << " times.");
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,8 +1,9 @@
-﻿#include <iostream>
+﻿#include <cstring>
+#include <iostream>
+#include <string>
 #include <typeinfo>
-#include <boost/test/auto_unit_test.hpp>
-
-std::ostream &operator<<(std::ostream &stream, const std::type_info &type);
+#include <vector>
+#include <boost/test/unit_test.hpp>
 
 #include <aslib/Result.hpp>
 using aslib::Result;
@@ -34,6 +35,27 @@ namespace {
 
 	typedef Result<SucceededType, FailedType> R;
 
+	// 格納領域のレイアウト確認用
+	enum ErrorCode { noError, someError };
+	struct alignas(32) Aligned32 { char c_; };
+
+	static_assert(sizeof(Result<int, ErrorCode>) == 8, "Result<int, enum> must be packed into 8 bytes.");
+	static_assert(sizeof(Result<char, bool>) == 2, "The discriminant must be 1 byte.");
+	static_assert(std::alignment_of<Result<double, char> >::value == std::alignment_of<double>::value, "Storage must be aligned for the succeeded type.");
+	static_assert(std::alignment_of<Result<char, Aligned32> >::value == 32, "Storage must be aligned for the failed type.");
+	static_assert(sizeof(Result<char, Aligned32>) == 64, "Aligned storage must not carry extra padding.");
+
+	// 格納型が自明にコピー・破棄出来るならば、Result自身も自明にコピー・破棄出来る
+	typedef Result<int, ErrorCode> TrivialR;
+	static_assert(std::is_trivially_copyable<TrivialR>::value, "Result of trivial types must be trivially copyable.");
+	static_assert(std::is_trivially_destructible<TrivialR>::value, "Result of trivial types must be trivially destructible.");
+	static_assert(std::is_trivially_copy_constructible<TrivialR>::value && std::is_trivially_move_constructible<TrivialR>::value, "");
+	static_assert(std::is_trivially_copy_assignable<TrivialR>::value && std::is_trivially_move_assignable<TrivialR>::value, "");
+	static_assert(!std::is_trivially_copyable<Result<std::string, int> >::value, "");
+	static_assert(!std::is_trivially_destructible<Result<int, std::string> >::value, "");
+	static_assert(!std::is_trivially_copyable<R>::value, "");
+	static_assert(std::is_nothrow_move_constructible<Result<std::string, int> >::value, "");
+
 	struct Fixture {
 		Fixture()
 			: s(SucceededType(&s_flag)), f(FailedType(&f_flag)),
@@ -114,35 +136,144 @@ BOOST_FIXTURE_TEST_SUITE(ResultTest, Fixture)
 	}
 
 	BOOST_AUTO_TEST_CASE(testOpDereference) {	// operator *
-		BOOST_CHECK_EQUAL(typeid(*s), typeid(SucceededType&));
+		BOOST_CHECK(typeid(*s) == typeid(SucceededType&));
 		BOOST_CHECK_THROW(*f, R::CantDereference);
 		BOOST_CHECK_THROW(*u, R::CantDereference);
 
-		BOOST_CHECK_EQUAL(typeid(*cs), typeid(const SucceededType&));
+		BOOST_CHECK(typeid(*cs) == typeid(const SucceededType&));
 		BOOST_CHECK_THROW(*cf, R::CantDereference);
 		BOOST_CHECK_THROW(*cu, R::CantDereference);
 	}
 
 	BOOST_AUTO_TEST_CASE(testOpArrow) {	// operator->
-		BOOST_CHECK_EQUAL(typeid(s.operator->()), typeid(SucceededType*));
+		BOOST_CHECK(typeid(s.operator->()) == typeid(SucceededType*));
 		BOOST_CHECK_THROW(f.operator->(), R::CantDereference);
 		BOOST_CHECK_THROW(u.operator->(), R::CantDereference);
 
-		BOOST_CHECK_EQUAL(typeid(cs.operator->()), typeid(const SucceededType*));
+		BOOST_CHECK(typeid(cs.operator->()) == typeid(const SucceededType*));
 		BOOST_CHECK_THROW(cf.operator->(), R::CantDereference);
 		BOOST_CHECK_THROW(cu.operator->(), R::CantDereference);
 	}
 
 	BOOST_AUTO_TEST_CASE(testFail) {
 		BOOST_CHECK_THROW(s.fail(), R::NotHaveFailedObject);
-		BOOST_CHECK_EQUAL(typeid(f.fail()), typeid(FailedType&));
+		BOOST_CHECK(typeid(f.fail()) == typeid(FailedType&));
 		BOOST_CHECK_THROW(u.fail(), R::NotHaveFailedObject);
 
 		BOOST_CHECK_THROW(cs.fail(), R::NotHaveFailedObject);
-		BOOST_CHECK_EQUAL(typeid(cf.fail()), typeid(const FailedType&));
+		BOOST_CHECK(typeid(cf.fail()) == typeid(const FailedType&));
 		BOOST_CHECK_THROW(cu.fail(), R::NotHaveFailedObject);
 	}
 
+	BOOST_AUTO_TEST_CASE(testGetIf) {
+		BOOST_CHECK_EQUAL(s.get_if(), &*s);
+		BOOST_CHECK(f.get_if() == nullptr);
+		BOOST_CHECK(u.get_if() == nullptr);
+		BOOST_CHECK(typeid(s.get_if()) == typeid(SucceededType*));
+
+		BOOST_CHECK_EQUAL(cs.get_if(), &*cs);
+		BOOST_CHECK(cf.get_if() == nullptr);
+		BOOST_CHECK(cu.get_if() == nullptr);
+		BOOST_CHECK(typeid(cs.get_if()) == typeid(const SucceededType*));
+	}
+
+	BOOST_AUTO_TEST_CASE(testFailIf) {
+		BOOST_CHECK(s.fail_if() == nullptr);
+		BOOST_CHECK_EQUAL(f.fail_if(), &f.fail());
+		BOOST_CHECK(u.fail_if() == nullptr);
+		BOOST_CHECK(typeid(f.fail_if()) == typeid(FailedType*));
+
+		BOOST_CHECK(cs.fail_if() == nullptr);
+		BOOST_CHECK_EQUAL(cf.fail_if(), &cf.fail());
+		BOOST_CHECK(cu.fail_if() == nullptr);
+		BOOST_CHECK(typeid(cf.fail_if()) == typeid(const FailedType*));
+	}
+
+	BOOST_AUTO_TEST_CASE(testValueOr) {
+		CallFlag flag;
+		SucceededType def(&flag);
+
+		// 正常値を保持していればそのコピー
+		{
+			SucceededType v = cs.value_or(def);
+			BOOST_CHECK_EQUAL(v.flag_, &cs_flag);
+			BOOST_CHECK_EQUAL(cs_flag, copyConstruct);
+		}
+		// それ以外は引数の値
+		BOOST_CHECK_EQUAL(cf.value_or(def).flag_, &flag);
+		BOOST_CHECK_EQUAL(cu.value_or(def).flag_, &flag);
+
+		// 右辺値からは正常値をムーブする
+		{
+			SucceededType v = std::move(s).value_or(def);
+			BOOST_CHECK_EQUAL(v.flag_, &s_flag);
+			BOOST_CHECK_EQUAL(s_flag, moveConstruct);
+		}
+
+		Result<int, ErrorCode> ri = 1, rf = someError;
+		BOOST_CHECK_EQUAL(ri.value_or(2), 1);
+		BOOST_CHECK_EQUAL(rf.value_or(2), 2);
+	}
+
+	BOOST_AUTO_TEST_CASE(testUnchecked) {
+		BOOST_CHECK_EQUAL(&s.unchecked_value(), &*s);
+		BOOST_CHECK_EQUAL(&cs.unchecked_value(), &*cs);
+		BOOST_CHECK(typeid(cs.unchecked_value()) == typeid(const SucceededType&));
+		BOOST_CHECK_EQUAL(&f.unchecked_fail(), &f.fail());
+		BOOST_CHECK_EQUAL(&cf.unchecked_fail(), &cf.fail());
+		BOOST_CHECK(typeid(cf.unchecked_fail()) == typeid(const FailedType&));
+	}
+
+	BOOST_AUTO_TEST_CASE(testInPlaceConstructor) {
+		CallFlag sflag, fflag;
+		R rs(aslib::in_place_success, &sflag);
+		R rf(aslib::in_place_failure, &fflag);
+		BOOST_CHECK(static_cast<bool>(rs));
+		BOOST_CHECK(!static_cast<bool>(rf));
+		// 直接構築されるので、コピー・ムーブは発生しない
+		BOOST_CHECK_EQUAL(sflag, construct);
+		BOOST_CHECK_EQUAL(fflag, construct);
+		BOOST_CHECK_EQUAL(rs->flag_, &sflag);
+		BOOST_CHECK_EQUAL(rf.fail().flag_, &fflag);
+
+		Result<std::string, int> str(aslib::in_place_success, 3, 'a');
+		BOOST_CHECK_EQUAL(*str, "aaa");
+		Result<int, std::string> err(aslib::in_place_failure, "error");
+		BOOST_CHECK_EQUAL(err.fail(), "error");
+	}
+
+	BOOST_AUTO_TEST_CASE(testEmplace) {
+		CallFlag sflag, fflag;
+
+		SucceededType &sv = f.emplace_success(&sflag);
+		BOOST_CHECK_EQUAL(f_flag, destruct);
+		BOOST_CHECK_EQUAL(sflag, construct);
+		BOOST_CHECK(static_cast<bool>(f));
+		BOOST_CHECK_EQUAL(&sv, &*f);
+
+		FailedType &fv = s.emplace_failure(&fflag);
+		BOOST_CHECK_EQUAL(s_flag, destruct);
+		BOOST_CHECK_EQUAL(fflag, construct);
+		BOOST_CHECK(!static_cast<bool>(s));
+		BOOST_CHECK_EQUAL(&fv, &s.fail());
+
+		u.emplace_success(&u_flag);
+		BOOST_CHECK_EQUAL(u_flag, construct);
+		BOOST_CHECK(static_cast<bool>(u));
+	}
+
+	BOOST_AUTO_TEST_CASE(testEmplace_throw) {
+		struct Thrower {
+			Thrower(bool doThrow) { if(doThrow) throw std::runtime_error("construct"); }
+		};
+		Result<Thrower, std::string> r(std::string("before"));
+		BOOST_CHECK_THROW(r.emplace_success(true), std::runtime_error);
+		BOOST_CHECK(!static_cast<bool>(r));
+		BOOST_CHECK(r.fail_if() == nullptr);	// 未初期化になる
+		r.emplace_success(false);
+		BOOST_CHECK(static_cast<bool>(r));
+	}
+
 	BOOST_AUTO_TEST_CASE(testOpEp) {	// operator=
 		R r1, r2;
 		BOOST_REQUIRE(!static_cast<bool>(r1));
@@ -167,53 +298,54 @@ BOOST_FIXTURE_TEST_SUITE(ResultTest, Fixture)
 
 /*
  Result::operator=(TYPE&&)用テストケース
- TEST_CASE_OPEP_MOVE_(左辺値型種別, 右辺値型種別)
+ TEST_CASE_OPEP_MOVE_(左辺値型種別, 右辺値型種別, 右辺値に対して呼ばれる操作)
    uninit	未初期化のResult
    succeeded	正常値のResult
    failed	エラー値のResult
    co-succeeded	正常値
    co-failed	エラー値
+ 左辺値と右辺値の種別が同じならばムーブ代入、異なればムーブ構築が行われる.
 */
-#define TEST_CASE_OPEP_MOVE_(lhs, rhs) \
+#define TEST_CASE_OPEP_MOVE_(lhs, rhs, expected) \
 	BOOST_AUTO_TEST_CASE(testOpEp_move_ ## lhs ## _ ## rhs) { \
 		TEST_CASE_OPEP_MOVE_LHS_ ## lhs; \
-		TEST_CASE_OPEP_MOVE_RHS_ ## rhs; \
+		TEST_CASE_OPEP_MOVE_RHS_ ## rhs(expected); \
 	}
 #define TEST_CASE_OPEP_MOVE_LHS_uninit    R r;
 #define TEST_CASE_OPEP_MOVE_LHS_succeeded SucceededType lst; R r(lst);
 #define TEST_CASE_OPEP_MOVE_LHS_failed    FailedType lft; R r(lft);
 
-#define TEST_CASE_OPEP_MOVE_RHS_uninit BOOST_FAIL("Can't runned test, because flag is not exist.");
-#define TEST_CASE_OPEP_MOVE_RHS_succeeded \
+#define TEST_CASE_OPEP_MOVE_RHS_uninit(expected) BOOST_FAIL("Can't runned test, because flag is not exist.");
+#define TEST_CASE_OPEP_MOVE_RHS_succeeded(expected) \
 	r = std::move(s); \
-	BOOST_CHECK_EQUAL(s_flag, moveOpEp);
-#define TEST_CASE_OPEP_MOVE_RHS_failed \
+	BOOST_CHECK_EQUAL(s_flag, expected);
+#define TEST_CASE_OPEP_MOVE_RHS_failed(expected) \
 	r = std::move(f); \
-	BOOST_CHECK_EQUAL(f_flag, moveOpEp);
-#define TEST_CASE_OPEP_MOVE_RHS_co_uninit TEST_CASE_OPEP_MOVE_RHS_uninit
-#define TEST_CASE_OPEP_MOVE_RHS_co_succeeded \
+	BOOST_CHECK_EQUAL(f_flag, expected);
+#define TEST_CASE_OPEP_MOVE_RHS_co_uninit(expected) TEST_CASE_OPEP_MOVE_RHS_uninit(expected)
+#define TEST_CASE_OPEP_MOVE_RHS_co_succeeded(expected) \
 	CallFlag flag; \
 	SucceededType rst(&flag); \
 	r = std::move(rst); \
-	BOOST_CHECK_EQUAL(flag, moveOpEp);
-#define TEST_CASE_OPEP_MOVE_RHS_co_failed \
+	BOOST_CHECK_EQUAL(flag, expected);
+#define TEST_CASE_OPEP_MOVE_RHS_co_failed(expected) \
 	CallFlag flag; \
 	FailedType rft(&flag); \
 	r = std::move(rft); \
-	BOOST_CHECK_EQUAL(flag, moveOpEp);
-
-	TEST_CASE_OPEP_MOVE_(uninit, succeeded);
-	TEST_CASE_OPEP_MOVE_(uninit, failed);
-	TEST_CASE_OPEP_MOVE_(uninit, co_succeeded);
-	TEST_CASE_OPEP_MOVE_(uninit, co_failed);
-	TEST_CASE_OPEP_MOVE_(succeeded, succeeded);
-	TEST_CASE_OPEP_MOVE_(succeeded, failed);
-	TEST_CASE_OPEP_MOVE_(succeeded, co_succeeded);
-	TEST_CASE_OPEP_MOVE_(succeeded, co_failed);
-	TEST_CASE_OPEP_MOVE_(failed, succeeded);
-	TEST_CASE_OPEP_MOVE_(failed, failed);
-	TEST_CASE_OPEP_MOVE_(failed, co_succeeded);
-	TEST_CASE_OPEP_MOVE_(failed, co_failed);
+	BOOST_CHECK_EQUAL(flag, expected);
+
+	TEST_CASE_OPEP_MOVE_(uninit, succeeded, moveConstruct);
+	TEST_CASE_OPEP_MOVE_(uninit, failed, moveConstruct);
+	TEST_CASE_OPEP_MOVE_(uninit, co_succeeded, moveConstruct);
+	TEST_CASE_OPEP_MOVE_(uninit, co_failed, moveConstruct);
+	TEST_CASE_OPEP_MOVE_(succeeded, succeeded, moveOpEp);
+	TEST_CASE_OPEP_MOVE_(succeeded, failed, moveConstruct);
+	TEST_CASE_OPEP_MOVE_(succeeded, co_succeeded, moveOpEp);
+	TEST_CASE_OPEP_MOVE_(succeeded, co_failed, moveConstruct);
+	TEST_CASE_OPEP_MOVE_(failed, succeeded, moveConstruct);
+	TEST_CASE_OPEP_MOVE_(failed, failed, moveOpEp);
+	TEST_CASE_OPEP_MOVE_(failed, co_succeeded, moveConstruct);
+	TEST_CASE_OPEP_MOVE_(failed, co_failed, moveOpEp);
 	
 #undef TEST_CASE_OPEP_MOVE_
 #undef TEST_CASE_OPEP_MOVE_LHS_uninit
@@ -226,17 +358,413 @@ BOOST_FIXTURE_TEST_SUITE(ResultTest, Fixture)
 #undef TEST_CASE_OPEP_MOVE_RHS_co_succeeded
 #undef TEST_CASE_OPEP_MOVE_RHS_co_failed
 
+	BOOST_AUTO_TEST_CASE(testOpEp_copy) {	// operator=(const &)
+		// 同じ種別ならばコピー代入
+		CallFlag flag, lflag;
+		SucceededType st(&flag);
+		R r = SucceededType(&lflag);
+		r = st;
+		BOOST_CHECK_EQUAL(flag, copyOpEp);
+
+		// 種別が異なればコピー構築し、元の値は破棄する
+		CallFlag fflag;
+		FailedType ft(&fflag);
+		r = ft;
+		BOOST_CHECK_EQUAL(fflag, copyConstruct);
+		BOOST_CHECK_EQUAL(flag, destruct);
+
+		r = cs;
+		BOOST_CHECK_EQUAL(cs_flag, copyConstruct);
+		BOOST_CHECK_EQUAL(fflag, destruct);
+		r = cs;
+		BOOST_CHECK_EQUAL(cs_flag, copyOpEp);
+	}
+
+	BOOST_AUTO_TEST_CASE(testOpEp_noDefaultConstructor) {
+		// デフォルトコンストラクタを持たない型でも代入出来る
+		struct NoDefault {
+			explicit NoDefault(int i) : i_(i) {}
+			int i_;
+		};
+		Result<NoDefault, int> r = 1;
+		r = NoDefault(2);
+		BOOST_CHECK_EQUAL(r->i_, 2);
+		const NoDefault n(3);
+		r = n;
+		BOOST_CHECK_EQUAL(r->i_, 3);
+		r = 4;
+		BOOST_CHECK(!r);
+	}
+
 	BOOST_AUTO_TEST_CASE(testCoTypedefs) {
 		typedef Result<SucceededType, FailedType> R;
-		BOOST_CHECK_EQUAL(typeid(R::SucceededType), typeid(SucceededType));
-		BOOST_CHECK_EQUAL(typeid(R::FailedType), typeid(FailedType));
+		BOOST_CHECK(typeid(R::SucceededType) == typeid(SucceededType));
+		BOOST_CHECK(typeid(R::FailedType) == typeid(FailedType));
+	}
+BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_SUITE(ResultLayoutTest)
+	BOOST_AUTO_TEST_CASE(testAlignment) {
+		// 配列の要素でも、格納した値はアライメントされている
+		Result<char, Aligned32> rs[3] = { 'a', Aligned32(), Aligned32() };
+		for(int i = 1; i < 3; ++i) {
+			const Aligned32 *p = &rs[i].fail();
+			BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(p) % 32, 0u);
+		}
+
+		Result<double, char> d = 1.5;
+		BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(&*d) % std::alignment_of<double>::value, 0u);
+		BOOST_CHECK_EQUAL(*d, 1.5);
+	}
+BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_SUITE(ResultTrivialTest)
+	BOOST_AUTO_TEST_CASE(testCopy) {
+		const TrivialR s = 1, f = someError, u;
+		TrivialR sc(s), fc(f), uc(u);
+		BOOST_CHECK_EQUAL(*sc, 1);
+		BOOST_CHECK_EQUAL(fc.fail(), someError);
+		BOOST_CHECK(!uc);
+		BOOST_CHECK_THROW(uc.fail(), TrivialR::NotHaveFailedObject);
+
+		uc = s;
+		BOOST_CHECK_EQUAL(*uc, 1);
+		sc = f;
+		BOOST_CHECK_EQUAL(sc.fail(), someError);
+		fc = u;
+		BOOST_CHECK(!fc);
+		BOOST_CHECK_THROW(fc.fail(), TrivialR::NotHaveFailedObject);
+	}
+
+	BOOST_AUTO_TEST_CASE(testMemcpy) {
+		// memcpyでまとめてコピー出来る
+		TrivialR src[3] = { 1, someError, 3 }, dst[3];
+		std::memcpy(dst, src, sizeof(src));
+		BOOST_CHECK_EQUAL(*dst[0], 1);
+		BOOST_CHECK_EQUAL(dst[1].fail(), someError);
+		BOOST_CHECK_EQUAL(*dst[2], 3);
+	}
+BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_SUITE(ResultCombinatorTest)
+	// コピーされた時のみフラグを書き換える、大きなデータを持つ型.
+	struct Payload {
+		Payload(CallFlag *flag) : flag_(flag), data_(1024, 1) { *flag_ = construct; }
+		Payload(const Payload &src) : flag_(src.flag_), data_(src.data_) { *flag_ = copyConstruct; }
+		Payload(Payload &&src) : flag_(src.flag_), data_(std::move(src.data_)) {}
+		Payload &operator=(const Payload &rhs) { flag_ = rhs.flag_; data_ = rhs.data_; *flag_ = copyOpEp; return *this; }
+		Payload &operator=(Payload &&rhs) { flag_ = rhs.flag_; data_ = std::move(rhs.data_); return *this; }
+		CallFlag *flag_;
+		std::vector<int> data_;
+	};
+	typedef Result<Payload, ErrorCode> PR;
+
+	PR parse(CallFlag *flag) { return Payload(flag); }
+
+	BOOST_AUTO_TEST_CASE(testPipeline_noCopy) {
+		CallFlag flag;
+		PR r = parse(&flag);
+		const int *data = r->data_.data();
+		BOOST_REQUIRE_EQUAL(flag, construct);
+
+		PR result = std::move(r)
+			.and_then([](Payload &&p) -> PR { if(p.data_.empty()) return someError; return std::move(p); })	// validate
+			.map([](Payload &&p) -> Payload { p.data_[0] = 2; return std::move(p); })	// transform
+			.map_error([](ErrorCode e) { return e; })
+			.or_else([](ErrorCode) -> PR { return noError; })
+			.map([](Payload &&p) -> Payload { ++p.data_[0]; return std::move(p); });
+
+		BOOST_REQUIRE(static_cast<bool>(result));
+		BOOST_CHECK_EQUAL(flag, construct);	// 一度もコピーされていない
+		BOOST_CHECK_EQUAL(result->data_.data(), data);
+		BOOST_CHECK_EQUAL(result->data_[0], 3);
+	}
+
+	BOOST_AUTO_TEST_CASE(testPipeline_failure) {
+		CallFlag flag;
+		bool called = false;
+		PR result = PR(someError)
+			.map([&](Payload &&p) -> Payload { called = true; return std::move(p); })
+			.and_then([&](Payload &&p) -> PR { called = true; return std::move(p); });
+		BOOST_CHECK(!called);
+		BOOST_CHECK_EQUAL(result.fail(), someError);
+
+		PR recovered = std::move(result).or_else([&](ErrorCode e) -> PR { BOOST_CHECK_EQUAL(e, someError); return Payload(&flag); });
+		BOOST_CHECK(static_cast<bool>(recovered));
+		BOOST_CHECK_EQUAL(flag, construct);
+
+		Result<Payload, std::string> mapped = PR(someError).map_error([](ErrorCode) { return std::string("error"); });
+		BOOST_CHECK_EQUAL(mapped.fail(), "error");
+	}
+
+	BOOST_AUTO_TEST_CASE(testLvalue_copies) {
+		CallFlag flag;
+		const PR r = Payload(&flag);
+		Result<std::size_t, ErrorCode> size = r.map([](const Payload &p) { return p.data_.size(); });
+		BOOST_CHECK_EQUAL(*size, 1024u);
+		BOOST_CHECK_EQUAL(flag, construct);
+
+		PR copied = r.and_then([](const Payload &p) -> PR { return p; });
+		BOOST_CHECK_EQUAL(flag, copyConstruct);
+		BOOST_CHECK(static_cast<bool>(r));
+
+		const PR u;
+		BOOST_CHECK(u.map([](const Payload &p) { return p.data_.size(); }).get_if() == nullptr);
+		BOOST_CHECK(u.map([](const Payload &p) { return p.data_.size(); }).fail_if() == nullptr);
+	}
+BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_SUITE(ResultReferenceTest)
+	typedef Result<const std::string &, ErrorCode> RefR;
+	static_assert(sizeof(RefR) == sizeof(Result<const std::string *, ErrorCode>), "Result<T &, F> must be as small as Result<T *, F>.");
+	static_assert(std::is_trivially_copyable<RefR>::value, "");
+	static_assert(!std::is_constructible<RefR, std::string &&>::value, "Result<const T &, F> must not bind a temporary.");
+
+	RefR lookup(const std::vector<std::string> &cache, std::size_t i) {
+		if(i < cache.size()) return cache[i];
+		return someError;
+	}
+
+	BOOST_AUTO_TEST_CASE(testBorrow) {
+		const std::vector<std::string> cache(2, "cached");
+		RefR hit = lookup(cache, 1), miss = lookup(cache, 2);
+
+		BOOST_REQUIRE(static_cast<bool>(hit));
+		BOOST_CHECK_EQUAL(&*hit, &cache[1]);	// コピーされない
+		BOOST_CHECK_EQUAL(hit->size(), 6u);
+		BOOST_CHECK_EQUAL(hit.get_if(), &cache[1]);
+		BOOST_CHECK_EQUAL(&hit.unchecked_value(), &cache[1]);
+		BOOST_CHECK(hit.fail_if() == nullptr);
+
+		BOOST_CHECK(!static_cast<bool>(miss));
+		BOOST_CHECK_EQUAL(miss.fail(), someError);
+		BOOST_CHECK(miss.get_if() == nullptr);
+		BOOST_CHECK_THROW(*miss, RefR::CantDereference);
+		BOOST_CHECK_EQUAL(&miss.value_or(cache[0]), &cache[0]);
+	}
+
+	BOOST_AUTO_TEST_CASE(testRebind) {
+		std::string a("a"), b("b");
+		Result<std::string &, ErrorCode> r = a;
+		*r = "A";
+		BOOST_CHECK_EQUAL(a, "A");
+
+		r = b;	// 参照先の変更. aへの代入ではない
+		BOOST_CHECK_EQUAL(a, "A");
+		BOOST_CHECK_EQUAL(&*r, &b);
+
+		r = someError;
+		BOOST_CHECK_EQUAL(r.fail(), someError);
+	}
+
+	BOOST_AUTO_TEST_CASE(testCombinator) {
+		std::string s("text");
+		Result<std::string &, ErrorCode> r = s;
+		Result<std::size_t, ErrorCode> size = r.map([](std::string &v) { return v.size(); });
+		BOOST_CHECK_EQUAL(*size, 4u);
+
+		Result<std::string &, std::string> e = Result<std::string &, ErrorCode>(someError).map_error([](ErrorCode) { return std::string("error"); });
+		BOOST_CHECK_EQUAL(e.fail(), "error");
+		BOOST_CHECK_EQUAL(&*r.map_error([](ErrorCode) { return 0; }), &s);
+	}
+BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_SUITE(ResultVoidTest)
+	typedef Result<void, ErrorCode> VoidR;
+	static_assert(sizeof(VoidR) == sizeof(Result<ErrorCode, char>), "Result<void, F> must hold only the error.");
+	static_assert(std::is_trivially_copyable<VoidR>::value, "");
+
+	VoidR check(bool ok) {
+		if(!ok) return someError;
+		return VoidR(aslib::in_place_success);
+	}
+
+	BOOST_AUTO_TEST_CASE(testStatus) {
+		VoidR ok = check(true), ng = check(false), u;
+		BOOST_CHECK(static_cast<bool>(ok));
+		BOOST_CHECK(ok.fail_if() == nullptr);
+		BOOST_CHECK_THROW(ok.fail(), VoidR::NotHaveFailedObject);
+
+		BOOST_CHECK(!static_cast<bool>(ng));
+		BOOST_CHECK_EQUAL(ng.fail(), someError);
+
+		BOOST_CHECK(!static_cast<bool>(u));
+		BOOST_CHECK(u.fail_if() == nullptr);
+
+		ok = someError;
+		BOOST_CHECK_EQUAL(ok.unchecked_fail(), someError);
+		ok.emplace_success();
+		BOOST_CHECK(static_cast<bool>(ok));
+	}
+
+	BOOST_AUTO_TEST_CASE(testCombinator) {
+		bool called = false;
+		Result<int, ErrorCode> r = check(true).map([]() { return 1; });
+		BOOST_CHECK_EQUAL(*r, 1);
+		check(false).and_then([&]() -> VoidR { called = true; return VoidR(aslib::in_place_success); });
+		BOOST_CHECK(!called);
+
+		VoidR recovered = check(false).or_else([](ErrorCode) { return VoidR(aslib::in_place_success); });
+		BOOST_CHECK(static_cast<bool>(recovered));
+		Result<void, std::string> e = check(false).map_error([](ErrorCode) { return std::string("error"); });
+		BOOST_CHECK_EQUAL(e.fail(), "error");
+	}
+BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_SUITE(ResultTryTest)
+	typedef Result<int, ErrorCode> IntR;
+	typedef Result<void, ErrorCode> VoidR;
+
+	IntR parse(int v) {
+		if(v < 0) return someError;
+		return v;
+	}
+	IntR twice(int v) {
+		ASLIB_TRY_ASSIGN(const int parsed, parse(v));
+		return parsed * 2;
+	}
+	VoidR validate(int v) {
+		ASLIB_TRY(parse(v));
+		return VoidR(aslib::in_place_success);
+	}
+
+	// コピーとムーブの回数を数えるエラー値
+	struct Counted {
+		Counted(int *copies, int *moves) : copies_(copies), moves_(moves) {}
+		Counted(const Counted &src) : copies_(src.copies_), moves_(src.moves_) { ++*copies_; }
+		Counted(Counted &&src) : copies_(src.copies_), moves_(src.moves_) { ++*moves_; }
+		Counted &operator=(const Counted &) = default;
+		int *copies_;
+		int *moves_;
+	};
+	typedef Result<std::string, Counted> CountedR;
+
+	CountedR fail(int *copies, int *moves) { return CountedR(aslib::in_place_failure, copies, moves); }
+	Result<int, Counted> forwardTemporary(int *copies, int *moves) {
+		ASLIB_TRY_ASSIGN(std::string s, fail(copies, moves));
+		return static_cast<int>(s.size());
+	}
+	Result<int, Counted> forwardNamed(const CountedR &r) {
+		ASLIB_TRY(r);
+		return 0;
+	}
+
+	BOOST_AUTO_TEST_CASE(testPropagate) {
+		BOOST_CHECK_EQUAL(*twice(2), 4);
+		BOOST_CHECK_EQUAL(twice(-1).fail(), someError);
+		BOOST_CHECK(static_cast<bool>(validate(1)));
+		BOOST_CHECK_EQUAL(validate(-1).fail(), someError);
+	}
+
+	BOOST_AUTO_TEST_CASE(testMoveFailure) {
+		// 一時オブジェクトのエラー値は、コピーせずに1度だけムーブする
+		int copies = 0, moves = 0;
+		Result<int, Counted> r = forwardTemporary(&copies, &moves);
+		BOOST_CHECK(r.fail_if() != nullptr);
+		BOOST_CHECK_EQUAL(copies, 0);
+		BOOST_CHECK_EQUAL(moves, 1);
+
+		// 左辺値のエラー値はコピーし、元のResultは変更しない
+		const CountedR named = fail(&copies, &moves);
+		copies = moves = 0;
+		r = forwardNamed(named);
+		BOOST_CHECK(r.fail_if() != nullptr);
+		BOOST_CHECK_EQUAL(copies, 1);
+		BOOST_CHECK_EQUAL(moves, 0);
+	}
+
+	IntR assignExisting(Result<int &, ErrorCode> ref) {
+		int value = 0;
+		ASLIB_TRY_ASSIGN(value, ref);
+		return value;
+	}
+	IntR takeValue(int *copies, int *moves) {
+		ASLIB_TRY_ASSIGN(const Counted c, Result<Counted, ErrorCode>(aslib::in_place_success, copies, moves));
+		return (c.copies_ == copies && c.moves_ == moves) ? 0 : 1;
+	}
+	IntR propagateUninit() {
+		ASLIB_TRY(IntR());
+		return 0;
+	}
+
+	BOOST_AUTO_TEST_CASE(testAssign) {
+		int referred = 3;
+		BOOST_CHECK_EQUAL(*assignExisting(referred), 3);
+		BOOST_CHECK_EQUAL(assignExisting(someError).fail(), someError);
+
+		// 一時オブジェクトの正常値はムーブする
+		int copies = 0, moves = 0;
+		BOOST_CHECK_EQUAL(*takeValue(&copies, &moves), 0);
+		BOOST_CHECK_EQUAL(copies, 0);
+		BOOST_CHECK_EQUAL(moves, 1);
+
+		IntR u = propagateUninit();
+		BOOST_CHECK(!static_cast<bool>(u));
+		BOOST_CHECK(u.fail_if() == nullptr);
+	}
+BOOST_AUTO_TEST_SUITE_END();
+
+#if ASLIB_HAS_CONSTEXPR_RESULT
+BOOST_AUTO_TEST_SUITE(ResultConstexprTest)
+	enum class PortError { tooSmall, tooLarge };
+
+	constexpr Result<int, PortError> validatePort(int port) {
+		if(port < 1) return PortError::tooSmall;
+		if(port > 65535) return PortError::tooLarge;
+		return port;
+	}
+
+	static_assert(static_cast<bool>(validatePort(80)), "");
+	static_assert(*validatePort(80) == 80, "");
+	static_assert(validatePort(0).fail() == PortError::tooSmall, "");
+	static_assert(validatePort(70000).value_or(-1) == -1, "");
+	static_assert(*validatePort(8000).map([](int p) { return p + 1; }) == 8001, "");
+	static_assert(validatePort(0).or_else([](PortError) { return Result<int, PortError>(1); }).unchecked_value() == 1, "");
+
+	// 自明でないコピー・破棄を持つリテラル型
+	struct Literal {
+		constexpr Literal(int v) : value(v) {}
+		constexpr Literal(const Literal &src) : value(src.value + 1) {}
+		constexpr Literal &operator=(const Literal &rhs) { value = rhs.value + 10; return *this; }
+		constexpr ~Literal() {}
+		int value;
+	};
+	typedef Result<Literal, int> LiteralR;
+	static_assert(!std::is_trivially_destructible<LiteralR>::value, "");
+
+	constexpr int copyAndAssign() {
+		LiteralR r(aslib::in_place_success, 1);
+		LiteralR c = r;	// 2
+		c = r;	// 11
+		LiteralR f = 5;
+		f = c;	// 12 (エラー値から正常値への切り替え)
+		f.emplace_failure(7);
+		return c->value * 100 + r.unchecked_value().value + f.fail();
+	}
+	static_assert(copyAndAssign() == 11 * 100 + 1 + 7, "");
+
+	// コンパイル時のテーブル生成
+	struct PortTable {
+		constexpr PortTable() : valid() {
+			for(int i = 0; i < 8; ++i) valid[i] = static_cast<bool>(validatePort(i * 20000));
+		}
+		bool valid[8];
+	};
+	constexpr PortTable portTable;
+	static_assert(!portTable.valid[0] && portTable.valid[1] && portTable.valid[3] && !portTable.valid[4], "");
+
+	BOOST_AUTO_TEST_CASE(testRuntime) {
+		// 定数式用の実装が実行時にも同じ結果になる事
+		BOOST_CHECK_EQUAL(copyAndAssign(), 11 * 100 + 1 + 7);
+		BOOST_CHECK_EQUAL(*validatePort(443), 443);
 	}
 BOOST_AUTO_TEST_SUITE_END();
+#endif
 
 BOOST_AUTO_TEST_SUITE(ResultCantDereferenceTest)
 	BOOST_AUTO_TEST_CASE(test) {
 		R::CantDereference e;	// 構築テスト
-		std::runtime_error &s = R::CantDereference();	// 基底クラス確認
+		const std::runtime_error &s = R::CantDereference();	// 基底クラス確認
 		e.what();	// 呼び出しテスト
 	}
 BOOST_AUTO_TEST_SUITE_END();
@@ -244,7 +772,7 @@ BOOST_AUTO_TEST_SUITE_END();
 BOOST_AUTO_TEST_SUITE(ResultNotHaveFailedObjectTest)
 	BOOST_AUTO_TEST_CASE(test) {
 		R::NotHaveFailedObject e;	// 構築テスト
-		std::runtime_error &s = R::NotHaveFailedObject();	// 基底クラス確認
+		const std::runtime_error &s = R::NotHaveFailedObject();	// 基底クラス確認
 		e.what();	// 呼び出しテスト
 	}
 BOOST_AUTO_TEST_SUITE_END();
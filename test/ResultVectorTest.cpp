@@ -0,0 +1,118 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+#include <aslib/ResultVector.hpp>
+
+using aslib::Result;
+using aslib::ResultVector;
+
+namespace {
+	typedef ResultVector<int, std::string> RV;
+
+	/// iが3の倍数の時にエラー値となる列を作る.
+	RV makeVector(std::size_t n) {
+		RV v;
+		for(std::size_t i = 0; i < n; ++i) {
+			if(i % 3 == 0) v.push_back(Result<int, std::string>(std::to_string(i)));
+			else v.push_back(Result<int, std::string>(static_cast<int>(i)));
+		}
+		return v;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(ResultVectorTest)
+	BOOST_AUTO_TEST_CASE(testEmpty) {
+		RV v;
+		BOOST_CHECK(v.empty());
+		BOOST_CHECK_EQUAL(v.size(), 0u);
+		BOOST_CHECK_EQUAL(v.count_failed(), 0u);
+		BOOST_CHECK_EQUAL(v.count_failed(0, 0), 0u);
+	}
+
+	BOOST_AUTO_TEST_CASE(testAccess) {
+		const std::size_t n = 200;	// 複数のワードにまたがる
+		RV v = makeVector(n);
+		BOOST_REQUIRE_EQUAL(v.size(), n);
+
+		for(std::size_t i = 0; i < n; ++i) {
+			if(i % 3 == 0) {
+				BOOST_CHECK(!v.succeeded(i));
+				BOOST_CHECK(!v[i]);
+				BOOST_CHECK_EQUAL(v[i].fail(), std::to_string(i));
+				BOOST_CHECK(v[i].get_if() == nullptr);
+				BOOST_CHECK_THROW(*v[i], RV::reference::CantDereference);
+				BOOST_CHECK_EQUAL(v[i].value_or(-1), -1);
+			} else {
+				BOOST_CHECK(v.succeeded(i));
+				BOOST_CHECK(static_cast<bool>(v[i]));
+				BOOST_CHECK_EQUAL(*v[i], static_cast<int>(i));
+				BOOST_CHECK(v[i].fail_if() == nullptr);
+				BOOST_CHECK_THROW(v[i].fail(), RV::reference::NotHaveFailedObject);
+			}
+		}
+
+		const RV &cv = v;
+		BOOST_CHECK_EQUAL(*cv[199], 199);
+		BOOST_CHECK_EQUAL(cv[198].fail(), "198");
+	}
+
+	BOOST_AUTO_TEST_CASE(testModify) {
+		RV v = makeVector(10);
+		*v[1] = 100;
+		v[3].fail() = "three";
+		BOOST_CHECK_EQUAL(*v[1], 100);
+		BOOST_CHECK_EQUAL(v.failures()[1], "three");
+
+		Result<int, std::string> copied = v[1];
+		BOOST_CHECK_EQUAL(*copied, 100);
+	}
+
+	BOOST_AUTO_TEST_CASE(testCountFailed) {
+		const std::size_t n = 1000;
+		RV v = makeVector(n);
+		BOOST_CHECK_EQUAL(v.count_failed(), (n + 2) / 3);
+		BOOST_CHECK_EQUAL(v.count_succeeded(), n - (n + 2) / 3);
+
+		for(std::size_t first = 0; first < n; first += 37) {
+			for(std::size_t last = first; last <= n; last += 53) {
+				std::size_t expected = 0;
+				for(std::size_t i = first; i < last; ++i) expected += (i % 3 == 0);
+				BOOST_CHECK_EQUAL(v.count_failed(first, last), expected);
+			}
+		}
+		BOOST_CHECK_EQUAL(v.count_failed(0, n), v.count_failed());
+	}
+
+	BOOST_AUTO_TEST_CASE(testForEach) {
+		RV v = makeVector(100);
+		long sum = 0, expected = 0;
+		for(int i = 0; i < 100; ++i) if(i % 3 != 0) expected += i;
+		v.for_each_success([&](int x) { sum += x; });
+		BOOST_CHECK_EQUAL(sum, expected);
+
+		v.for_each_success([](int &x) { x *= 2; });
+		BOOST_CHECK_EQUAL(*v[2], 4);
+
+		std::size_t failures = 0;
+		const RV &cv = v;
+		cv.for_each_failure([&](const std::string &) { ++failures; });
+		BOOST_CHECK_EQUAL(failures, v.count_failed());
+	}
+
+	BOOST_AUTO_TEST_CASE(testEmplace) {
+		ResultVector<std::string, int> v;
+		v.reserve(3, 1);
+		v.emplace_success(3, 'a');
+		v.emplace_failure(42);
+		v.push_back_success("b");
+		BOOST_CHECK_EQUAL(*v[0], "aaa");
+		BOOST_CHECK_EQUAL(v[1].fail(), 42);
+		BOOST_CHECK_EQUAL(*v[2], "b");
+
+		v.clear();
+		BOOST_CHECK(v.empty());
+		BOOST_CHECK_EQUAL(v.count_failed(), 0u);
+	}
+BOOST_AUTO_TEST_SUITE_END();
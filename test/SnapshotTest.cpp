@@ -0,0 +1,201 @@
+﻿#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <aslib/Snapshot.hpp>
+
+using aslib::DeepCopyPtr;
+using aslib::SnapshotObject;
+using aslib::SnapshotView;
+
+namespace {
+	// 書き出す多態型の木
+	struct Shape {
+		virtual ~Shape() {}
+		virtual double area() const = 0;
+	};
+	struct Circle : Shape {
+		Circle(double r) : r_(r) {}
+		virtual double area() const { return 3.0 * r_ * r_; }
+		double r_;
+	};
+	struct Group : Shape {
+		Group(const std::string &name) : name_(name) {}
+		virtual double area() const {
+			double sum = 0;
+			for(std::size_t i = 0; i < children_.size(); ++i) sum += children_[i]->area();
+			return sum;
+		}
+		std::string name_;
+		std::vector<DeepCopyPtr<Shape> > children_;
+		std::vector<std::int32_t> tags_;
+	};
+
+	// スナップショット内のイメージ
+	struct CircleImage {
+		static const std::uint32_t snapshotType = 1;
+		double r;
+	};
+	struct GroupImage {
+		static const std::uint32_t snapshotType = 2;
+		aslib::SnapshotString name;
+		aslib::SnapshotArray<aslib::SnapshotOffset<SnapshotObject> > children;
+		aslib::SnapshotArray<std::int32_t> tags;
+	};
+
+	// 多態型でないクラス
+	struct Point {
+		int x_, y_;
+	};
+	struct PointImage {
+		static const std::uint32_t snapshotType = 3;
+		std::int32_t x, y;
+	};
+
+	// 復元せずにイメージから面積を求める
+	double area(const SnapshotObject &object) {
+		if(const CircleImage *circle = object.as<CircleImage>()) return 3.0 * circle->r * circle->r;
+		const GroupImage *group = object.as<GroupImage>();
+		BOOST_REQUIRE(group);
+		double sum = 0;
+		for(const aslib::SnapshotOffset<SnapshotObject> &child : group->children) sum += area(*child);
+		return sum;
+	}
+
+	// 異なるアドレスでの読込を模す為に、8バイト境界に揃えた別の領域へコピーする
+	struct Copied {
+		explicit Copied(const std::vector<unsigned char> &src) : words_((src.size() + 7) / 8) { std::memcpy(words_.data(), src.data(), src.size()); }
+		const void *data() const { return words_.data(); }
+		std::vector<std::uint64_t> words_;
+	};
+}
+
+namespace aslib {
+	template<> struct SnapshotTraits<Circle> {
+		typedef CircleImage Image;
+		static void write(SnapshotWriter &, const Circle &circle, SnapshotSlot<Image> image) { image->r = circle.r_; }
+	};
+	template<> struct SnapshotTraits<Group> {
+		typedef GroupImage Image;
+		static void write(SnapshotWriter &writer, const Group &group, SnapshotSlot<Image> image) {
+			image.link(&Image::name, writer.writeString(group.name_), group.name_.size());
+			image.link(&Image::tags, writer.writeArray(group.tags_.data(), group.tags_.size()), group.tags_.size());
+
+			// 子を書き出す間にバッファが再確保されても、SnapshotSlotは有効
+			const SnapshotSlot<SnapshotOffset<SnapshotObject> > children = writer.allocateArray<SnapshotOffset<SnapshotObject> >(group.children_.size());
+			for(std::size_t i = 0; i < group.children_.size(); ++i) {
+				const SnapshotSlot<SnapshotObject> child = writer.write(group.children_[i]);
+				writer.link(children.at(i), child);
+			}
+			image.link(&Image::children, children, group.children_.size());
+		}
+	};
+	template<> struct SnapshotTraits<Point> {
+		typedef PointImage Image;
+		static void write(SnapshotWriter &, const Point &point, SnapshotSlot<Image> image) {
+			image->x = point.x_;
+			image->y = point.y_;
+		}
+	};
+}
+
+BOOST_AUTO_TEST_SUITE(SnapshotTest)
+
+BOOST_AUTO_TEST_CASE(testTree) {
+	Group *inner = new Group("inner");
+	inner->children_.push_back(DeepCopyPtr<Shape>(new Circle(1)));
+	inner->children_.push_back(DeepCopyPtr<Shape>(new Circle(2)));
+	Group *outer = new Group("outer");
+	outer->tags_.push_back(7);
+	outer->tags_.push_back(-1);
+	outer->children_.push_back(DeepCopyPtr<Shape>(inner));
+	outer->children_.push_back(DeepCopyPtr<Shape>(new Circle(3)));
+	const DeepCopyPtr<Shape> root(outer);
+
+	aslib::SnapshotWriter writer;
+	writer.registerType<Circle>();
+	writer.registerType<Group>();
+	const std::vector<unsigned char> bytes = writer.finish(writer.write(root));
+
+	const Copied copied(bytes);
+	aslib::Result<SnapshotView, aslib::Error> view = SnapshotView::open(copied.data(), bytes.size());
+	BOOST_REQUIRE(static_cast<bool>(view));
+	const SnapshotObject &object = view->root<SnapshotObject>();
+	BOOST_CHECK_EQUAL(area(object), root->area());
+
+	const GroupImage *group = object.as<GroupImage>();
+	BOOST_REQUIRE(group);
+	BOOST_CHECK(object.as<CircleImage>() == nullptr);
+	BOOST_CHECK_EQUAL(std::string(group->name.data()), "outer");
+	BOOST_CHECK_EQUAL(group->name.size(), 5u);
+	BOOST_REQUIRE_EQUAL(group->tags.size(), 2u);
+	BOOST_CHECK_EQUAL(group->tags[0], 7);
+	BOOST_CHECK_EQUAL(group->tags[1], -1);
+	BOOST_REQUIRE_EQUAL(group->children.size(), 2u);
+	const GroupImage *innerImage = group->children[0]->as<GroupImage>();
+	BOOST_REQUIRE(innerImage);
+	BOOST_CHECK_EQUAL(std::string(innerImage->name.data()), "inner");
+	BOOST_CHECK(innerImage->tags.empty());
+	BOOST_CHECK(!innerImage->tags.data());
+	BOOST_CHECK(view->contains(innerImage, sizeof(GroupImage)));
+}
+
+BOOST_AUTO_TEST_CASE(testNonPolymorphic) {
+	aslib::SnapshotWriter writer;
+	const Point p = { 1, -2 };
+	const std::vector<unsigned char> bytes = writer.finish(writer.write(DeepCopyPtr<Point>(new Point(p))));
+
+	const Copied copied(bytes);
+	aslib::Result<SnapshotView, aslib::Error> view = SnapshotView::open(copied.data(), bytes.size());
+	BOOST_REQUIRE(static_cast<bool>(view));
+	const PointImage *image = view->root<SnapshotObject>().as<PointImage>();
+	BOOST_REQUIRE(image);
+	BOOST_CHECK_EQUAL(image->x, 1);
+	BOOST_CHECK_EQUAL(image->y, -2);
+}
+
+BOOST_AUTO_TEST_CASE(testReuseWriter) {
+	// finish()の後は、登録した型を保ったまま再び書き出せる
+	aslib::SnapshotWriter writer;
+	writer.registerType<Circle>();
+	const std::vector<unsigned char> first = writer.finish(writer.write(DeepCopyPtr<Shape>(new Circle(1))));
+	const std::vector<unsigned char> second = writer.finish(writer.write(DeepCopyPtr<Shape>(new Circle(1))));
+	BOOST_CHECK(first == second);
+}
+
+BOOST_AUTO_TEST_CASE(testUnregistered) {
+	aslib::SnapshotWriter writer;
+	writer.registerType<Circle>();
+	BOOST_CHECK_THROW(writer.write(DeepCopyPtr<Shape>(new Group("g"))), aslib::SnapshotWriter::UnregisteredType);
+}
+
+BOOST_AUTO_TEST_CASE(testOpenFailed) {
+	aslib::SnapshotWriter writer;
+	const std::vector<unsigned char> bytes = writer.finish(writer.write(Point()));
+
+	// 正しいスナップショットを書き換えて検証する
+	const auto openModified = [&](std::size_t offset, unsigned char value, std::size_t size) {
+		Copied copied(bytes);
+		reinterpret_cast<unsigned char *>(copied.words_.data())[offset] = value;
+		aslib::Result<SnapshotView, aslib::Error> view = SnapshotView::open(copied.data(), size);
+		BOOST_REQUIRE(!view);
+		BOOST_CHECK(view.fail().category() == &aslib::snapshotErrorCategory());
+		return view.fail().code();
+	};
+	BOOST_CHECK_EQUAL(openModified(0, 'X', bytes.size()), aslib::snapshotBadMagic);
+	BOOST_CHECK_EQUAL(openModified(4, 99, bytes.size()), aslib::snapshotUnsupportedVersion);
+	BOOST_CHECK_EQUAL(openModified(8, 0xff, bytes.size()), aslib::snapshotByteOrderMismatch);
+	BOOST_CHECK_EQUAL(openModified(0, 'A', bytes.size() - 1), aslib::snapshotTruncated);
+	BOOST_CHECK_EQUAL(openModified(0, 'A', sizeof(aslib::SnapshotHeader) - 1), aslib::snapshotTruncated);
+	BOOST_CHECK_EQUAL(openModified(offsetof(aslib::SnapshotHeader, root), 0, bytes.size()), aslib::snapshotBadLayout);
+
+	const Copied copied(bytes);
+	BOOST_CHECK_EQUAL(SnapshotView::open(static_cast<const char *>(copied.data()) + 1, bytes.size()).fail().code(), aslib::snapshotBadLayout);
+	BOOST_CHECK(!aslib::snapshotErrorCategory().message(aslib::snapshotTruncated).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
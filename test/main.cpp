@@ -1,14 +1,11 @@
 ﻿#include <iostream>
 #include <string>
-#include <strstream>
-#include <typeinfo>
-
-std::ostream &operator<<(std::ostream &stream, const std::type_info &type) { return stream << type.name(); }
+#include <sstream>
 
 #define  BOOST_TEST_MAIN
 #include <boost/test/unit_test.hpp>
 
-#ifdef WIN32
+#ifdef _WIN32
 #	include <windows.h>
 #endif
 
@@ -31,7 +28,7 @@ struct GlobalConfiguration {
 
 	static
 	void print4Debugger(const std::string &str) {
-#if WIN32
+#ifdef _WIN32
 		::OutputDebugStringA(str.c_str());
 #else
 		std::cout << str << std::endl;
@@ -41,7 +38,7 @@ struct GlobalConfiguration {
 	static
 	bool isDebuggerPresent() {
 		return
-#if WIN32
+#ifdef _WIN32
 			::IsDebuggerPresent() == TRUE;
 #else
 			false;